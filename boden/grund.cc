@@ -32,6 +32,7 @@
 #include "../dataobj/loadsave.h"
 #include "../dataobj/translator.h"
 #include "../dataobj/environment.h"
+#include "../dataobj/private_car_routes.h"
 
 #include "../obj/baum.h"
 #include "../obj/bruecke.h"
@@ -2564,6 +2565,7 @@ public:
 	virtual ribi_t::ribi get_ribi(const grund_t* gr) const { return other->get_ribi(gr); }
 	virtual waytype_t get_waytype() const { return other->get_waytype(); }
 	virtual int get_cost(const grund_t *gr, const sint32 c, koord p) { return other->get_cost(gr,c,p); }
+	virtual uint32 get_min_cost() const { return other->get_min_cost(); }
 	virtual bool  is_target(const grund_t *gr,const grund_t *gr2) { return other-> is_target(gr,gr2); }
 };
 
@@ -2877,21 +2879,14 @@ const way_desc_t* grund_t::get_default_road(weg_t* w) const
 
 		// Check for connected road routes
 		bool city_destinations = false;
-		for (uint8 i = 0; i < 5; i++)
+		vector_tpl<koord> destinations;
+		private_car_routes_t::get_destinations(w, destinations);
+		FOR(vector_tpl<koord>, const dest, destinations)
 		{
-			for (uint32 j = 0; j < w->private_car_routes[w->private_car_routes_currently_reading_element][i].get_count(); j++)
-			{
-				const koord dest = w->private_car_routes[w->private_car_routes_currently_reading_element][i][j];
-
-				const stadt_t* city = welt->get_city(dest);
-				if (city && dest == city->get_townhall_road())
-				{
-					city_destinations = true;
-					break;
-				}
-			}
-			if (city_destinations)
+			const stadt_t* city = welt->get_city(dest);
+			if (city && dest == city->get_townhall_road())
 			{
+				city_destinations = true;
 				break;
 			}
 		}
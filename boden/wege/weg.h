@@ -96,6 +96,22 @@ public:
 	static uint32 get_all_ways_count();
 	static void clear_list_of__ways();
 
+	/**
+	* Counter which changes whenever a way of this waytype is removed or its
+	* direction bits (ribi) are changed, i.e. whenever the network may have changed.
+	*/
+	static uint32 get_network_generation(waytype_t wt) { return wt >= 0  &&  wt <= narrowgauge_wt ? network_generation[wt] : 0; }
+
+	/**
+	* Counter which changes whenever anything changes that the routes of vehicles
+	* on ways of this waytype may depend on, apart from the traffic: the network,
+	* way speeds, weight limits, constraints, electrification, signs and access rights.
+	*/
+	static uint32 get_route_generation(waytype_t wt) { return wt >= 0  &&  wt <= narrowgauge_wt ? route_generation[wt] : 0; }
+
+	// for changes which affect the routes on all ways, e.g. of the access rights of players
+	static void invalidate_all_routes();
+
 	enum {
 		HAS_SIDEWALK   = 1 << 0,
 		IS_ELECTRIFIED = 1 << 1,
@@ -124,6 +140,12 @@ public:
 	static void clear_travel_time_updates();
 
 private:
+	static uint32 network_generation[narrowgauge_wt + 1];
+	static uint32 route_generation[narrowgauge_wt + 1];
+
+	inline void routes_changed() { if(  wtyp >= 0  &&  wtyp <= narrowgauge_wt  ) { route_generation[wtyp]++; } }
+	inline void network_changed() { if(  wtyp >= 0  &&  wtyp <= narrowgauge_wt  ) { network_generation[wtyp]++; route_generation[wtyp]++; } }
+
 	/**
 	* array for statistical values
 	* MAX_WAY_STAT_MONTHS: [0] = actual value; [1] = last month value
@@ -202,6 +224,9 @@ private:
 	 */
 	uint32 remaining_wear_capacity;
 
+	// The number of this road in the private car routes, see private_car_routes_t
+	uint16 private_car_route_id;
+
 	/*
 	* If this flag is true, players may not delete this way even if it is unowned unless they
 	* build a diversionary route. Makes the way usable by all players regardless of ownership
@@ -250,112 +275,15 @@ public:
 	minivec_tpl<gebaeude_t*> connected_buildings;
 
 	/**
-	 * Map of all private car routes from way
+	 * Private car routes through this road (see private_car_routes_t)
 	 */
-	class private_car_route_map{
-	public:
-		void set_route_map_elem(uint8 elem){route_map_elem=elem;}
-
-		private_car_route_map(){link_mode=link_mode_NULL;}
-
-		void clear();
-
-		void pre_reset();
-
-		bool contains(koord elem) const;
-		bool insert_unique(koord elem, private_car_route_map* link_to = NULL, uint8 link_dir=0);
-
-		koord& get_by_index(uint32_t i);
-		const koord& get_by_index(uint32_t i) const;
-
-		koord& operator [] (uint32 i);
-		const koord& operator [] (uint32 i) const ;
-
-		uint32 get_count() const ;
-		bool is_empty() const ;
-
-		bool remove(koord elem);
-		void resize(uint32 new_size);
-
-		static void reset(uint8 map_elem);
-
-		//backwards compatible saving
-		void rdwr(loadsave_t *file);
-
-	private:
-		union {
-			uint32 idx;
-			koord single_koord;
-		};
-		uint8 link_mode:3;
-		uint8 route_map_elem:1;
-		enum link_modes {
-			link_mode_NULL=7,
-			link_mode_single=6,
-			link_mode_master=5
-		};
-
-		static vector_tpl<ordered_vector_tpl<koord,uint32> > route_maps[2];
-public:
-
-		inline sint32 get_idx() const {if(link_mode==link_mode_NULL || link_mode==link_mode_single) return -1; return idx;}
-
-#ifdef MULTI_THREAD
-		static pthread_mutex_t route_map_mtx;
-#endif
-
-
-		inline static void route_map_lock() {
-#ifdef MULTI_THREAD
-			int error = pthread_mutex_lock(&route_map_mtx);
-			assert(error == 0);
-			(void)error;
-#endif
-			return;
-		}
-
-		inline static void route_map_unlock() {
-#ifdef MULTI_THREAD
-			int error = pthread_mutex_unlock(&route_map_mtx);
-			assert(error == 0);
-			(void)error;
-#endif
-			return;
-		}
-	};
-
-
-
-	// Likewise, out of caution, put this here for the same reason.
-	// n_bags must be fairly low as there are 2 maps per way and usually zero elements per way, up to ~150 in high cases and ~1500 in highest cases
-	//typedef ordered_vector_tpl<koord, uint32> private_car_route_map;
-	//typedef std::unordered_map<koord, koord3d> private_car_route_map_2;
-	private_car_route_map private_car_routes[2][5];
-	//private_car_route_map_2 private_car_routes_std[2];
-	static uint32 private_car_routes_currently_reading_element;
-	static uint32 get_private_car_routes_currently_writing_element() { return private_car_routes_currently_reading_element == 1 ? 0 : 1; }
-
-	static void private_car_backtrace_begin();
-	static void private_car_backtrace_end();
 	void private_car_backtrace_add(koord destination, koord3d next_tile);
-	void private_car_backtrace_inc(koord3d next_tile);
 
-	static private_car_route_map* private_car_backtrace_last_route_map;
-	static uint8 private_car_backtrace_last_idx;
-
-	void add_private_car_route(koord dest, koord3d next_tile);
 	bool has_private_car_route(koord dest) const;
 	koord3d get_next_on_private_car_route_to(koord dest, bool reading_set=true, uint8 start_dir=0) const;
-private:
-	/// Set the boolean value to true to modify the set currently used for reading (this must ONLY be done when this is called from a single threaded part of the code).
-	void remove_private_car_route(koord dest, bool reading_set = false);
-public:
-	static void swap_private_car_routes_currently_reading_element() { private_car_routes_currently_reading_element = private_car_routes_currently_reading_element == 0 ? 1 : 0; }
 
-	/// Delete all private car routes originating from or passing through this tile.
-	/// Set the boolean value to true to modify the set currently used for reading (this must ONLY be done when this is called from a single threaded part of the code).
-	void delete_all_routes_from_here(bool reading_set = false);
-	void delete_route_to(koord destination, bool reading_set = false);
+	uint16 get_private_car_route_id() const { return private_car_route_id; }
+	void set_private_car_route_id(uint16 id) { private_car_route_id = id; }
 
 
 
@@ -377,15 +305,15 @@ public:
 	 */
 	bool check_season(const bool calc_only_season_change) OVERRIDE;
 
-	void set_max_speed(sint32 s) { max_speed = s; }
+	void set_max_speed(sint32 s) { if(  max_speed != s  ) { max_speed = s; routes_changed(); } }
 
-	void set_max_axle_load(uint32 w) { max_axle_load = w; }
-	void set_bridge_weight_limit(uint32 value) { bridge_weight_limit = value; }
+	void set_max_axle_load(uint32 w) { if(  max_axle_load != w  ) { max_axle_load = w; routes_changed(); } }
+	void set_bridge_weight_limit(uint32 value) { if(  bridge_weight_limit != value  ) { bridge_weight_limit = value; routes_changed(); } }
 
 	// Resets constraints to their base values. Used when removing way objects.
-	void reset_way_constraints() { way_constraints = desc->get_way_constraints(); }
+	void reset_way_constraints() { way_constraints = desc->get_way_constraints(); routes_changed(); }
 
-	void clear_way_constraints() { way_constraints.set_permissive(0); way_constraints.set_prohibitive(0); }
+	void clear_way_constraints() { way_constraints.set_permissive(0); way_constraints.set_prohibitive(0); routes_changed(); }
 
 	/* Way constraints: determines whether vehicles
 	 * can travel on this way. This method decodes
@@ -396,8 +324,8 @@ public:
 	 * */
 
 	const way_constraints_of_way_t& get_way_constraints() const { return way_constraints; }
-	void add_way_constraints(const way_constraints_of_way_t& value) { way_constraints.add(value); }
-	void remove_way_constraints(const way_constraints_of_way_t& value) { way_constraints.remove(value); }
+	void add_way_constraints(const way_constraints_of_way_t& value) { way_constraints.add(value); routes_changed(); }
+	void remove_way_constraints(const way_constraints_of_way_t& value) { way_constraints.remove(value); routes_changed(); }
 
 	// Convoys that do not require electrification can ignore speed limit by electrification
 	sint32 get_max_speed(bool needs_electrification = false) const;
@@ -448,7 +376,13 @@ public:
 	* @note After changing of ribi the image of the way is wrong. To correct this,
 	* grund_t::calc_image needs to be called. This is not done here (Too expensive).
 	*/
-	void ribi_add(ribi_t::ribi ribi) { this->ribi |= (uint8)ribi;}
+	void ribi_add(ribi_t::ribi ribi)
+	{
+		if(  (this->ribi | ribi) != this->ribi  ) {
+			this->ribi |= (uint8)ribi;
+			network_changed();
+		}
+	}
 
 	/**
 	* Remove direction bits (ribi) for a way.
@@ -456,7 +390,13 @@ public:
 	* @note After changing of ribi the image of the way is wrong. To correct this,
 	* grund_t::calc_image needs to be called. This is not done here (Too expensive).
 	*/
-	void ribi_rem(ribi_t::ribi ribi) { this->ribi &= (uint8)~ribi;}
+	void ribi_rem(ribi_t::ribi ribi)
+	{
+		if(  (this->ribi & ribi) != 0  ) {
+			this->ribi &= (uint8)~ribi;
+			network_changed();
+		}
+	}
 
 	/**
 	* Set direction bits (ribi) for the way.
@@ -464,7 +404,13 @@ public:
 	* @note After changing of ribi the image of the way is wrong. To correct this,
 	* grund_t::calc_image needs to be called. This is not done here (Too expensive).
 	*/
-	void set_ribi(ribi_t::ribi ribi) { this->ribi = (uint8)ribi;}
+	void set_ribi(ribi_t::ribi ribi)
+	{
+		if(  this->ribi != (uint8)ribi  ) {
+			this->ribi = (uint8)ribi;
+			network_changed();
+		}
+	}
 
 	/**
 	* Get the unmasked direction bits (ribi) for the way (without signals or other ribi changer).
@@ -480,7 +426,7 @@ public:
 	* For signals it is necessary to mask out certain ribi to prevent vehicles
 	* from driving the wrong way (e.g. oneway roads)
 	*/
-	void set_ribi_maske(ribi_t::ribi ribi) { ribi_maske = (uint8)ribi; }
+	void set_ribi_maske(ribi_t::ribi ribi) { if(  ribi_maske != (uint8)ribi  ) { ribi_maske = (uint8)ribi; routes_changed(); } }
 	ribi_t::ribi get_ribi_maske() const { return (ribi_t::ribi)ribi_maske; }
 
 	/**
@@ -514,7 +460,7 @@ public:
 	void set_gehweg(const bool yesno) { flags = (yesno ? flags | HAS_SIDEWALK : flags & ~HAS_SIDEWALK); }
 	inline bool hat_gehweg() const { return flags & HAS_SIDEWALK; }
 
-	void set_electrify(bool janein) {janein ? flags |= IS_ELECTRIFIED : flags &= ~IS_ELECTRIFIED;}
+	void set_electrify(bool janein) {janein ? flags |= IS_ELECTRIFIED : flags &= ~IS_ELECTRIFIED; routes_changed();}
 	inline bool is_electrified() const {return flags&IS_ELECTRIFIED; }
 
 	inline bool has_sign() const {return flags&HAS_SIGN; }
@@ -531,7 +477,7 @@ public:
 	 * Clear the has-sign flag when roadsign or signal got deleted.
 	 * As there is only one of signal or roadsign on the way we can safely clear both flags.
 	 */
-	void clear_sign_flag() { flags &= ~(HAS_SIGN | HAS_SIGNAL); }
+	void clear_sign_flag() { flags &= ~(HAS_SIGN | HAS_SIGNAL); routes_changed(); }
 
 	inline void set_image( image_id b ) { image = b; }
 	image_id get_image() const OVERRIDE {return image;}
@@ -547,7 +493,10 @@ public:
 	bool should_city_adopt_this(const player_t* player);
 
 	bool is_public_right_of_way() const { return public_right_of_way; }
-	void set_public_right_of_way(bool arg=true) { public_right_of_way = arg; }
+	void set_public_right_of_way(bool arg=true) { public_right_of_way = arg; routes_changed(); }
+
+	// the access rights of the routes depend on the owner
+	void set_owner(player_t *player) { obj_t::set_owner(player); routes_changed(); }
 
 	bool is_degraded() const { return degraded; }
 
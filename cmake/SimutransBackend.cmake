@@ -15,6 +15,9 @@ endif ()
 
 list(APPEND AVAILABLE_BACKENDS "none")
 
+# draws into memory without a window, e.g. for the render benchmark
+list(APPEND AVAILABLE_BACKENDS "offscreen")
+
 string(REGEX MATCH "^[^;][^;]*" FIRST_BACKEND "${AVAILABLE_BACKENDS}")
 set(SIMUTRANS_BACKEND "${FIRST_BACKEND}" CACHE STRING "Graphics backend")
 set_property(CACHE SIMUTRANS_BACKEND PROPERTY STRINGS ${AVAILABLE_BACKENDS})
@@ -29,6 +29,7 @@ target_sources(simutrans-extended PRIVATE
 	dataobj/environment.cc
 	dataobj/freelist.cc
 	dataobj/gameinfo.cc
+	dataobj/halt_grid.cc
 	dataobj/height_map_loader.cc
 	dataobj/koord3d.cc
 	dataobj/koord.cc
@@ -37,10 +38,13 @@ target_sources(simutrans-extended PRIVATE
 	dataobj/marker.cc
 	dataobj/objlist.cc
 	dataobj/powernet.cc
+	dataobj/private_car_routes.cc
 	dataobj/rect.cc
 	dataobj/replace_data.cc
 	dataobj/ribi.cc
 	dataobj/route.cc
+	dataobj/route_cache.cc
+	dataobj/route_landmarks.cc
 	dataobj/scenario.cc
 	dataobj/schedule.cc
 	dataobj/settings.cc
@@ -86,6 +90,7 @@ target_sources(simutrans-extended PRIVATE
 	descriptor/vehicle_desc.cc
 	descriptor/way_desc.cc
 	display/font.cc
+	display/render_benchmark.cc
 	display/simview.cc
 	display/viewport.cc
 	finder/placefinder.cc
@@ -364,6 +369,7 @@ target_sources(simutrans-extended PRIVATE
 	utils/simthread.cc
 	vehicle/movingobj.cc
 	vehicle/pedestrian.cc
+	vehicle/road_user_flow.cc
 	vehicle/simroadtraffic.cc
 	vehicle/vehicle.cc
 	vehicle/air_vehicle.cc
@@ -28,6 +28,8 @@ env_t::height_conversion_mode env_t::height_conv_mode = env_t::HEIGHT_CONV_LINEA
 
 bool env_t::simple_drawing = false;
 bool env_t::simple_drawing_fast_forward = true;
+bool env_t::aggregate_off_screen_road_users = false;
+uint32 env_t::image_cache_size = 256;
 sint16 env_t::simple_drawing_normal = 4;
 sint16 env_t::simple_drawing_default = 24;
 uint8 env_t::follow_convoi_underground = 2;
@@ -61,6 +63,7 @@ std::string env_t::server_admin_pw;
 std::string env_t::server_motd_filename;
 vector_tpl<std::string> env_t::listen;
 bool env_t::server_save_game_on_quit = false;
+bool env_t::background_save = false;
 bool env_t::reload_and_save_on_quit = true;
 uint8 env_t::network_heavy_mode = 0;
 
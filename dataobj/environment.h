@@ -393,6 +393,12 @@ public:
 	/// always use fast drawing in fast forward
 	static bool simple_drawing_fast_forward;
 
+	/// in single player games, keep private cars and pedestrians far from the viewport as flows per road tile
+	static bool aggregate_off_screen_road_users;
+
+	/// memory (in MB) for the player coloured and day/night recoded images; the least recently drawn are freed beyond it (0 = no limit)
+	static uint32 image_cache_size;
+
 	/// format in which date is shown
 	enum date_fmt {
 		DATE_FMT_SEASON             = 0,
@@ -481,6 +487,9 @@ public:
 	/// do autosave every month?
 	static sint32 autosave;
 
+	/// if true (and supported) autosaves are written by a forked copy of the game, while the game continues
+	static bool background_save;
+
 
 	/**
 	 * @name Midi/sound options
@@ -0,0 +1,162 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "halt_grid.h"
+
+#include "../simhalt.h"
+#include "../simplan.h"
+#include "../simworld.h"
+#include "../boden/grund.h"
+#include "../tpl/vector_tpl.h"
+
+
+namespace
+{
+	struct halt_tile_t
+	{
+		halthandle_t halt;
+		koord pos;
+	};
+
+	std::unordered_map<uint32, vector_tpl<halt_tile_t> > cells;
+
+	inline uint32 cell_key(sint16 cell_x, sint16 cell_y)
+	{
+		return ((uint32)(uint16)cell_x << 16) | (uint16)cell_y;
+	}
+
+	/// the largest coverage of a halt tile, so each cell knows all halts which can reach it
+	inline sint16 get_index_radius()
+	{
+		const settings_t &settings = world()->get_settings();
+		return max(settings.get_station_coverage(), settings.get_station_coverage_factories());
+	}
+
+	bool is_closer(const nearby_halt_t &a, const nearby_halt_t &b)
+	{
+		if(  a.distance != b.distance  ) {
+			return a.distance < b.distance;
+		}
+		const koord pos_a = a.halt->get_basis_pos();
+		const koord pos_b = b.halt->get_basis_pos();
+		return pos_a.y < pos_b.y  ||  (pos_a.y == pos_b.y  &&  pos_a.x < pos_b.x);
+	}
+}
+
+
+void halt_grid_t::add_tile(halthandle_t halt, koord pos)
+{
+	halt_tile_t tile;
+	tile.halt = halt;
+	tile.pos = pos;
+
+	const sint16 radius = get_index_radius();
+	for(  sint16 cell_y = (pos.y - radius) >> cell_shift;  cell_y <= (pos.y + radius) >> cell_shift;  cell_y++  ) {
+		for(  sint16 cell_x = (pos.x - radius) >> cell_shift;  cell_x <= (pos.x + radius) >> cell_shift;  cell_x++  ) {
+			cells[cell_key(cell_x, cell_y)].append(tile);
+		}
+	}
+}
+
+
+void halt_grid_t::remove_tile(halthandle_t halt, koord pos)
+{
+	const sint16 radius = get_index_radius();
+	for(  sint16 cell_y = (pos.y - radius) >> cell_shift;  cell_y <= (pos.y + radius) >> cell_shift;  cell_y++  ) {
+		for(  sint16 cell_x = (pos.x - radius) >> cell_shift;  cell_x <= (pos.x + radius) >> cell_shift;  cell_x++  ) {
+			std::unordered_map<uint32, vector_tpl<halt_tile_t> >::iterator iter = cells.find(cell_key(cell_x, cell_y));
+			if(  iter == cells.end()  ) {
+				continue;
+			}
+			vector_tpl<halt_tile_t> &tiles = iter->second;
+			for(  uint32 i = 0;  i < tiles.get_count();  i++  ) {
+				if(  tiles[i].halt == halt  &&  tiles[i].pos == pos  ) {
+					tiles.remove_at(i, false);
+					break;
+				}
+			}
+			if(  tiles.empty()  ) {
+				cells.erase(iter);
+			}
+		}
+	}
+}
+
+
+uint16 halt_grid_t::get_coverage(halthandle_t halt)
+{
+	const settings_t &settings = world()->get_settings();
+	if(  halt->get_pax_enabled()  ||  halt->get_mail_enabled()  ) {
+		return settings.get_station_coverage();
+	}
+	return halt->get_ware_enabled() ? settings.get_station_coverage_factories() : 0;
+}
+
+
+void halt_grid_t::get_halts_covering(const vector_tpl<koord> &tiles, vector_tpl<nearby_halt_t> &halts)
+{
+	halts.clear();
+
+	// the halts seen, whether they cover one of the tiles or not, with their closest distance
+	vector_tpl<nearby_halt_t> seen;
+	vector_tpl<bool> covering;
+
+	FOR(vector_tpl<koord>, const pos, tiles) {
+		std::unordered_map<uint32, vector_tpl<halt_tile_t> >::const_iterator iter = cells.find(cell_key(pos.x >> cell_shift, pos.y >> cell_shift));
+		if(  iter == cells.end()  ) {
+			continue;
+		}
+		FOR(vector_tpl<halt_tile_t>, const &tile, iter->second) {
+			const uint32 distance = koord_distance(tile.pos, pos);
+			// the coverage is square
+			const bool covers = max(abs(tile.pos.x - pos.x), abs(tile.pos.y - pos.y)) <= get_coverage(tile.halt);
+			uint32 i = 0;
+			while(  i < seen.get_count()  &&  seen[i].halt != tile.halt  ) {
+				i++;
+			}
+			if(  i == seen.get_count()  ) {
+				nearby_halt_t nearby;
+				nearby.halt = tile.halt;
+				nearby.distance = (uint8)min(distance, 255);
+				seen.append(nearby);
+				covering.append(covers);
+				continue;
+			}
+			if(  distance < seen[i].distance  ) {
+				seen[i].distance = (uint8)distance;
+			}
+			if(  covers  ) {
+				covering[i] = true;
+			}
+		}
+	}
+
+	for(  uint32 i = 0;  i < seen.get_count();  i++  ) {
+		if(  covering[i]  ) {
+			halts.append(seen[i]);
+		}
+	}
+	std::sort(halts.begin(), halts.end(), is_closer);
+}
+
+
+void halt_grid_t::clear()
+{
+	cells.clear();
+}
+
+
+void halt_grid_t::rebuild()
+{
+	cells.clear();
+	FOR(vector_tpl<halthandle_t>, const halt, haltestelle_t::get_alle_haltestellen()) {
+		FOR(slist_tpl<haltestelle_t::tile_t>, const &tile, halt->get_tiles()) {
+			add_tile(halt, tile.grund->get_pos().get_2d());
+		}
+	}
+}
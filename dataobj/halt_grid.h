@@ -0,0 +1,57 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef DATAOBJ_HALT_GRID_H
+#define DATAOBJ_HALT_GRID_H
+
+
+#include "../simtypes.h"
+#include "../halthandle_t.h"
+#include "koord.h"
+
+template <class T> class vector_tpl;
+struct nearby_halt_t;
+
+
+/**
+ * A spatial index of the halts: the map is divided into cells of
+ * cell_size x cell_size tiles, and each cell lists the halt tiles whose
+ * coverage reaches into it. Which halts cover a position is then answered
+ * from the one cell of the position, without looking at the halt lists of
+ * all the tiles in between or at all the tiles of the halts.
+ */
+class halt_grid_t
+{
+public:
+	static const sint16 cell_shift = 4;
+	static const sint16 cell_size = 1 << cell_shift;
+
+	/// Called when @p halt got a tile at @p pos.
+	static void add_tile(halthandle_t halt, koord pos);
+
+	/// Called when @p halt lost its tile at @p pos.
+	static void remove_tile(halthandle_t halt, koord pos);
+
+	/**
+	 * Collect the halts whose coverage reaches one of @p tiles in @p halts,
+	 * as the halt lists of the tiles would have them: the coverage is a square
+	 * of the station coverage around each halt tile (of the factory coverage
+	 * for halts only handling freight), and each halt comes with the
+	 * koord_distance of its closest tile. The list is sorted by the distance
+	 * and then by the position of the halts, so it does not depend on the
+	 * order in which the halts were built.
+	 */
+	static void get_halts_covering(const vector_tpl<koord> &tiles, vector_tpl<nearby_halt_t> &halts);
+
+	/// The coverage radius of @p halt, as used for the halt lists of the tiles.
+	static uint16 get_coverage(halthandle_t halt);
+
+	static void clear();
+
+	/// Index all halts again, e.g. after the map was rotated.
+	static void rebuild();
+};
+
+#endif
@@ -4,6 +4,7 @@
  */
 
 #include "../simdebug.h"
+#include "../macros.h"
 #include "powernet.h"
 
 #ifdef MULTI_THREAD
@@ -31,7 +32,9 @@ void powernet_t::new_world()
 void powernet_t::step_all(uint32 delta_t)
 {
 	FOR(slist_tpl<powernet_t*>, const p, powernet_list) {
-		p->step(delta_t);
+		if(  p->parent == NULL  ) {
+			p->step(delta_t);
+		}
 	}
 }
 
@@ -50,6 +53,10 @@ powernet_t::powernet_t()
 	next_supply = 0;
 	this_demand = 0;
 	next_demand = 0;
+
+	parent = NULL;
+	rank = 0;
+	references = 0;
 }
 
 
@@ -65,6 +72,85 @@ powernet_t::~powernet_t()
 }
 
 
+powernet_t *powernet_t::get_root() const
+{
+	const powernet_t *net = this;
+	while(  net->parent  ) {
+		net = net->parent;
+	}
+	return const_cast<powernet_t *>(net);
+}
+
+
+powernet_t *powernet_t::find_root()
+{
+	powernet_t *root = get_root();
+
+	// path compression
+	powernet_t *net = this;
+	while(  net->parent  &&  net->parent != root  ) {
+		powernet_t *next = net->parent;
+		net->parent = root;
+		root->references++;
+		next->references--;
+		if(  net != this  &&  net->references == 0  ) {
+			root->references--;
+			delete net;
+		}
+		net = next;
+	}
+	if(  net != this  &&  net->references == 0  ) {
+		// the last one before the root
+		root->references--;
+		delete net;
+	}
+	return root;
+}
+
+
+powernet_t *powernet_t::merge(powernet_t *a, powernet_t *b)
+{
+	a = a->find_root();
+	b = b->find_root();
+	if(  a == b  ) {
+		return a;
+	}
+	// union by rank
+	if(  a->rank < b->rank  ) {
+		sim::swap(a, b);
+	}
+	else if(  a->rank == b->rank  ) {
+		a->rank++;
+	}
+	b->parent = a;
+	a->references++;
+
+	// the power already fed in for the next step
+	a->next_supply += b->next_supply;
+	if(  a->next_supply>max_capacity  ) {
+		a->next_supply = max_capacity;
+	}
+	a->next_demand += b->next_demand;
+	if(  a->next_demand>max_capacity  ) {
+		a->next_demand = max_capacity;
+	}
+	b->next_supply = 0;
+	b->next_demand = 0;
+	return a;
+}
+
+
+void powernet_t::release()
+{
+	powernet_t *net = this;
+	while(  net  &&  --net->references == 0  ) {
+		powernet_t *next = net->parent;
+		delete net;
+		net = next;
+	}
+}
+
+
 void powernet_t::step(uint32 delta_t)
 {
 	if(  delta_t==0  ) {
@@ -17,6 +17,11 @@
 /**
  * Data class for power networks. A two phase queue to store
  * and hand out power.
+ *
+ * Connected networks are merged as in a union-find structure: the smaller
+ * one is made a child of the other (see merge), and only the root of each
+ * tree is a network of its own (see get_root). A network is deleted when
+ * neither a powerline nor another network refers to it any more.
  */
 class powernet_t
 {
@@ -44,6 +49,15 @@ private:
 	/// Power demand in current step
 	uint64 this_demand;
 
+	/// The network this one was merged into, NULL for a root
+	powernet_t *parent;
+
+	/// upper bound of the height of the tree below this
+	uint8 rank;
+
+	/// number of powerlines and networks referring to this one
+	uint32 references;
+
 	// Just transfers power demand and supply to current step
 	void step(uint32 delta_t);
 
@@ -53,6 +67,29 @@ public:
 
 	uint64 get_max_capacity() const { return max_capacity; }
 
+	/**
+	 * @returns the network this one is part of.
+	 * Does not change anything, so this may be used by several threads at once.
+	 */
+	powernet_t *get_root() const;
+
+	/**
+	 * As get_root, but the networks on the way are linked to the root directly.
+	 * Must only be used where no other thread reads the networks.
+	 */
+	powernet_t *find_root();
+
+	/**
+	 * Join the networks of @p a and @p b.
+	 * @returns the root of the joint network.
+	 */
+	static powernet_t *merge(powernet_t *a, powernet_t *b);
+
+	void add_reference() { references++; }
+
+	/// Deletes this network (and parents no longer needed) if nothing refers to it any more.
+	void release();
+
 	/// add to power supply for next step, respect max_capacity
 	void add_supply(const uint32 p);
 
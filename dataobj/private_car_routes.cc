@@ -0,0 +1,374 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include <string.h>
+#include <unordered_map>
+
+#include "private_car_routes.h"
+
+#include "loadsave.h"
+#include "koord3d.h"
+#include "../simdebug.h"
+#include "../boden/wege/weg.h"
+#include "../tpl/vector_tpl.h"
+#include "../utils/simthread.h"
+
+
+uint32 private_car_routes_t::reading_table = 0;
+
+
+namespace
+{
+	// the directions of the roads of one sector to one destination, indexed by the number of the road
+	struct hop_page_t
+	{
+		uint8 *hops;
+		uint32 count;
+
+		hop_page_t(uint32 n) : hops(new uint8[n]), count(n) { memset(hops, 0, n); }
+		~hop_page_t() { delete [] hops; }
+
+		void grow(uint32 n)
+		{
+			uint8 *new_hops = new uint8[n];
+			memcpy(new_hops, hops, count);
+			memset(new_hops + count, 0, n - count);
+			delete [] hops;
+			hops = new_hops;
+			count = n;
+		}
+	};
+
+	// the pages, indexed by the destination and the sector (see page_key)
+	typedef std::unordered_map<uint64, hop_page_t *> hop_table_t;
+
+	hop_table_t hop_tables[2];
+
+	struct sector_t
+	{
+		uint16 next_id;
+		vector_tpl<uint16> free_ids;
+
+		sector_t() : next_id(0) {}
+	};
+
+	std::unordered_map<uint32, sector_t> sectors;
+
+	// Numbers of removed roads (see released_key), which may still be in one or both tables.
+	// They can be reused after both tables were emptied once.
+	vector_tpl<uint64> released_ids[2];
+
+	struct buffered_hop_t
+	{
+		weg_t *way;
+		koord destination;
+		uint8 direction;
+
+		buffered_hop_t() : way(NULL), direction(0) {}
+		buffered_hop_t(weg_t *w, koord d, uint8 dir) : way(w), destination(d), direction(dir) {}
+	};
+
+	vector_tpl<vector_tpl<buffered_hop_t> > thread_buffers;
+
+	// the buffer of the calling thread, NULL on the main thread
+	thread_local vector_tpl<buffered_hop_t> *current_buffer = NULL;
+
+	inline uint32 sector_key(const koord3d &pos)
+	{
+		return ((uint32)(uint16)(pos.x >> private_car_routes_t::sector_shift) << 16) | (uint16)(pos.y >> private_car_routes_t::sector_shift);
+	}
+
+	inline uint64 page_key(const koord destination, const uint32 sector)
+	{
+		return ((uint64)(uint16)destination.x << 48) | ((uint64)(uint16)destination.y << 32) | sector;
+	}
+
+	inline koord page_destination(const uint64 key)
+	{
+		return koord((sint16)(key >> 48), (sint16)(key >> 32));
+	}
+
+	inline uint64 released_key(const uint32 sector, const uint16 id)
+	{
+		return ((uint64)sector << 16) | id;
+	}
+
+	void clear_table(hop_table_t &table)
+	{
+		for(  hop_table_t::iterator iter = table.begin();  iter != table.end();  ++iter  ) {
+			delete iter->second;
+		}
+		table.clear();
+	}
+}
+
+
+void private_car_routes_t::init_thread_buffers(uint32 count)
+{
+	thread_buffers.clear();
+	thread_buffers.resize(count);
+	for(  uint32 i = 0;  i < count;  i++  ) {
+		thread_buffers.append(vector_tpl<buffered_hop_t>());
+	}
+}
+
+
+void private_car_routes_t::set_thread_buffer(uint32 thread_number)
+{
+	current_buffer = &thread_buffers[thread_number];
+}
+
+
+void private_car_routes_t::flush_thread_buffers()
+{
+	for(  uint32 i = 0;  i < thread_buffers.get_count();  i++  ) {
+		FOR(vector_tpl<buffered_hop_t>, const &hop, thread_buffers[i]) {
+			add_hop(hop.way, hop.destination, hop.direction);
+		}
+		thread_buffers[i].clear();
+	}
+}
+
+
+void private_car_routes_t::add_hop(weg_t *w, koord destination, uint8 direction)
+{
+	if(  current_buffer  ) {
+		current_buffer->append(buffered_hop_t(w, destination, direction));
+		return;
+	}
+
+	const uint32 sector = sector_key(w->get_pos());
+	uint16 id = w->get_private_car_route_id();
+	if(  id == no_id  ) {
+		// The road is numbered on its first route. Readers may see the number before any
+		// route of it is in the table they read, where a new number cannot be used yet.
+		sector_t &s = sectors[sector];
+		if(  !s.free_ids.empty()  ) {
+			id = s.free_ids.pop_back();
+		}
+		else if(  s.next_id < no_id  ) {
+			id = s.next_id++;
+		}
+		else {
+			// all numbers of this sector are used: no route through this road
+			return;
+		}
+		w->set_private_car_route_id(id);
+	}
+
+	hop_page_t *&page = hop_tables[reading_table == 0 ? 1 : 0][page_key(destination, sector)];
+	if(  page == NULL  ) {
+		page = new hop_page_t((id + 16u) & ~15u);
+	}
+	else if(  page->count <= id  ) {
+		page->grow((id + 16u) & ~15u);
+	}
+	page->hops[id] |= (uint8)(1 << direction);
+}
+
+
+uint8 private_car_routes_t::get_hops(const weg_t *w, koord destination, bool reading)
+{
+	const uint16 id = w->get_private_car_route_id();
+	if(  id == no_id  ) {
+		return 0;
+	}
+	const hop_table_t &table = hop_tables[reading ? reading_table : (reading_table == 0 ? 1 : 0)];
+	hop_table_t::const_iterator iter = table.find(page_key(destination, sector_key(w->get_pos())));
+	if(  iter == table.end()  ||  iter->second->count <= id  ) {
+		return 0;
+	}
+	return iter->second->hops[id];
+}
+
+
+void private_car_routes_t::get_destinations(const weg_t *w, vector_tpl<koord> &destinations)
+{
+	const uint16 id = w->get_private_car_route_id();
+	if(  id == no_id  ) {
+		return;
+	}
+	const uint32 sector = sector_key(w->get_pos());
+	const hop_table_t &table = hop_tables[reading_table];
+	for(  hop_table_t::const_iterator iter = table.begin();  iter != table.end();  ++iter  ) {
+		if(  (uint32)iter->first == sector  &&  iter->second->count > id  &&  iter->second->hops[id] != 0  ) {
+			destinations.append(page_destination(iter->first));
+		}
+	}
+}
+
+
+void private_car_routes_t::remove_way(weg_t *w)
+{
+	const uint16 id = w->get_private_car_route_id();
+	if(  id != no_id  ) {
+		released_ids[0].append(released_key(sector_key(w->get_pos()), id));
+		w->set_private_car_route_id(no_id);
+	}
+}
+
+
+void private_car_routes_t::clear_writing_table()
+{
+	clear_table(hop_tables[reading_table == 0 ? 1 : 0]);
+
+	// The numbers released before the last time are now in neither table.
+	FOR(vector_tpl<uint64>, const released, released_ids[1]) {
+		sectors[(uint32)(released >> 16)].free_ids.append((uint16)released);
+	}
+	released_ids[1].clear();
+	swap(released_ids[0], released_ids[1]);
+}
+
+
+void private_car_routes_t::clear_all()
+{
+	clear_table(hop_tables[0]);
+	clear_table(hop_tables[1]);
+	sectors.clear();
+	released_ids[0].clear();
+	released_ids[1].clear();
+	reading_table = 0;
+	for(  uint32 i = 0;  i < thread_buffers.get_count();  i++  ) {
+		thread_buffers[i].clear();
+	}
+
+	FOR(vector_tpl<weg_t *>, const w, weg_t::get_alle_wege()) {
+		w->set_private_car_route_id(no_id);
+	}
+}
+
+
+void private_car_routes_t::rdwr(loadsave_t *file)
+{
+	xml_tag_t t( file, "private_car_routes_t" );
+
+	for(  uint8 i = 0;  i < 2;  i++  ) {
+		hop_table_t &table = hop_tables[i];
+		uint32 count = table.size();
+		file->rdwr_long(count);
+		if(  file->is_saving()  ) {
+			for(  hop_table_t::const_iterator iter = table.begin();  iter != table.end();  ++iter  ) {
+				koord destination = page_destination(iter->first);
+				destination.rdwr(file);
+				uint32 sector = (uint32)iter->first;
+				file->rdwr_long(sector);
+				uint32 hop_count = iter->second->count;
+				file->rdwr_long(hop_count);
+				for(  uint32 j = 0;  j < hop_count;  j++  ) {
+					file->rdwr_byte(iter->second->hops[j]);
+				}
+			}
+		}
+		else {
+			clear_table(table);
+			for(  uint32 k = 0;  k < count;  k++  ) {
+				koord destination;
+				destination.rdwr(file);
+				uint32 sector = 0;
+				file->rdwr_long(sector);
+				uint32 hop_count = 0;
+				file->rdwr_long(hop_count);
+				hop_page_t *page = new hop_page_t(hop_count);
+				for(  uint32 j = 0;  j < hop_count;  j++  ) {
+					file->rdwr_byte(page->hops[j]);
+				}
+				hop_page_t *&entry = table[page_key(destination, sector)];
+				delete entry;
+				entry = page;
+			}
+		}
+	}
+	file->rdwr_long(reading_table);
+	reading_table = reading_table == 0 ? 0 : 1;
+}
+
+
+void private_car_routes_t::finish_loading()
+{
+	sectors.clear();
+	released_ids[0].clear();
+	released_ids[1].clear();
+
+	std::unordered_map<uint32, vector_tpl<bool> > used;
+	FOR(vector_tpl<weg_t *>, const w, weg_t::get_alle_wege()) {
+		const uint16 id = w->get_private_car_route_id();
+		if(  id == no_id  ) {
+			continue;
+		}
+		const uint32 sector = sector_key(w->get_pos());
+		vector_tpl<bool> &sector_used = used[sector];
+		while(  sector_used.get_count() <= id  ) {
+			sector_used.append(false);
+		}
+		if(  sector_used[id]  ) {
+			dbg->warning("private_car_routes_t::finish_loading()", "Road at %s has the number of another road", w->get_pos().get_str());
+			w->set_private_car_route_id(no_id);
+			continue;
+		}
+		sector_used[id] = true;
+		sectors[sector].next_id = sector_used.get_count();
+	}
+
+	// Numbers not used by any road are free (they may belong to roads removed before saving).
+	for(  std::unordered_map<uint32, vector_tpl<bool> >::const_iterator iter = used.begin();  iter != used.end();  ++iter  ) {
+		sector_t &s = sectors[iter->first];
+		for(  uint32 id = iter->second.get_count();  id-- > 0;  ) {
+			if(  !iter->second[id]  ) {
+				s.free_ids.append((uint16)id);
+			}
+		}
+	}
+
+	// and so are their routes
+	for(  uint8 i = 0;  i < 2;  i++  ) {
+		for(  hop_table_t::iterator iter = hop_tables[i].begin();  iter != hop_tables[i].end();  ++iter  ) {
+			std::unordered_map<uint32, vector_tpl<bool> >::const_iterator sector_used = used.find((uint32)iter->first);
+			hop_page_t *page = iter->second;
+			for(  uint32 id = 0;  id < page->count;  id++  ) {
+				if(  sector_used == used.end()  ||  id >= sector_used->second.get_count()  ||  !sector_used->second[id]  ) {
+					page->hops[id] = 0;
+				}
+			}
+		}
+	}
+}
+
+
+void private_car_routes_t::skip_old_routes(loadsave_t *file)
+{
+	const uint32 table_count = file->is_version_ex_atleast(14, 20) ? 2 : 1;
+	for(  uint32 i = 0;  i < table_count;  i++  ) {
+		if(  file->is_version_ex_less(14, 37)  ) {
+			// destination and next tile pairs
+			uint32 count = 0;
+			file->rdwr_long(count);
+			for(  uint32 j = 0;  j < count;  j++  ) {
+				koord destination;
+				destination.rdwr(file);
+				if(  file->is_version_ex_less(14, 33)  ) {
+					koord3d next_tile;
+					next_tile.rdwr(file);
+				}
+				else {
+					uint8 next_tile_neighbour;
+					file->rdwr_byte(next_tile_neighbour);
+				}
+			}
+		}
+		else {
+			// For each direction, the number of entries and the entries, which are either
+			// destinations or two entries for the index of a list shared with other roads.
+			for(  uint8 j = 0;  j < 5;  j++  ) {
+				uint32 count = 0;
+				file->rdwr_long(count);
+				for(  uint32 k = 0;  k < count;  k++  ) {
+					koord destination;
+					destination.rdwr(file);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef DATAOBJ_PRIVATE_CAR_ROUTES_H
+#define DATAOBJ_PRIVATE_CAR_ROUTES_H
+
+
+#include "../simtypes.h"
+#include "koord.h"
+
+class karte_t;
+class loadsave_t;
+class weg_t;
+template <class T> class vector_tpl;
+
+
+/**
+ * The routes of private cars: for every road tile and destination, the
+ * directions in which a car may continue towards the destination.
+ *
+ * The roads of each sector of sector_size x sector_size tiles are numbered
+ * consecutively (see weg_t::get_private_car_route_id). For every destination
+ * and sector with a route through it, a page holds one byte per road of the
+ * sector: the bits of ribi_t::nesw[i] (1 << i) for the directions, or
+ * hop_here if the destination is reached on that road.
+ *
+ * There are two tables: one is read by the private cars while the routes of
+ * the cities are searched and written into the other. When all cities have
+ * been processed, the tables are swapped (see swap_tables), so readers never
+ * need to lock.
+ *
+ * The private car threads add their routes to buffers of their own, which are
+ * only added to the table by flush_thread_buffers, in the order of the threads.
+ * So the numbering of the roads does not depend on the timing of the threads.
+ */
+class private_car_routes_t
+{
+public:
+	// weg_t::get_private_car_route_id of roads without routes
+	static const uint16 no_id = 0xFFFF;
+
+	// the destination is reached on this road
+	static const uint8 hop_here = 1 << 4;
+
+	static const sint16 sector_shift = 6;
+	static const sint16 sector_size = 1 << sector_shift;
+
+	/**
+	 * Add a direction to @p destination to the road @p w in the table being written,
+	 * or to the buffer of the calling thread.
+	 * @param direction index of ribi_t::nesw, or 4 if the destination is reached.
+	 */
+	static void add_hop(weg_t *w, koord destination, uint8 direction);
+
+	/// Create the buffers of @p count private car threads.
+	static void init_thread_buffers(uint32 count);
+
+	/// Called by a private car thread to add its routes to its buffer.
+	static void set_thread_buffer(uint32 thread_number);
+
+	/// Add the routes of all buffers to the table. Must not be called while the private car threads run.
+	static void flush_thread_buffers();
+
+	/**
+	 * @returns the directions from the road @p w to @p destination,
+	 * 0 if there is no route.
+	 */
+	static uint8 get_hops(const weg_t *w, koord destination, bool reading_table = true);
+
+	/// All destinations with a route through the road @p w in the table being read.
+	static void get_destinations(const weg_t *w, vector_tpl<koord> &destinations);
+
+	/// Release the number of a removed road.
+	static void remove_way(weg_t *w);
+
+	static uint32 get_reading_table() { return reading_table; }
+
+	/// Make the table just written the one to read.
+	static void swap_tables() { reading_table = reading_table == 0 ? 1 : 0; }
+
+	/**
+	 * Empty the table being written.
+	 * The numbers of removed roads are reused once they are in neither table.
+	 */
+	static void clear_writing_table();
+
+	/// Remove all routes (including those in the buffers) and numbers of the roads, e.g. when the map is rotated.
+	static void clear_all();
+
+	static void rdwr(loadsave_t *file);
+
+	/// Restore the numbering of the roads after the ways were loaded.
+	static void finish_loading();
+
+	/// Skip the routes of a road stored in older save games (before 14.67).
+	static void skip_old_routes(loadsave_t *file);
+
+private:
+	static uint32 reading_table;
+};
+
+#endif
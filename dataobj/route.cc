@@ -17,6 +17,9 @@
 #include "../boden/grund.h"
 #include "../boden/wasser.h"
 #include "../dataobj/marker.h"
+#include "../dataobj/route_landmarks.h"
+#include "../dataobj/route_cache.h"
+#include "../dataobj/private_car_routes.h"
 #include "../ifc/simtestdriver.h"
 #include "loadsave.h"
 #include "route.h"
@@ -706,7 +709,6 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 				koord3d previous = koord3d::invalid;
 				weg_t* w;
 				if(fresh_destination && tmp != NULL){
-					weg_t::private_car_backtrace_begin();
 					while (fresh_destination && tmp != NULL)
 					{
 						private_car_route_step_counter++;
@@ -733,7 +735,6 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 							{
 								w->private_car_backtrace_add(city_destination_pos, previous);
 							}
-							w->private_car_backtrace_inc(previous);
 						}
 
 						// Old route storage - we probably no longer need this.
@@ -742,11 +743,12 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 						previous = tmp->gr->get_pos();
 						tmp = tmp->parent;
 					}
-					weg_t::private_car_backtrace_end();
 				}
 #ifdef MULTI_THREAD
 				uint32 max_steps;
-				if (env_t::server && welt->is_paused())
+				// A network game is only stepped while paused on a server without clients (see karte_t::pause_step),
+				// so this is the same on all clients.
+				if (welt->is_paused())
 				{
 					max_steps = welt->get_settings().get_max_route_tiles_to_process_in_a_step_paused_background();
 				}
@@ -760,12 +762,12 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 					// Halt this mid step if there are too many routes being calculated so as not to make the game unresponsive.
 					// On a Ryzen 3900x, calculating all routes from one city on a 600 city map can take ~4 seconds.
 
-					// It is intentional to have two barriers here.
+					// It is intentional to have two barriers here: the first lets the main thread
+					// continue (await_private_car_threads), the second waits for the next step
+					// (start_private_car_threads). suspend_private_car_routing is only changed
+					// between these, so all clients halt the search at the same tiles.
+					simthread_barrier_wait(&karte_t::private_car_barrier);
 					simthread_barrier_wait(&karte_t::private_car_barrier);
-					if (!suspend_private_car_routing)
-					{
-						simthread_barrier_wait(&karte_t::private_car_barrier);
-					}
 					private_car_route_step_counter = 0;
 				}
 #endif
@@ -997,6 +999,20 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 	const bool use_jps     = tdriver->get_waytype()==water_wt;
 	//const bool use_jps     = false;
 
+	/* Landmark distances (ALT) give a much better lower bound of the remaining cost
+	 * than the distance as the crow flies, where ways take detours.
+	 * Each remaining tile costs at least min_cost; ships and aircraft do not follow ways.
+	 */
+	const route_landmarks_t *landmarks = NULL;
+	uint16 ziel_landmark_distances[route_landmarks_t::landmark_count];
+	const uint32 min_cost = flags == simple_cost ? 1 : tdriver->get_min_cost();
+	if(  min_cost > 0  &&  !is_airplane  &&  !use_jps  ) {
+		landmarks = route_landmarks_t::get(wegtyp);
+		if(  landmarks  &&  !landmarks->get_distances(ziel.get_2d(), ziel_landmark_distances)  ) {
+			landmarks = NULL;
+		}
+	}
+
 	bool ziel_erreicht=false;
 
 	// memory in static list ...
@@ -1023,6 +1039,9 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 	tmp->parent = NULL;
 	tmp->gr = gr;
 	tmp->f = calc_distance(start, ziel) * 10;
+	if(  landmarks  ) {
+		tmp->f = max(tmp->f, landmarks->get_lower_bound(start.get_2d(), ziel_landmark_distances) * min_cost * 10);
+	}
 	tmp->g = 0;
 	tmp->dir = 0;
 	tmp->count = 0;
@@ -1268,6 +1287,12 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 
 				best_distance = (dist < best_distance) ? dist : best_distance;
 
+				// the estimate of the remaining cost along the ways
+				uint32 estimate = dist;
+				if(  landmarks  ) {
+					estimate = max(estimate, landmarks->get_lower_bound(to->get_pos().get_2d(), ziel_landmark_distances) * min_cost);
+				}
+
 				// count how many 45 degree turns are necessary to get to target
 				sint8 turns = 0;
 				if (dist > 1 && flags != simple_cost) {
@@ -1293,7 +1318,7 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 					costup = cost_upslope * max(ziel.z - to->get_vmove(next_ribi[r]), 0);
 				}
 
-				const uint32 new_f = (new_g + dist + turns * 3 + costup) * 10;
+				const uint32 new_f = (new_g + estimate + turns * 3 + costup) * 10;
 
 				// add new
 				ANode* k = &nodes[step];
@@ -1512,7 +1537,30 @@ void route_t::postprocess_water_route(karte_t *welt)
 	// profiling for routes ...
 	long ms=dr_time();
 #endif
-	route_result_t ok = intern_calc_route(welt, start, ziel, tdriver, max_khm, max_cost, axle_load, convoy_weight, is_tall, max_len, avoid_tile, direction, flags);
+	// convoys on the same schedule leg search the same routes, so share them
+	route_cache_t::key_t cache_key;
+	const bool use_cache = tdriver->get_route_profile(cache_key.profile);
+	route_result_t ok;
+	if(  use_cache  ) {
+		cache_key.start = start;
+		cache_key.ziel = ziel;
+		cache_key.avoid_tile = avoid_tile;
+		cache_key.max_cost = max_cost;
+		cache_key.max_speed = max_khm;
+		cache_key.tile_length = max_len;
+		cache_key.axle_load = welt->get_settings().get_enforce_weight_limits() ? axle_load : 0;
+		cache_key.convoy_weight = welt->get_settings().get_enforce_weight_limits() ? convoy_weight : 0;
+		cache_key.waytype = tdriver->get_waytype();
+		cache_key.start_dir = direction;
+		cache_key.flags = flags;
+		cache_key.is_tall = is_tall;
+	}
+	if(  !use_cache  ||  !route_cache_t::get(cache_key, route, ok, max_axle_load, max_convoy_weight)  ) {
+		ok = intern_calc_route(welt, start, ziel, tdriver, max_khm, max_cost, axle_load, convoy_weight, is_tall, max_len, avoid_tile, direction, flags);
+		if(  use_cache  ) {
+			route_cache_t::put(cache_key, route, ok, max_axle_load, max_convoy_weight);
+		}
+	}
 #ifdef DEBUG_ROUTES
 	if(tdriver->get_waytype()==water_wt) {
 		DBG_DEBUG("route_t::calc_route()", "route from %d,%d to %d,%d with %i steps in %u ms found.", start.x, start.y, ziel.x, ziel.y, route.get_count()-1, dr_time()-ms );
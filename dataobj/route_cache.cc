@@ -0,0 +1,138 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include <unordered_map>
+
+#include "route_cache.h"
+
+#include "../boden/wege/weg.h"
+#include "../utils/simthread.h"
+
+
+sint32 route_cache_t::current_step = 0;
+
+
+namespace
+{
+	struct route_cache_hash_t
+	{
+		static inline void mix(uint64 &hash, uint64 value)
+		{
+			hash = (hash ^ value) * 0x100000001b3ull;
+		}
+
+		static inline uint64 koord3d_value(const koord3d &k)
+		{
+			return ((uint64)(uint16)k.x << 24) | ((uint64)(uint16)k.y << 8) | (uint8)k.z;
+		}
+
+		size_t operator()(const route_cache_t::key_t &key) const
+		{
+			uint64 hash = 0xcbf29ce484222325ull;
+			mix(hash, koord3d_value(key.start));
+			mix(hash, koord3d_value(key.ziel));
+			mix(hash, koord3d_value(key.avoid_tile));
+			mix(hash, (uint64)key.max_cost);
+			mix(hash, ((uint64)(uint32)key.max_speed << 32) | (uint32)key.tile_length);
+			mix(hash, ((uint64)key.axle_load << 32) | key.convoy_weight);
+			mix(hash, ((uint64)key.waytype << 24) | ((uint64)key.start_dir << 16) | ((uint64)key.flags << 8) | key.is_tall);
+			const route_profile_t &p = key.profile;
+			mix(hash, ((uint64)(uint32)p.min_speed << 32) | ((uint64)p.owner_nr << 24) | ((uint64)p.access_owner_nr << 16) | ((uint64)p.way_permissive << 8) | p.way_prohibitive);
+			mix(hash, ((uint64)p.axle_load << 32) | p.weight);
+			mix(hash, ((uint64)p.waytype << 8) | (p.needs_electrification << 2) | (p.override_way_speed << 1) | p.speed_limited);
+			return (size_t)(hash ^ (hash >> 32));
+		}
+	};
+
+	struct route_cache_entry_t
+	{
+		vector_tpl<koord3d> route;
+		route_t::route_result_t result;
+		uint32 max_axle_load;
+		uint32 max_convoy_weight;
+		uint32 route_generation;
+		sint32 created;
+	};
+
+	typedef std::unordered_map<route_cache_t::key_t, route_cache_entry_t, route_cache_hash_t> route_cache_map_t;
+
+	route_cache_map_t route_cache;
+
+#ifdef MULTI_THREAD
+	pthread_mutex_t route_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+	bool is_current(const route_cache_t::key_t &key, const route_cache_entry_t &entry, sint32 now)
+	{
+		return entry.route_generation == weg_t::get_route_generation((waytype_t)key.waytype)  &&  now - entry.created < route_cache_t::max_age  &&  now >= entry.created;
+	}
+}
+
+
+bool route_cache_t::get(const key_t &key, vector_tpl<koord3d> &route, route_t::route_result_t &result, uint32 &max_axle_load, uint32 &max_convoy_weight)
+{
+	bool found = false;
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&route_cache_mutex);
+#endif
+	route_cache_map_t::const_iterator iter = route_cache.find(key);
+	if(  iter != route_cache.end()  &&  is_current(key, iter->second, current_step)  ) {
+		route = iter->second.route;
+		result = iter->second.result;
+		max_axle_load = iter->second.max_axle_load;
+		max_convoy_weight = iter->second.max_convoy_weight;
+		found = true;
+	}
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock(&route_cache_mutex);
+#endif
+	return found;
+}
+
+
+void route_cache_t::put(const key_t &key, const vector_tpl<koord3d> &route, route_t::route_result_t result, uint32 max_axle_load, uint32 max_convoy_weight)
+{
+	route_cache_entry_t entry;
+	entry.route = route;
+	entry.result = result;
+	entry.max_axle_load = max_axle_load;
+	entry.max_convoy_weight = max_convoy_weight;
+	entry.route_generation = weg_t::get_route_generation((waytype_t)key.waytype);
+	entry.created = current_step;
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&route_cache_mutex);
+#endif
+	// Another thread may have found the same route in the meantime: as it is
+	// the same route, it does not matter which one is kept.
+	route_cache[key] = entry;
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock(&route_cache_mutex);
+#endif
+}
+
+
+void route_cache_t::expire()
+{
+	if(  route_cache.size() > max_entries  ) {
+		// Removing the least recently found routes would depend on the order of the
+		// threads, so start again instead.
+		route_cache.clear();
+		return;
+	}
+	for(  route_cache_map_t::iterator iter = route_cache.begin();  iter != route_cache.end();  ) {
+		if(  is_current(iter->first, iter->second, current_step)  ) {
+			++iter;
+		}
+		else {
+			iter = route_cache.erase(iter);
+		}
+	}
+}
+
+
+void route_cache_t::clear()
+{
+	route_cache.clear();
+}
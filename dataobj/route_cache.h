@@ -0,0 +1,96 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef DATAOBJ_ROUTE_CACHE_H
+#define DATAOBJ_ROUTE_CACHE_H
+
+
+#include "../simtypes.h"
+#include "../ifc/simtestdriver.h"
+#include "../tpl/vector_tpl.h"
+#include "koord3d.h"
+#include "route.h"
+
+class karte_t;
+
+
+/**
+ * Routes found by route_t::intern_calc_route for convoys, so that other convoys
+ * searching the same route (e.g. on the same schedule leg) can reuse them.
+ *
+ * A route is only shared between drivers with the same route_profile_t and search
+ * parameters. It is discarded when anything changes the routes may depend on
+ * (see weg_t::get_route_generation) and after max_age steps, so that changes which
+ * are not counted, like the congestion of roads, are taken into account in time.
+ *
+ * The cache is used by the convoy threads, but its contents are deterministic:
+ * any search result depends only on its key and the state of the world, which does
+ * not change while the convoy threads run. Entries are only removed in expire(),
+ * which must be called while no routes are searched.
+ */
+class route_cache_t
+{
+public:
+	struct key_t
+	{
+		koord3d start;
+		koord3d ziel;
+		koord3d avoid_tile;
+		sint64 max_cost;
+		sint32 max_speed;
+		sint32 tile_length;
+		uint32 axle_load;
+		uint32 convoy_weight;
+		route_profile_t profile;
+		uint8 waytype;
+		uint8 start_dir;
+		uint8 flags;
+		bool is_tall;
+
+		bool operator==(const key_t &o) const
+		{
+			return start == o.start  &&  ziel == o.ziel  &&  avoid_tile == o.avoid_tile  &&  max_cost == o.max_cost  &&
+				max_speed == o.max_speed  &&  tile_length == o.tile_length  &&  axle_load == o.axle_load  &&
+				convoy_weight == o.convoy_weight  &&  profile == o.profile  &&  waytype == o.waytype  &&
+				start_dir == o.start_dir  &&  flags == o.flags  &&  is_tall == o.is_tall;
+		}
+	};
+
+	// number of steps after which an entry is discarded
+	static const sint32 max_age = 1024;
+
+	// expire() empties the cache if it holds more entries than this
+	static const uint32 max_entries = 8192;
+
+private:
+	// the step stamped on the routes found, see set_step()
+	static sint32 current_step;
+
+public:
+	/**
+	 * Set the step from which the age of the routes is counted.
+	 * The convoy threads still run while karte_t::step advances the steps, so they
+	 * must not read them: this is called by the main thread before they are started.
+	 */
+	static void set_step(sint32 step) { current_step = step; }
+
+	/**
+	 * Look up a route.
+	 * @returns false if it is not in the cache (or outdated)
+	 */
+	static bool get(const key_t &key, vector_tpl<koord3d> &route, route_t::route_result_t &result, uint32 &max_axle_load, uint32 &max_convoy_weight);
+
+	static void put(const key_t &key, const vector_tpl<koord3d> &route, route_t::route_result_t result, uint32 max_axle_load, uint32 max_convoy_weight);
+
+	/**
+	 * Remove outdated entries.
+	 * Must not be called while routes may be searched on other threads.
+	 */
+	static void expire();
+
+	static void clear();
+};
+
+#endif
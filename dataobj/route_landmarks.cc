@@ -0,0 +1,201 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include <string.h>
+
+#include "route_landmarks.h"
+
+#include "../simdebug.h"
+#include "../simworld.h"
+#include "../simplan.h"
+#include "../macros.h"
+#include "../boden/grund.h"
+#include "../boden/wege/weg.h"
+#include "../tpl/vector_tpl.h"
+
+
+route_landmarks_t *route_landmarks_t::all_landmarks[narrowgauge_wt + 1];
+
+// the waytypes whose routes are searched along their ways (not ships and aircraft)
+static const waytype_t landmark_waytypes[] = { road_wt, track_wt, monorail_wt, maglev_wt, tram_wt, narrowgauge_wt };
+
+
+route_landmarks_t::route_landmarks_t(karte_t *welt, const waytype_t wt)
+{
+	waytype = wt;
+	network_generation = weg_t::get_network_generation(wt);
+	rotation = welt->get_settings().get_rotation();
+	size = welt->get_size();
+	blocks_x = (size.x + block_tiles_per_row - 1) >> block_shift;
+	blocks_y = (size.y + block_tiles_per_row - 1) >> block_shift;
+	blocks = new block_t *[blocks_x * blocks_y];
+	memset(blocks, 0, sizeof(block_t *) * blocks_x * blocks_y);
+
+	calc_all_distances(welt);
+}
+
+
+route_landmarks_t::~route_landmarks_t()
+{
+	for(  sint32 i = 0;  i < blocks_x * blocks_y;  i++  ) {
+		delete blocks[i];
+	}
+	delete [] blocks;
+}
+
+
+uint16 *route_landmarks_t::get_tile_distances(const koord pos, const bool create)
+{
+	block_t *&block = blocks[(pos.y >> block_shift) * blocks_x + (pos.x >> block_shift)];
+	if(  block == NULL  ) {
+		if(  !create  ) {
+			return NULL;
+		}
+		block = new block_t;
+		memset(block->distance, 0xFF, sizeof(block->distance));
+	}
+	return block->distance[((pos.y & (block_tiles_per_row - 1)) << block_shift) + (pos.x & (block_tiles_per_row - 1))];
+}
+
+
+void route_landmarks_t::append_tile(karte_t *welt, const koord pos, vector_tpl<const grund_t *> &queue) const
+{
+	// all grounds of a tile share the distance, so continue from all of them
+	const planquadrat_t *plan = welt->access(pos);
+	for(  uint32 i = 0;  i < plan->get_boden_count();  i++  ) {
+		const grund_t *gr = plan->get_boden_bei(i);
+		if(  gr->get_weg(waytype)  ) {
+			queue.append(gr);
+		}
+	}
+}
+
+
+const grund_t *route_landmarks_t::calc_distances(karte_t *welt, const grund_t *origin, const uint8 slot, vector_tpl<const grund_t *> &queue)
+{
+	queue.clear();
+
+	const grund_t *farthest = origin;
+	uint16 farthest_distance = 0;
+
+	get_tile_distances(origin->get_pos().get_2d(), true)[slot] = 0;
+	append_tile(welt, origin->get_pos().get_2d(), queue);
+
+	// the grounds are processed in the order they were reached, which is the order of their distance
+	for(  uint32 i = 0;  i < queue.get_count();  i++  ) {
+		const grund_t *gr = queue[i];
+		const uint16 *distances = get_tile_distances(gr->get_pos().get_2d(), false);
+
+		// the landmark for the next slot is the tile farthest from all landmarks so far
+		uint16 nearest = distances[slot];
+		for(  uint8 j = 0;  j < slot;  j++  ) {
+			nearest = min(nearest, distances[j]);
+		}
+		if(  nearest > farthest_distance  ) {
+			farthest = gr;
+			farthest_distance = nearest;
+		}
+
+		const uint16 next_distance = distances[slot] < max_distance ? distances[slot] + 1 : max_distance;
+		for(  uint8 r = 0;  r < 4;  r++  ) {
+			grund_t *to;
+			if(  !gr->get_neighbour(to, waytype, ribi_t::nesw[r])  ) {
+				continue;
+			}
+			const koord to_pos = to->get_pos().get_2d();
+			uint16 *to_distances = get_tile_distances(to_pos, true);
+			if(  to_distances[slot] != unknown_distance  ) {
+				continue;
+			}
+			to_distances[slot] = next_distance;
+			append_tile(welt, to_pos, queue);
+		}
+	}
+
+	return farthest;
+}
+
+
+void route_landmarks_t::calc_all_distances(karte_t *welt)
+{
+	vector_tpl<const grund_t *> queue;
+
+	FOR(vector_tpl<weg_t *> const, w, weg_t::get_alle_wege()) {
+		if(  w->get_waytype() != waytype  ) {
+			continue;
+		}
+		const grund_t *gr = welt->lookup(w->get_pos());
+		const uint16 *distances = gr ? get_tile_distances(gr->get_pos().get_2d(), false) : NULL;
+		if(  gr == NULL  ||  (distances  &&  distances[0] != unknown_distance)  ) {
+			// already part of a network
+			continue;
+		}
+
+		// A new connected part of the network: The first landmark is the tile farthest
+		// from an arbitrary tile, the others the tiles farthest from all previous landmarks.
+		const grund_t *landmark = calc_distances(welt, gr, 0, queue);
+		FOR(vector_tpl<const grund_t *>, reached, queue) {
+			get_tile_distances(reached->get_pos().get_2d(), false)[0] = unknown_distance;
+		}
+		for(  uint8 slot = 0;  slot < landmark_count;  slot++  ) {
+			landmark = calc_distances(welt, landmark, slot, queue);
+		}
+	}
+}
+
+
+bool route_landmarks_t::get_distances(const koord pos, uint16 *distances) const
+{
+	if(  pos.x < 0  ||  pos.y < 0  ||  pos.x >= size.x  ||  pos.y >= size.y  ) {
+		return false;
+	}
+	const block_t *block = blocks[(pos.y >> block_shift) * blocks_x + (pos.x >> block_shift)];
+	if(  block == NULL  ) {
+		return false;
+	}
+	const uint16 *tile_distances = block->distance[((pos.y & (block_tiles_per_row - 1)) << block_shift) + (pos.x & (block_tiles_per_row - 1))];
+	if(  tile_distances[0] == unknown_distance  ) {
+		return false;
+	}
+	memcpy(distances, tile_distances, sizeof(uint16) * landmark_count);
+	return true;
+}
+
+
+const route_landmarks_t *route_landmarks_t::get(const waytype_t wt)
+{
+	if(  wt < 0  ||  wt > narrowgauge_wt  ) {
+		return NULL;
+	}
+	const route_landmarks_t *landmarks = all_landmarks[wt];
+	if(  landmarks == NULL  ||  landmarks->network_generation != weg_t::get_network_generation(wt)  ) {
+		return NULL;
+	}
+	return landmarks;
+}
+
+
+void route_landmarks_t::update_all(karte_t *welt)
+{
+	for(  uint8 i = 0;  i < lengthof(landmark_waytypes);  i++  ) {
+		const waytype_t wt = landmark_waytypes[i];
+		route_landmarks_t *&landmarks = all_landmarks[wt];
+		if(  landmarks  &&  landmarks->network_generation == weg_t::get_network_generation(wt)
+			&&  landmarks->rotation == welt->get_settings().get_rotation()  &&  landmarks->size == welt->get_size()  ) {
+			continue;
+		}
+		delete landmarks;
+		landmarks = new route_landmarks_t(welt, wt);
+	}
+}
+
+
+void route_landmarks_t::clear_all()
+{
+	for(  uint8 i = 0;  i <= narrowgauge_wt;  i++  ) {
+		delete all_landmarks[i];
+		all_landmarks[i] = NULL;
+	}
+}
@@ -0,0 +1,137 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef DATAOBJ_ROUTE_LANDMARKS_H
+#define DATAOBJ_ROUTE_LANDMARKS_H
+
+
+#include "../simtypes.h"
+#include "koord.h"
+
+class karte_t;
+class grund_t;
+template <class T> class vector_tpl;
+
+
+/**
+ * Landmark distances for the A* heuristic of the route search (ALT).
+ *
+ * For a few landmark tiles in each connected part of the way network of a waytype,
+ * the number of tiles to every other tile of that part is stored. By the triangle
+ * inequality, |d(L, a) - d(L, b)| is a lower bound for the number of tiles of any
+ * route between the tiles a and b. Unlike the distance as the crow flies, this
+ * bound accounts for meandering ways.
+ *
+ * All grounds on the same tile share one distance, and one way directions (ribi masks)
+ * are ignored. Both only make the bound weaker, so it remains valid for all vehicles.
+ *
+ * The distances are only used while the network is unchanged since they were
+ * calculated (see weg_t::get_network_generation) and the map was not rotated
+ * (karte_t::rotate90 clears them). They are recalculated in the
+ * single threaded part of the step, so all clients of a network game use the same data.
+ */
+class route_landmarks_t
+{
+public:
+	static const uint8 landmark_count = 4;
+
+	// distances to the landmarks of a tile not in the network (or too far away)
+	static const uint16 unknown_distance = 0xFFFF;
+	static const uint16 max_distance = 0xFFFE;
+
+	// number of steps between checks whether the landmarks are outdated
+	static const uint32 update_interval = 256;
+
+private:
+	// the distances are stored in blocks of 16x16 tiles, only for blocks with ways
+	static const uint8 block_shift = 4;
+	static const uint16 block_tiles_per_row = 1 << block_shift;
+	static const uint16 block_tiles = block_tiles_per_row * block_tiles_per_row;
+
+	struct block_t
+	{
+		uint16 distance[block_tiles][landmark_count];
+	};
+
+	waytype_t waytype;
+	uint32 network_generation;
+
+	// the distances are stored by position, so they are only valid for this rotation
+	uint8 rotation;
+
+	koord size;
+	sint32 blocks_x;
+	sint32 blocks_y;
+	block_t **blocks;
+
+	uint16 *get_tile_distances(const koord pos, const bool create);
+
+	// append all grounds of the tile @p pos with a way of our waytype to @p queue
+	void append_tile(karte_t *welt, const koord pos, vector_tpl<const grund_t *> &queue) const;
+
+	/**
+	 * Breadth first search from @p origin, storing the distances in @p slot.
+	 * @p queue returns all grounds found in the order of their distance.
+	 * @returns the ground which is farthest from all landmarks up to this slot
+	 */
+	const grund_t *calc_distances(karte_t *welt, const grund_t *origin, const uint8 slot, vector_tpl<const grund_t *> &queue);
+
+	void calc_all_distances(karte_t *welt);
+
+	route_landmarks_t(karte_t *welt, const waytype_t wt);
+
+	// all landmark tables, indexed by waytype; NULL if not calculated
+	static route_landmarks_t *all_landmarks[narrowgauge_wt + 1];
+
+public:
+	~route_landmarks_t();
+
+	/**
+	 * @returns the landmark distances of the network of this waytype,
+	 * or NULL if there are none or they are outdated.
+	 */
+	static const route_landmarks_t *get(const waytype_t wt);
+
+	/**
+	 * Recalculate all outdated landmark distances.
+	 * Must not be called while routes may be searched on other threads.
+	 */
+	static void update_all(karte_t *welt);
+
+	static void clear_all();
+
+	/**
+	 * Copy the distances of the tile @p pos to the landmarks into @p distances.
+	 * @returns false if the tile does not belong to the network.
+	 */
+	bool get_distances(const koord pos, uint16 *distances) const;
+
+	/**
+	 * @returns a lower bound of the number of tiles from @p pos to the tile whose
+	 * distances (see get_distances) are @p target_distances.
+	 */
+	uint32 get_lower_bound(const koord pos, const uint16 *target_distances) const
+	{
+		if(  pos.x < 0  ||  pos.y < 0  ||  pos.x >= size.x  ||  pos.y >= size.y  ) {
+			return 0;
+		}
+		const block_t *const block = blocks[(pos.y >> block_shift) * blocks_x + (pos.x >> block_shift)];
+		if(  block == NULL  ) {
+			return 0;
+		}
+		const uint16 *const distances = block->distance[((pos.y & (block_tiles_per_row - 1)) << block_shift) + (pos.x & (block_tiles_per_row - 1))];
+		uint32 bound = 0;
+		for(  uint8 i = 0;  i < landmark_count;  i++  ) {
+			// saturated distances are not exact, so they cannot give a bound
+			if(  distances[i] < max_distance  &&  target_distances[i] < max_distance  ) {
+				const uint32 difference = distances[i] > target_distances[i] ? distances[i] - target_distances[i] : target_distances[i] - distances[i];
+				bound = difference > bound ? difference : bound;
+			}
+		}
+		return bound;
+	}
+};
+
+#endif
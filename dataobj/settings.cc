@@ -560,6 +560,8 @@ settings_t::settings_t() :
 
 	path_explorer_time_midpoint = 64;
 	save_path_explorer_data = true;
+	path_explorer_incremental_threshold = 64;
+	path_explorer_compact_threshold = 4096;
 
 	show_future_vehicle_info = true;
 }
@@ -1860,6 +1862,21 @@ void settings_t::rdwr(loadsave_t *file)
 			file->rdwr_bool(save_path_explorer_data);
 		}
 
+		if (file->is_version_ex_atleast(14, 64))
+		{
+			file->rdwr_long(path_explorer_incremental_threshold);
+		}
+		else if (file->is_loading())
+		{
+			// Older saved games always recalculated all paths.
+			path_explorer_incremental_threshold = 0;
+		}
+
+		if (file->is_version_ex_atleast(14, 66))
+		{
+			file->rdwr_long(path_explorer_compact_threshold);
+		}
+
 		if (file->get_extended_version() >= 15 || (file->get_extended_version() >= 14 && file->get_extended_revision() >= 18))
 		{
 			file->rdwr_bool(show_future_vehicle_info);
@@ -2106,6 +2123,8 @@ void settings_t::parse_simuconf( tabfile_t& simuconf, sint16& disp_width, sint16
 	env_t::num_threads                 = contents.get_int_clamped( "threads",                        env_t::num_threads,               1, MAX_THREADS );
 	env_t::simple_drawing_default      = contents.get_int_clamped( "simple_drawing_tile_size",       env_t::simple_drawing_default,    2, 256 );
 	env_t::simple_drawing_fast_forward = contents.get_int( "simple_drawing_fast_forward", env_t::simple_drawing_fast_forward ) != 0;
+	env_t::aggregate_off_screen_road_users = contents.get_int( "aggregate_off_screen_road_users", env_t::aggregate_off_screen_road_users ) != 0;
+	env_t::image_cache_size            = contents.get_int_clamped( "image_cache_size",               env_t::image_cache_size,          0, 65535 );
 	env_t::visualize_schedule          = contents.get_int( "visualize_schedule",          env_t::visualize_schedule ) != 0;
 
 	env_t::show_delete_buttons      = contents.get_int( "show_delete_buttons",       env_t::show_delete_buttons ) != 0;
@@ -2386,6 +2405,7 @@ void settings_t::parse_simuconf( tabfile_t& simuconf, sint16& disp_width, sint16
 	}
 
 	env_t::autosave = contents.get_int_clamped( "autosave", env_t::autosave, 0, INT_MAX );
+	env_t::background_save = contents.get_int( "background_save", env_t::background_save ) != 0;
 
 	// routing stuff
 	max_route_steps        = contents.get_int_clamped( "max_route_steps",        max_route_steps,        0, INT_MAX );
@@ -2957,6 +2977,8 @@ void settings_t::parse_simuconf( tabfile_t& simuconf, sint16& disp_width, sint16
 
 	path_explorer_time_midpoint = contents.get_int("path_explorer_time_midpoint", path_explorer_time_midpoint);
 	save_path_explorer_data = contents.get_int("save_path_explorer_data", save_path_explorer_data);
+	path_explorer_incremental_threshold = contents.get_int("path_explorer_incremental_threshold", path_explorer_incremental_threshold);
+	path_explorer_compact_threshold = contents.get_int("path_explorer_compact_threshold", path_explorer_compact_threshold);
 
 	show_future_vehicle_info = contents.get_int("show_future_vehicle_information", show_future_vehicle_info);
 
@@ -791,6 +791,12 @@ public:
 
 	uint32 path_explorer_time_midpoint;
 	bool save_path_explorer_data;
+	// Up to this number of changed connexions, the path explorer repairs its
+	// existing paths rather than recalculating all of them. 0 = disabled.
+	uint32 path_explorer_incremental_threshold;
+	// From this number of stops, the paths of a goods category/class are stored
+	// compactly rather than in a full matrix. 0 = disabled.
+	uint32 path_explorer_compact_threshold;
 
 	// Whether players can know in advance the vehicle production end date and upgrade availability date
 	// If false, only information up to one year ahead
@@ -1332,6 +1338,8 @@ public:
 
 	uint32 get_path_explorer_time_midpoint() const { return path_explorer_time_midpoint; }
 	bool get_save_path_explorer_data() const { return save_path_explorer_data; }
+	uint32 get_path_explorer_incremental_threshold() const { return path_explorer_incremental_threshold; }
+	uint32 get_path_explorer_compact_threshold() const { return path_explorer_compact_threshold; }
 
 	bool get_show_future_vehicle_info() const { return show_future_vehicle_info; }
 	//void set_show_future_vehicle_info(bool yesno) { show_future_vehicle_info = yesno; }
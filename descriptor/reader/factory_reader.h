@@ -43,6 +43,9 @@ protected:
 	/// @copydoc obj_reader_t::register_obj
 	void register_obj(obj_desc_t *&desc) OVERRIDE;
 
+	/// read_node() leaves the field class for register_obj()
+	bool can_read_in_parallel() const OVERRIDE { return false; }
+
 public:
 	static factory_field_group_reader_t *instance() { return &the_instance; }
 
@@ -108,6 +111,9 @@ protected:
 	/// @copydoc obj_reader_t::register_obj
 	void register_obj(obj_desc_t *&desc) OVERRIDE;
 
+	/// read_node() loads the sound
+	bool can_read_in_parallel() const OVERRIDE { return false; }
+
 	/// @copydoc obj_reader_t::successfully_loaded
 	bool successfully_loaded() const OVERRIDE;
 
@@ -162,6 +162,14 @@ adjust_image:
 		}
 	}
 
+	return desc;
+}
+
+
+void image_reader_t::register_obj(obj_desc_t *&data)
+{
+	image_t *desc = static_cast<image_t *>(data);
+
 	if (desc->len != 0) {
 		// get the adler hash (since we have zlib on board anyway ... )
 		bool do_register_image = true;
@@ -194,9 +202,7 @@ adjust_image:
 		else {
 			// no need to load doubles ...
 			delete desc;
-			desc = same;
+			data = same;
 		}
 	}
-
-	return desc;
 }
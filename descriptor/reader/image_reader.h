@@ -14,6 +14,11 @@ class image_reader_t : public obj_reader_t {
 	static image_reader_t the_instance;
 
 	image_reader_t() { register_reader(); }
+
+protected:
+	/// Registers the image with the graphics, or replaces it by an identical one registered before.
+	void register_obj(obj_desc_t *&desc) OVERRIDE;
+
 public:
 	static image_reader_t* instance() { return &the_instance; }
 
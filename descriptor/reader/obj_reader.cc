@@ -3,6 +3,7 @@
  * (see LICENSE.txt)
  */
 
+#include <atomic>
 #include <string>
 #include <string.h>
 
@@ -27,8 +28,13 @@
 #include "../../tpl/inthashtable_tpl.h"
 #include "../../tpl/ptrhashtable_tpl.h"
 #include "../../tpl/stringhashtable_tpl.h"
+#include "../../tpl/vector_tpl.h"
 #include "../../simdebug.h"
 
+#ifdef MULTI_THREAD
+#include "../../utils/simthread.h"
+#endif
+
 #include "../obj_desc.h"
 #include "../obj_node_info.h"
 
@@ -40,6 +46,74 @@ inthashtable_tpl<obj_type, stringhashtable_tpl<obj_desc_t*, N_BAGS_LARGE>, N_BAG
 obj_reader_t::unresolved_map                                  obj_reader_t::unresolved;
 ptrhashtable_tpl<obj_desc_t**, int, N_BAGS_SMALL>             obj_reader_t::fatals;
 
+
+/// a step of loading a node, which must be done in the order of the files
+struct obj_reader_t::pending_t
+{
+	obj_reader_t *reader;
+	/// where the descriptor of the node is stored
+	obj_desc_t **desc;
+	/// true to call read_node(), false to call register_obj()
+	bool read;
+	/// for read_node(): the node, the position of its data in the file and its already read children
+	obj_node_info_t node;
+	long offset;
+	obj_desc_t **children;
+};
+
+
+struct obj_reader_t::pak_file_t
+{
+	std::string name;
+	obj_desc_t *root;
+	vector_tpl<pending_t> pending;
+	/// parse_file() is done
+	std::atomic<bool> parsed;
+
+	pak_file_t() : root(NULL), parsed(false) {}
+};
+
+
+#ifdef MULTI_THREAD
+/// the files of a pak directory, parsed by worker threads in order
+struct obj_reader_t::parse_queue_t
+{
+	pak_file_t *files;
+	uint32 count;
+	/// next file to parse
+	std::atomic<uint32> next;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t parsed_cond;
+
+	/// parses the next file, @return false if all files are taken
+	bool parse_next()
+	{
+		const uint32 n = next++;
+		if(  n >= count  ) {
+			return false;
+		}
+		parse_file(files[n]);
+
+		pthread_mutex_lock(&mutex);
+		files[n].parsed = true;
+		pthread_cond_broadcast(&parsed_cond);
+		pthread_mutex_unlock(&mutex);
+		return true;
+	}
+};
+
+
+void *obj_reader_t::parse_thread(void *ptr)
+{
+	parse_queue_t *queue = (parse_queue_t *)ptr;
+	while(  queue->parse_next()  ) {
+	}
+	return NULL;
+}
+#endif
+
+
 void obj_reader_t::register_reader()
 {
 	if(!obj_reader) {
@@ -147,15 +221,65 @@ DBG_MESSAGE("obj_reader_t::load()","big logo %p", skinverwaltung_t::biglogosymbo
 
 DBG_MESSAGE("obj_reader_t::load()", "reading from '%s'", name.c_str());
 
-		uint n = 0;
-		FORX(searchfolder_t, const& i, find, ++n) {
-			read_file(i);
+		pak_file_t *files = new pak_file_t[max];
+		uint32 count = 0;
+		FOR(searchfolder_t, const& i, find) {
+			files[count++].name = i;
+		}
+
+#ifdef MULTI_THREAD
+		// the workers read the files, while this thread registers them in the order of the directory
+		parse_queue_t queue;
+		queue.files = files;
+		queue.count = count;
+		queue.next = 0;
+		pthread_mutex_init(&queue.mutex, NULL);
+		pthread_cond_init(&queue.parsed_cond, NULL);
+
+		vector_tpl<pthread_t> workers;
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+		for(  int t = 1;  t < env_t::num_threads  &&  (uint32)t < count;  t++  ) {
+			pthread_t thread;
+			if(  pthread_create(&thread, &attr, parse_thread, (void *)&queue) != 0  ) {
+				dbg->warning("obj_reader_t::load()", "cannot create thread, reading with %d threads", t);
+				break;
+			}
+			workers.append(thread);
+		}
+		pthread_attr_destroy(&attr);
+#endif
+
+		for(  uint32 n = 0;  n < count;  n++  ) {
+#ifdef MULTI_THREAD
+			// help parsing until this file is done
+			while(  !files[n].parsed  &&  queue.parse_next()  ) {
+			}
+			pthread_mutex_lock(&queue.mutex);
+			while(  !files[n].parsed  ) {
+				pthread_cond_wait(&queue.parsed_cond, &queue.mutex);
+			}
+			pthread_mutex_unlock(&queue.mutex);
+#else
+			parse_file(files[n]);
+#endif
+			register_file(files[n]);
 			if ((n & step) == 0 && drawing) {
 				ls.set_progress(n);
 			}
 		}
 		ls.set_progress(max);
 
+#ifdef MULTI_THREAD
+		FOR(vector_tpl<pthread_t>, const &thread, workers) {
+			pthread_join(thread, NULL);
+		}
+		pthread_cond_destroy(&queue.parsed_cond);
+		pthread_mutex_destroy(&queue.mutex);
+#endif
+		delete [] files;
+
 		return find.begin()!=find.end();
 	}
 	return false;
@@ -164,6 +288,17 @@ DBG_MESSAGE("obj_reader_t::load()", "reading from '%s'", name.c_str());
 
 void obj_reader_t::read_file(const char *name)
 {
+	pak_file_t file;
+	file.name = name;
+	parse_file(file);
+	register_file(file);
+}
+
+
+void obj_reader_t::parse_file(pak_file_t &file)
+{
+	const char *name = file.name.c_str();
+
 	// added trace
 	DBG_DEBUG("obj_reader_t::read_file()", "filename='%s'", name);
 
@@ -195,8 +330,7 @@ void obj_reader_t::read_file(const char *name)
 		DBG_DEBUG("obj_reader_t::read_file()", "read %d blocks, file version is %x", n, version);
 
 		if(version <= COMPILER_VERSION_CODE) {
-			obj_desc_t *data = NULL;
-			read_nodes(fp, data, 0, version );
+			read_nodes(fp, file.root, 0, version, file);
 		}
 		else {
 			DBG_DEBUG("obj_reader_t::read_file()","version of '%s' is too old, %d instead of %d", name, version, COMPILER_VERSION_CODE );
@@ -209,6 +343,33 @@ void obj_reader_t::read_file(const char *name)
 }
 
 
+void obj_reader_t::register_file(pak_file_t &file)
+{
+	FILE *fp = NULL;
+	FOR(vector_tpl<pending_t>, const& p, file.pending) {
+		if(p.read) {
+			if(fp == NULL  &&  (fp = dr_fopen(file.name.c_str(), "rb")) == NULL) {
+				dbg->error("obj_reader_t::read_file()", "reading '%s' failed!", file.name.c_str());
+				break;
+			}
+			obj_node_info_t node = p.node;
+			fseek(fp, p.offset, SEEK_SET);
+			*p.desc = p.reader->read_node(fp, node);
+			if (p.children) {
+				(*p.desc)->children = p.children;
+			}
+		}
+		else {
+			p.reader->register_obj(*p.desc);
+		}
+	}
+	if(fp) {
+		fclose(fp);
+	}
+	file.pending.clear();
+}
+
+
 static void read_node_info(obj_node_info_t& node, FILE* const f, uint32 const version)
 {
 	char data[EXT_OBJ_NODE_INFO_SIZE];
@@ -226,27 +387,46 @@ static void read_node_info(obj_node_info_t& node, FILE* const f, uint32 const ve
 }
 
 
-void obj_reader_t::read_nodes(FILE* fp, obj_desc_t*& data, int register_nodes, uint32 version )
+void obj_reader_t::read_nodes(FILE* fp, obj_desc_t*& data, int register_nodes, uint32 version, pak_file_t &file)
 {
 	obj_node_info_t node;
 	read_node_info(node, fp, version);
 
 	obj_reader_t *reader = obj_reader->get(static_cast<obj_type>(node.type));
 	if(reader) {
+		pending_t pending;
+		pending.reader = reader;
+		pending.desc = &data;
+		pending.children = NULL;
 
 //DBG_DEBUG("obj_reader_t::read_nodes()","Reading %.4s-node of length %d with '%s'", reinterpret_cast<const char *>(&node.type), node.size, reader->get_type_name());
-		data = reader->read_node(fp, node);
 		if (node.children != 0) {
-			data->children = new obj_desc_t*[node.children];
-			for (int i = 0; i < node.children; i++) {
-				read_nodes(fp, data->children[i], register_nodes + 1, version);
+			pending.children = new obj_desc_t*[node.children];
+		}
+		if (reader->can_read_in_parallel()) {
+			data = reader->read_node(fp, node);
+			if (pending.children) {
+				data->children = pending.children;
 			}
 		}
+		else {
+			// read later by register_file()
+			data = NULL;
+			pending.read = true;
+			pending.node = node;
+			pending.offset = ftell(fp);
+			file.pending.append(pending);
+			fseek(fp, node.size, SEEK_CUR);
+		}
+		for (int i = 0; i < node.children; i++) {
+			read_nodes(fp, pending.children[i], register_nodes + 1, version, file);
+		}
 
 //DBG_DEBUG("obj_reader_t","registering with '%s'", reader->get_type_name());
 		if(register_nodes<2  ||  node.type!=obj_cursor) {
 			// since many buildings are with cursors that do not need registration
-			reader->register_obj(data);
+			pending.read = false;
+			file.pending.append(pending);
 		}
 	}
 	else {
@@ -80,9 +80,21 @@ class obj_reader_t
 	static unresolved_map unresolved;
 	static ptrhashtable_tpl<obj_desc_t **, int, N_BAGS_SMALL>  fatals;
 
-	static void read_nodes(FILE* fp, obj_desc_t*& data, int register_nodes,uint32 version);
+	struct pending_t;
+	struct pak_file_t;
+	struct parse_queue_t;
+
+	static void read_nodes(FILE* fp, obj_desc_t*& data, int register_nodes, uint32 version, pak_file_t &file);
 	static void skip_nodes(FILE *fp,uint32 version);
 
+	/// Reads the nodes of a pak file. Does nothing that depends on the order of the files.
+	static void parse_file(pak_file_t &file);
+
+	/// Does the rest of the loading of a parsed file in the order of the file, i.e. the registering.
+	static void register_file(pak_file_t &file);
+
+	static void *parse_thread(void *queue);
+
 protected:
 	obj_reader_t() { /* Beware: Cannot register here! */}
 	virtual ~obj_reader_t() {}
@@ -98,6 +110,11 @@ protected:
 	/// Register descriptor so the object described by the descriptor can be built in-game.
 	virtual void register_obj(obj_desc_t *&/*desc*/) {}
 
+	/// read_node() runs on worker threads, while other files are loaded. Readers whose
+	/// read_node() changes anything but the new descriptor must return false here;
+	/// their nodes are read on the main thread in the order of the files.
+	virtual bool can_read_in_parallel() const { return true; }
+
 	/// Does post-loading checks.
 	/// @returns true if everything ok
 	virtual bool successfully_loaded() const { return true; }
@@ -18,6 +18,9 @@ protected:
 	/// @copydoc obj_reader_t::register_obj
 	void register_obj(obj_desc_t *&desc) OVERRIDE;
 
+	/// read_node() loads the sound
+	bool can_read_in_parallel() const OVERRIDE { return false; }
+
 public:
 	static sound_reader_t*instance() { return &the_instance; }
 
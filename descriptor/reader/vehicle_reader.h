@@ -19,6 +19,9 @@ protected:
 	/// @copydoc obj_reader_t::register_obj
 	void register_obj(obj_desc_t*&) OVERRIDE;
 
+	/// read_node() loads the sound
+	bool can_read_in_parallel() const OVERRIDE { return false; }
+
 	/// @copydoc obj_reader_t::successfully_loaded
 	bool successfully_loaded() const OVERRIDE;
 
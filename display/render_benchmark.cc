@@ -0,0 +1,311 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+#include "render_benchmark.h"
+#include "simgraph.h"
+#include "simview.h"
+#include "viewport.h"
+
+#include "../simconst.h"
+#include "../simdebug.h"
+#include "../simworld.h"
+#include "../boden/grund.h"
+#include "../dataobj/environment.h"
+#include "../gui/minimap.h"
+#include "../gui/simwin.h"
+#include "../obj/simobj.h"
+#include "../sys/simsys.h"
+#include "../tpl/vector_tpl.h"
+#include "../utils/cbuffer_t.h"
+
+
+typedef std::chrono::steady_clock benchmark_clock_t;
+
+struct benchmark_position_t
+{
+	koord3d pos;
+	/// zoom factor, or -1 to keep the current one
+	sint8 zoom;
+};
+
+/// an image drawn by the objects of a tile, to draw it again without the view
+struct benchmark_image_t
+{
+	image_id img;
+	scr_coord_val x, y;
+	sint8 player_nr;
+};
+
+enum {
+	PHASE_DISPLAY,
+	PHASE_IMAGES,
+	PHASE_MINIMAP,
+	MAX_PHASES
+};
+
+static const char *phase_names[MAX_PHASES] = { "display", "display_img_aux", "minimap" };
+
+
+static uint32 get_elapsed_us(benchmark_clock_t::time_point start)
+{
+	return (uint32)std::chrono::duration_cast<std::chrono::microseconds>( benchmark_clock_t::now() - start ).count();
+}
+
+
+static bool read_positions(karte_t *welt, const char *filename, vector_tpl<benchmark_position_t> &positions)
+{
+	FILE *file = dr_fopen( filename, "r" );
+	if(  file == NULL  ) {
+		dbg->error( "render_benchmark()", "Cannot open positions file \"%s\"", filename );
+		return false;
+	}
+
+	char line[256];
+	int line_nr = 0;
+	while(  fgets( line, sizeof(line), file )  ) {
+		line_nr++;
+		const char *p = line;
+		while(  *p == ' '  ||  *p == '\t'  ) {
+			p++;
+		}
+		if(  *p == '#'  ||  *p == '\n'  ||  *p == '\r'  ||  *p == 0  ) {
+			continue;
+		}
+
+		int x, y, z, zoom, len = 0;
+		const bool has_z = sscanf( p, "%i,%i,%i%n", &x, &y, &z, &len ) == 3;
+		if(  !has_z  &&  sscanf( p, "%i,%i%n", &x, &y, &len ) != 2  ) {
+			dbg->warning( "render_benchmark()", "%s:%i: expected \"x,y[,z] [zoom]\"", filename, line_nr );
+			continue;
+		}
+		const grund_t *gr = welt->lookup_kartenboden( koord(x, y) );
+		if(  gr == NULL  ) {
+			dbg->warning( "render_benchmark()", "%s:%i: %i,%i is not on the map", filename, line_nr, x, y );
+			continue;
+		}
+
+		benchmark_position_t position;
+		position.pos = koord3d( x, y, has_z ? z : gr->get_hoehe() );
+		position.zoom = sscanf( p + len, "%i", &zoom ) == 1 ? (sint8)clamp( zoom, 0, 9 ) : -1;
+		positions.append( position );
+	}
+	fclose( file );
+
+	if(  positions.empty()  ) {
+		dbg->error( "render_benchmark()", "No positions in \"%s\"", filename );
+		return false;
+	}
+	return true;
+}
+
+
+static void set_zoom(int zoom)
+{
+	while(  get_zoom_factor() > zoom  &&  win_change_zoom_factor( true )  ) {
+	}
+	while(  get_zoom_factor() < zoom  &&  win_change_zoom_factor( false )  ) {
+	}
+}
+
+
+/// collects the images of the ground and the objects on the tiles in view
+static void collect_images(karte_t *welt, vector_tpl<benchmark_image_t> &images)
+{
+	const viewport_t *vp = welt->get_viewport();
+	const scr_coord_val width = display_get_width();
+	const scr_coord_val height = display_get_height();
+	const scr_coord_val raster = get_current_tile_raster_width();
+
+	// a tile is half as high as wide on the screen, and buildings reach upwards
+	const sint16 range = (width + height * 2) / max(1, raster) + 4;
+	const koord centre = vp->get_world_position();
+
+	images.clear();
+	for(  sint16 j = centre.y - range;  j <= centre.y + range;  j++  ) {
+		for(  sint16 i = centre.x - range;  i <= centre.x + range;  i++  ) {
+			const grund_t *gr = welt->lookup_kartenboden( koord(i, j) );
+			if(  gr == NULL  ) {
+				continue;
+			}
+			const scr_coord pos = vp->get_screen_coord( gr->get_pos() );
+			if(  pos.x + raster < 0  ||  pos.x >= width  ||  pos.y + raster < 0  ||  pos.y - raster * 3 >= height  ) {
+				continue;
+			}
+
+			benchmark_image_t image;
+			image.x = pos.x;
+			image.y = pos.y;
+			image.player_nr = PLAYER_UNOWNED;
+			image.img = gr->get_image();
+			if(  image.img != IMG_EMPTY  ) {
+				images.append( image );
+			}
+
+			for(  uint8 n = 0;  n < gr->get_top();  n++  ) {
+				const obj_t *obj = gr->obj_bei( n );
+				image.x = pos.x + tile_raster_scale_x( obj->get_xoff(), raster );
+				image.y = pos.y + tile_raster_scale_y( obj->get_yoff(), raster );
+				image.player_nr = obj->get_owner_nr();
+				image.img = obj->get_image();
+				for(  int h = 1;  image.img != IMG_EMPTY;  h++  ) {
+					images.append( image );
+					// multi-tile high buildings
+					image.y -= raster;
+					image.img = obj->get_image( h );
+				}
+				image.img = obj->get_front_image();
+				if(  image.img != IMG_EMPTY  ) {
+					image.y = pos.y + tile_raster_scale_y( obj->get_yoff(), raster );
+					images.append( image );
+				}
+			}
+		}
+	}
+}
+
+
+static void draw_images(const vector_tpl<benchmark_image_t> &images)
+{
+	FOR( vector_tpl<benchmark_image_t>, const &image, images ) {
+		if(  image.player_nr != PLAYER_UNOWNED  ) {
+			display_color_img( image.img, image.x, image.y, image.player_nr, true, true  CLIP_NUM_DEFAULT );
+		}
+		else {
+			display_img_aux( image.img, image.x, image.y, 0, true, true  CLIP_NUM_DEFAULT );
+		}
+	}
+}
+
+
+/// appends the statistics of these frame times as a JSON object
+static void append_times(cbuffer_t &buf, const vector_tpl<uint32> &times)
+{
+	if(  times.empty()  ) {
+		buf.append( "{}" );
+		return;
+	}
+
+	vector_tpl<uint32> sorted( times );
+	std::sort( sorted.begin(), sorted.end() );
+	uint64 total = 0;
+	FOR( vector_tpl<uint32>, const t, sorted ) {
+		total += t;
+	}
+
+	buf.printf( "{ \"frames\": %u, \"total_us\": %llu, \"mean_us\": %llu, \"median_us\": %u, \"min_us\": %u, \"max_us\": %u, \"first_us\": %u }",
+		sorted.get_count(), (unsigned long long)total, (unsigned long long)(total / sorted.get_count()),
+		sorted[sorted.get_count() / 2], sorted[0], sorted.back(), times[0] );
+}
+
+
+bool render_benchmark(karte_t *welt, main_view_t *view, const char *positions_filename, uint32 frames, const char *json_filename)
+{
+	vector_tpl<benchmark_position_t> positions;
+	if(  !read_positions( welt, positions_filename, positions )  ) {
+		return false;
+	}
+	if(  frames == 0  ) {
+		frames = 1;
+	}
+
+	viewport_t *vp = welt->get_viewport();
+	const koord old_position = vp->get_world_position();
+	const int old_zoom = get_zoom_factor();
+
+	const scr_coord_val width = display_get_width();
+	const scr_coord_val height = display_get_height();
+
+	minimap_t *minimap = minimap_t::get_instance();
+	minimap->init();
+	minimap->set_xy_offset_size( scr_coord(0, 0), scr_size(width, height) );
+
+	vector_tpl<benchmark_image_t> images;
+	vector_tpl<uint32> times[MAX_PHASES];
+	vector_tpl<uint32> all_times[MAX_PHASES];
+
+	cbuffer_t json;
+	json.printf( "{\n\t\"frames\": %u,\n\t\"threads\": %i,\n\t\"width\": %i,\n\t\"height\": %i,\n\t\"colour_depth\": %i,\n\t\"positions\": [\n",
+		frames, env_t::num_threads, width, height, COLOUR_DEPTH );
+
+	FOR( vector_tpl<benchmark_position_t>, const &position, positions ) {
+		if(  position.zoom >= 0  ) {
+			set_zoom( position.zoom );
+		}
+		vp->change_world_position( position.pos );
+		DBG_MESSAGE( "render_benchmark()", "rendering %u frames at %s, zoom %i", frames, position.pos.get_str(), get_zoom_factor() );
+
+		for(  int phase = 0;  phase < MAX_PHASES;  phase++  ) {
+			times[phase].clear();
+		}
+
+		// the whole main view
+		for(  uint32 i = 0;  i < frames;  i++  ) {
+			const benchmark_clock_t::time_point start = benchmark_clock_t::now();
+			view->display( true );
+			times[PHASE_DISPLAY].append( get_elapsed_us( start ) );
+			display_flush_buffer();
+		}
+
+		// only the images of the tiles in view, single threaded
+		collect_images( welt, images );
+		display_set_clip_wh( 0, 0, width, height );
+		for(  uint32 i = 0;  i < frames;  i++  ) {
+			const benchmark_clock_t::time_point start = benchmark_clock_t::now();
+			draw_images( images );
+			times[PHASE_IMAGES].append( get_elapsed_us( start ) );
+			display_flush_buffer();
+		}
+
+		// the minimap of the whole world
+		for(  uint32 i = 0;  i < frames;  i++  ) {
+			const benchmark_clock_t::time_point start = benchmark_clock_t::now();
+			minimap->calc_map();
+			minimap->draw( scr_coord(0, 0) );
+			times[PHASE_MINIMAP].append( get_elapsed_us( start ) );
+			display_flush_buffer();
+		}
+
+		json.printf( "\t\t{ \"x\": %i, \"y\": %i, \"z\": %i, \"zoom\": %i, \"images\": %u,\n", position.pos.x, position.pos.y, position.pos.z, get_zoom_factor(), images.get_count() );
+		for(  int phase = 0;  phase < MAX_PHASES;  phase++  ) {
+			json.printf( "\t\t\t\"%s\": ", phase_names[phase] );
+			append_times( json, times[phase] );
+			json.append( phase + 1 < MAX_PHASES ? ",\n" : "\n" );
+			FOR( vector_tpl<uint32>, const t, times[phase] ) {
+				all_times[phase].append( t );
+			}
+		}
+		json.append( &position == &positions.back() ? "\t\t}\n" : "\t\t},\n" );
+	}
+
+	json.append( "\t],\n\t\"total\": {\n" );
+	for(  int phase = 0;  phase < MAX_PHASES;  phase++  ) {
+		json.printf( "\t\t\"%s\": ", phase_names[phase] );
+		append_times( json, all_times[phase] );
+		json.append( phase + 1 < MAX_PHASES ? ",\n" : "\n" );
+	}
+	json.append( "\t}\n}\n" );
+
+	minimap->finalize();
+	set_zoom( old_zoom );
+	vp->change_world_position( old_position );
+
+	if(  json_filename == NULL  ) {
+		fputs( json.get_str(), stdout );
+		return true;
+	}
+
+	FILE *file = dr_fopen( json_filename, "w" );
+	if(  file == NULL  ) {
+		dbg->error( "render_benchmark()", "Cannot write results to \"%s\"", json_filename );
+		return false;
+	}
+	fputs( json.get_str(), file );
+	fclose( file );
+	return true;
+}
@@ -0,0 +1,35 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef DISPLAY_RENDER_BENCHMARK_H
+#define DISPLAY_RENDER_BENCHMARK_H
+
+
+#include "../simtypes.h"
+
+class karte_t;
+class main_view_t;
+
+
+/**
+ * Renders the loaded game at a list of recorded viewport positions and times
+ * the drawing, so changes to the renderer can be compared on the same map.
+ *
+ * For every position the main view is drawn @p frames times, then the images
+ * on the tiles in view are drawn again on their own with display_img_aux() and
+ * display_color_img(), and the minimap is calculated and drawn. The times of
+ * each of these phases are written as JSON to @p json_filename, or to stdout
+ * if it is NULL.
+ *
+ * The positions file has one position per line: "x,y[,z] [zoom]", with the
+ * zoom factor as used by get_zoom_factor(). Without z the ground height is
+ * used, without zoom the current zoom. Empty lines and lines starting with '#'
+ * are ignored.
+ *
+ * @return false if there were no positions or the results could not be written
+ */
+bool render_benchmark(karte_t *welt, main_view_t *view, const char *positions_filename, uint32 frames, const char *json_filename);
+
+#endif
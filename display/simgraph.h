@@ -170,6 +170,12 @@ bool display_load_font(const char *fname, bool reload = false);
 image_id get_image_count();
 void register_image(class image_t *);
 
+/**
+ * How often a player coloured or day/night recoded image was drawn from the cache
+ * and how often it had to be recoloured first, and the memory of the cache in bytes.
+ */
+void display_get_image_cache_stats(uint64 &hits, uint64 &misses, size_t &bytes);
+
 // delete all images above a certain number ...
 void display_free_all_images_above( image_id above );
 
@@ -507,6 +507,13 @@ image_id get_image_count()
 	return 0;
 }
 
+void display_get_image_cache_stats(uint64 &hits, uint64 &misses, size_t &bytes)
+{
+	hits = 0;
+	misses = 0;
+	bytes = 0;
+}
+
 #ifdef MULTI_THREAD
 void add_poly_clip(int, int, int, int, int  CLIP_NUM_DEF_NOUSE)
 {
@@ -43,6 +43,26 @@
 #	include <unistd.h>
 #endif
 
+// vectorized pixel routines; SSE2 and NEON are always there when the compiler targets them,
+// AVX2 is compiled in on x86 and used when the CPU has it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define SIMGRAPH_SSE2
+#	include <emmintrin.h>
+#	if defined(__GNUC__) || defined(_MSC_VER)
+#		define SIMGRAPH_AVX2
+#		include <immintrin.h>
+#		ifdef __GNUC__
+#			define AVX2_FUNC __attribute__((target("avx2")))
+#		else
+#			include <intrin.h>
+#			define AVX2_FUNC
+#		endif
+#	endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	define SIMGRAPH_NEON
+#	include <arm_neon.h>
+#endif
+
 #ifdef MULTI_THREAD
 #include "../utils/simthread.h"
 
@@ -268,13 +288,13 @@ int default_font_linespace = 0;
  * The following transparent colors are not in the colortable
  * 0x8020 - 0xFFE1: 3 4 3 RGB transparent colors in 31 transparency levels
  */
-static PIXVAL rgbmap_day_night[RGBMAPSIZE];
+static PIXVAL rgbmap_day_night[RGBMAPSIZE+1]; // +1 since the vectorized lookup reads 32 bit per entry
 
 
 /*
  * same as rgbmap_day_night, but always daytime colors
  */
-static PIXVAL rgbmap_all_day[RGBMAPSIZE];
+static PIXVAL rgbmap_all_day[RGBMAPSIZE+1];
 
 
 /*
@@ -323,6 +343,19 @@ static uint8 player_offsets[MAX_PLAYER_COUNT][2];
 /*
  * Image map descriptor structure
  */
+/**
+ * An image recoloured for one player and the current day/night shift.
+ * It is made when the image is first drawn for this player, and freed again
+ * when the cache is over its size and it was not drawn for a long time.
+ */
+struct recoded_img_t {
+	recoded_img_t *next;
+	PIXVAL *data;
+	uint32 len;       // allocated size of data
+	uint32 last_used; // recoded_frame when last drawn
+	sint8 player_nr;
+};
+
 struct imd {
 	sint16 x; // current (zoomed) min x offset
 	sint16 y; // current (zoomed) min y offset
@@ -332,7 +365,7 @@ struct imd {
 	uint8 recode_flags;
 	uint16 player_flags; // bit # is player number, ==1 cache image needs recoding
 
-	PIXVAL* data[MAX_PLAYER_COUNT]; // current data - zoomed and recolored (player + daynight)
+	recoded_img_t* recoded; // current data - zoomed and recolored (player + daynight), for each player drawn
 
 	PIXVAL* zoom_data; // zoomed original data
 	uint32 len;    // current zoom image data size (or base if not zoomed) (used for allocation purposes only)
@@ -362,6 +395,11 @@ struct imd {
 
 static int bitdepth = 16;
 
+#ifdef SIMGRAPH_AVX2
+// set by display_init(), when the CPU supports AVX2
+static bool use_avx2 = false;
+#endif
+
 static scr_coord_val disp_width  = 640;
 static scr_coord_val disp_actual_width  = 640;
 static scr_coord_val disp_height = 480;
@@ -379,6 +417,24 @@ static size_t rezoom_size[MAX_THREADS];
  */
 static struct imd* images = NULL;
 
+/*
+ * The recoloured images: their total size, the frames drawn, how often they were
+ * looked up (per drawing thread) and how often they had to be made.
+ */
+static size_t recoded_bytes = 0;
+static uint32 recoded_frame = 0;
+static uint64 recoded_misses = 0;
+
+struct recoded_lookups_t {
+	uint64 count;
+} GCC_ALIGN(64); // aligned to separate cachelines
+
+#ifdef MULTI_THREAD
+static recoded_lookups_t recoded_lookups[MAX_THREADS];
+#else
+static recoded_lookups_t recoded_lookups;
+#endif
+
 /*
  * Number of loaded images
  */
@@ -1273,6 +1329,52 @@ static void recode()
 }
 
 
+#ifdef SIMGRAPH_AVX2
+/**
+ * Looks up 16 pixels in a colour table (which must have one entry more than the largest pixel).
+ */
+AVX2_FUNC static inline __m256i lookup16_avx2(const PIXVAL *table, const PIXVAL *src)
+{
+	const __m256i lo = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i *)src ) );
+	const __m256i hi = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i *)(src + 8) ) );
+	const __m256i mask = _mm256_set1_epi32( 0xFFFF );
+	// gathers 32 bit at every entry, the lower 16 bit are the looked up pixel
+	const __m256i pix_lo = _mm256_and_si256( _mm256_i32gather_epi32( (const int *)table, lo, 2 ), mask );
+	const __m256i pix_hi = _mm256_and_si256( _mm256_i32gather_epi32( (const int *)table, hi, 2 ), mask );
+	// packing works per 128 bit lane, so restore the order afterwards
+	return _mm256_permute4x64_epi64( _mm256_packus_epi32( pix_lo, pix_hi ), 0xD8 );
+}
+
+
+AVX2_FUNC static PIXVAL lookup_pixels_avx2(PIXVAL *dest, const PIXVAL *src, PIXVAL len, const PIXVAL *table)
+{
+	PIXVAL done = 0;
+	for(  ;  len - done >= 16;  done += 16  ) {
+		_mm256_storeu_si256( (__m256i *)(dest + done), lookup16_avx2( table, src + done ) );
+	}
+	return done;
+}
+#endif
+
+
+/**
+ * Copy pixels through a colour table
+ */
+static inline void lookup_pixels(PIXVAL *dest, const PIXVAL *src, const PIXVAL * const end, const PIXVAL *table)
+{
+#ifdef SIMGRAPH_AVX2
+	if(  use_avx2  &&  end - src >= 16  ) {
+		const PIXVAL done = lookup_pixels_avx2( dest, src, (PIXVAL)(end - src), table );
+		dest += done;
+		src += done;
+	}
+#endif
+	while (src < end) {
+		*dest++ = table[*src++];
+	}
+}
+
+
 // to switch between 15 bit and 16 bit recoding ...
 typedef void (*display_recode_img_src_target_proc)(scr_coord_val h, PIXVAL *src, PIXVAL *target);
 static display_recode_img_src_target_proc recode_img_src_target = NULL;
@@ -1308,9 +1410,9 @@ static void recode_img_src_target_15(scr_coord_val h, PIXVAL *src, PIXVAL *targe
 				}
 				else {
 					// now just convert the color pixels
-					while(  runlen--  ) {
-						*target++ = rgbmap_day_night[*src++];
-					}
+					lookup_pixels( target, src, src + runlen, rgbmap_day_night );
+					target += runlen;
+					src += runlen;
 				}
 				// next clear run or zero = end
 			} while(  (runlen = *target++ = *src++)  );
@@ -1345,9 +1447,9 @@ static void recode_img_src_target_16(scr_coord_val h, PIXVAL *src, PIXVAL *targe
 				}
 				else {
 					// now just convert the color pixels
-					while(  runlen--  ) {
-						*target++ = rgbmap_day_night[*src++];
-					}
+					lookup_pixels( target, src, src + runlen, rgbmap_day_night );
+					target += runlen;
+					src += runlen;
 				}
 				// next clear run or zero = end
 			} while(  (runlen = *target++ = *src++)  );
@@ -1378,12 +1480,31 @@ static void recode_img(const image_id n, const sint8 player_nr)
 #endif
 	PIXVAL *src = images[n].zoom_data != NULL ? images[n].zoom_data : images[n].base_data;
 
-	if(  images[n].data[player_nr] == NULL  ) {
-		images[n].data[player_nr] = MALLOCN( PIXVAL, images[n].len );
+	recoded_img_t *recoded = images[n].recoded;
+	while(  recoded != NULL  &&  recoded->player_nr != player_nr  ) {
+		recoded = recoded->next;
+	}
+	if(  recoded == NULL  ) {
+		recoded = MALLOC( recoded_img_t );
+		recoded->data = MALLOCN( PIXVAL, images[n].len );
+		recoded->len = images[n].len;
+		recoded->last_used = recoded_frame;
+		recoded->player_nr = player_nr;
+		recoded->next = images[n].recoded;
+		// only complete entries are put in the list, since other threads may search it meanwhile
+		images[n].recoded = recoded;
+		recoded_bytes += recoded->len * sizeof(PIXVAL);
+		recoded_misses++;
+	}
+	else if(  recoded->len < images[n].len  ) {
+		// was zoomed in
+		recoded_bytes += (images[n].len - recoded->len) * sizeof(PIXVAL);
+		recoded->data = REALLOC( recoded->data, PIXVAL, images[n].len );
+		recoded->len = images[n].len;
 	}
 	// contains now the player color ...
 	activate_player_color( player_nr, true );
-	recode_img_src_target( images[n].h, src, images[n].data[player_nr] );
+	recode_img_src_target( images[n].h, src, recoded->data );
 	images[n].player_flags &= ~(1<<player_nr);
 #ifdef MULTI_THREAD
 	pthread_mutex_unlock( &recode_img_mutex );
@@ -1391,6 +1512,112 @@ static void recode_img(const image_id n, const sint8 player_nr)
 }
 
 
+/**
+ * The image recoloured for this player, NULL if it was not recoded yet.
+ */
+static inline PIXVAL *get_recoded_img(const image_id n, const sint8 player_nr  CLIP_NUM_DEF)
+{
+	for(  recoded_img_t *recoded = images[n].recoded;  recoded != NULL;  recoded = recoded->next  ) {
+		if(  recoded->player_nr == player_nr  ) {
+			if(  recoded->last_used != recoded_frame  ) {
+				// only written once per frame, since all threads draw the common images
+				recoded->last_used = recoded_frame;
+			}
+			recoded_lookups CLIP_NUM_INDEX .count++;
+			return recoded->data;
+		}
+	}
+	return NULL;
+}
+
+
+static void free_recoded_img(recoded_img_t *recoded)
+{
+	recoded_bytes -= recoded->len * sizeof(PIXVAL);
+	free( recoded->data );
+	free( recoded );
+}
+
+
+struct recoded_age_t {
+	uint32 last_used;
+	uint32 len;
+	bool operator<(const recoded_age_t &other) const { return last_used < other.last_used; }
+};
+
+/**
+ * Frees the recoloured images not drawn for the longest time, when they take more
+ * memory than allowed. Those drawn in this frame are kept, so the limit may be exceeded.
+ * Must not be called while drawing.
+ */
+static void free_old_recoded_images()
+{
+	const size_t budget = (size_t)env_t::image_cache_size << 20;
+	if(  budget == 0  ||  recoded_bytes <= budget  ) {
+		return;
+	}
+	// free down to 3/4 of the limit, so this is not needed every frame
+	const size_t target = budget - budget / 4;
+
+	// find the newest frame to free
+	vector_tpl<recoded_age_t> ages;
+	for(  image_id n = 0;  n < anz_images;  n++  ) {
+		for(  recoded_img_t *recoded = images[n].recoded;  recoded != NULL;  recoded = recoded->next  ) {
+			if(  recoded->last_used != recoded_frame  ) {
+				recoded_age_t age;
+				age.last_used = recoded->last_used;
+				age.len = recoded->len;
+				ages.append( age );
+			}
+		}
+	}
+	if(  ages.empty()  ) {
+		return;
+	}
+	std::sort( ages.begin(), ages.end() );
+
+	size_t bytes = recoded_bytes;
+	uint32 i = 0;
+	while(  i + 1 < ages.get_count()  &&  bytes - ages[i].len * sizeof(PIXVAL) > target  ) {
+		bytes -= ages[i].len * sizeof(PIXVAL);
+		i++;
+	}
+	const uint32 last_frame_to_free = ages[i].last_used;
+
+	for(  image_id n = 0;  n < anz_images;  n++  ) {
+		recoded_img_t **prev = &images[n].recoded;
+		while(  *prev != NULL  ) {
+			recoded_img_t *recoded = *prev;
+			if(  recoded->last_used <= last_frame_to_free  ) {
+				*prev = recoded->next;
+				images[n].player_flags |= 1 << recoded->player_nr;
+				free_recoded_img( recoded );
+			}
+			else {
+				prev = &recoded->next;
+			}
+		}
+	}
+	DBG_DEBUG( "free_old_recoded_images()", "%u kB of recoloured images left", (unsigned)(recoded_bytes >> 10) );
+}
+
+
+void display_get_image_cache_stats(uint64 &hits, uint64 &misses, size_t &bytes)
+{
+	uint64 lookups = 0;
+#ifdef MULTI_THREAD
+	for(  int i = 0;  i < MAX_THREADS;  i++  ) {
+		lookups += recoded_lookups[i].count;
+	}
+#else
+	lookups = recoded_lookups.count;
+#endif
+	misses = recoded_misses;
+	hits = lookups > misses ? lookups - misses : 0;
+	bytes = recoded_bytes;
+}
+
+
 // for zoom out
 #define SumSubpixel(p) \
 	if(*(p)<255  &&  valid<255) { \
@@ -1466,17 +1693,11 @@ static void rezoom_img(const image_id n)
 		images[n].player_flags = 0xFFFF; // recode all player colors
 
 		//  we recalculate the len (since it may be larger than before)
-		// thus we have to free the old caches
+		// thus we have to free the old zoomed image; the recoloured ones grow when recoded
 		if(  images[n].zoom_data != NULL  ) {
 			free( images[n].zoom_data );
 			images[n].zoom_data = NULL;
 		}
-		for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
-			if(  images[n].data[i] != NULL  ) {
-				free( images[n].data[i] );
-				images[n].data[i] = NULL;
-			}
-		}
 
 		// just restore original size?
 		if(  zoom_factor == ZOOM_NEUTRAL  ||  (images[n].recode_flags&FLAG_ZOOMABLE) == 0  ) {
@@ -2198,10 +2419,7 @@ void register_image(image_t *image_in)
 		} while(  runlen!=0  ); // end of row: runlen == 0
 	}
 
-	for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
-		image->data[i] = NULL;
-	}
-
+	image->recoded = NULL;
 	image->zoom_data = NULL;
 	image->len = image_in->len;
 
@@ -2227,10 +2445,9 @@ void display_free_all_images_above( image_id above )
 		if(  images[anz_images].zoom_data != NULL  ) {
 			free( images[anz_images].zoom_data );
 		}
-		for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
-			if(  images[anz_images].data[i] != NULL  ) {
-				free( images[anz_images].data[i] );
-			}
+		while(  recoded_img_t *recoded = images[anz_images].recoded  ) {
+			images[anz_images].recoded = recoded->next;
+			free_recoded_img( recoded );
 		}
 	}
 }
@@ -2282,9 +2499,7 @@ static inline void pixcopy(PIXVAL *dest, const PIXVAL *src, const PIXVAL * const
 static inline void colorpixcopy(PIXVAL* dest, const PIXVAL* src, const PIXVAL* const end)
 {
 	if (*src < 0x8020) {
-		while (src < end) {
-			*dest++ = rgbmap_current[*src++];
-		}
+		lookup_pixels(dest, src, end, rgbmap_current);
 	}
 	else {
 		while (src < end) {
@@ -2320,9 +2535,7 @@ static inline void colorpixcopy(PIXVAL* dest, const PIXVAL* src, const PIXVAL* c
 static inline void colorpixcopy(PIXVAL* dest, const PIXVAL* src, const PIXVAL* const end)
 {
 	if (*src < 0x8020) {
-		while (src < end) {
-			*dest++ = rgbmap_current[*src++];
-		}
+		lookup_pixels(dest, src, end, rgbmap_current);
 	}
 	else {
 		while (src < end) {
@@ -2368,9 +2581,7 @@ static inline void colorpixcopy(PIXVAL* dest, const PIXVAL* src, const PIXVAL* c
 static inline void colorpixcopydaytime(PIXVAL* dest, const PIXVAL* src, const PIXVAL* const end)
 {
 	if (*src < 0x8020) {
-		while (src < end) {
-			*dest++ = rgbmap_current[*src++];
-		}
+		lookup_pixels(dest, src, end, rgbmap_current);
 	}
 	else {
 		while (src < end) {
@@ -2406,9 +2617,7 @@ static inline void colorpixcopydaytime(PIXVAL* dest, const PIXVAL* src, const PI
 static inline void colorpixcopydaytime(PIXVAL* dest, const PIXVAL* src, const PIXVAL* const end)
 {
 	if (*src < 0x8020) {
-		while (src < end) {
-			*dest++ = rgbmap_current[*src++];
-		}
+		lookup_pixels(dest, src, end, rgbmap_current);
 	}
 	else {
 		while (src < end) {
@@ -2696,7 +2905,7 @@ void display_img_aux(const image_id n, scr_coord_val xp, scr_coord_val yp, const
 
 		if(  use_player > 0  ) {
 			// player colour images are rezoomed/recoloured in display_color_img
-			sp = images[n].data[use_player];
+			sp = get_recoded_img( n, use_player  CLIP_NUM_PAR );
 			if(  sp == NULL  ) {
 				dbg->warning("display_img_aux", "CImg[%i] %u failed!", use_player, n);
 				return;
@@ -2710,7 +2919,7 @@ void display_img_aux(const image_id n, scr_coord_val xp, scr_coord_val yp, const
 			else if(  (images[n].player_flags & 1)  ) {
 				recode_img( n, 0 );
 			}
-			sp = images[n].data[0];
+			sp = get_recoded_img( n, 0  CLIP_NUM_PAR );
 			if(  sp == NULL  ) {
 				dbg->warning("display_img_aux", "Img %u failed!", n);
 				return;
@@ -3435,12 +3644,288 @@ static void pix_outline25_16(PIXVAL *dest, const PIXVAL *, const PIXVAL colour,
 }
 
 
+/*
+ * Vectorized versions of the blend routines above, which give exactly the same pixels.
+ * QUARTERS is the share of the source (or colour) in quarters, the masks select 15 or 16 bit.
+ */
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static inline PIXVAL blend_quarters(const PIXVAL src, const PIXVAL dest)
+{
+	switch(  QUARTERS  ) {
+		case 1:  return ((src>>2) & TWO_OUT) + (3*((dest>>2) & TWO_OUT));
+		case 2:  return ((src>>1) & ONE_OUT) + ((dest>>1) & ONE_OUT);
+		default: return (3*((src>>2) & TWO_OUT)) + ((dest>>2) & TWO_OUT);
+	}
+}
+
+
+#ifdef SIMGRAPH_SSE2
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static inline __m128i blend_quarters_sse2(const __m128i src, const __m128i dest)
+{
+	if(  QUARTERS == 2  ) {
+		const __m128i one_out = _mm_set1_epi16( (short)ONE_OUT );
+		return _mm_add_epi16( _mm_and_si128( _mm_srli_epi16( src, 1 ), one_out ), _mm_and_si128( _mm_srli_epi16( dest, 1 ), one_out ) );
+	}
+	const __m128i two_out = _mm_set1_epi16( (short)TWO_OUT );
+	const __m128i s = _mm_and_si128( _mm_srli_epi16( src, 2 ), two_out );
+	const __m128i d = _mm_and_si128( _mm_srli_epi16( dest, 2 ), two_out );
+	if(  QUARTERS == 1  ) {
+		return _mm_add_epi16( s, _mm_add_epi16( d, _mm_add_epi16( d, d ) ) );
+	}
+	return _mm_add_epi16( _mm_add_epi16( s, _mm_add_epi16( s, s ) ), d );
+}
+
+
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static void pix_blend_sse2(PIXVAL *dest, const PIXVAL *src, const PIXVAL , const PIXVAL len)
+{
+	PIXVAL n = len;
+	for(  ;  n >= 8;  n -= 8, dest += 8, src += 8  ) {
+		const __m128i s = _mm_loadu_si128( (const __m128i *)src );
+		const __m128i d = _mm_loadu_si128( (const __m128i *)dest );
+		_mm_storeu_si128( (__m128i *)dest, blend_quarters_sse2<QUARTERS, TWO_OUT, ONE_OUT>( s, d ) );
+	}
+	for(  ;  n > 0;  n--, dest++, src++  ) {
+		*dest = blend_quarters<QUARTERS, TWO_OUT, ONE_OUT>( *src, *dest );
+	}
+}
+
+
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static void pix_blend_recode_sse2(PIXVAL *dest, const PIXVAL *src, const PIXVAL , const PIXVAL len)
+{
+	PIXVAL n = len;
+	for(  ;  n >= 8;  n -= 8, dest += 8, src += 8  ) {
+		const __m128i s = _mm_setr_epi16(
+			rgbmap_current[src[0]], rgbmap_current[src[1]], rgbmap_current[src[2]], rgbmap_current[src[3]],
+			rgbmap_current[src[4]], rgbmap_current[src[5]], rgbmap_current[src[6]], rgbmap_current[src[7]] );
+		const __m128i d = _mm_loadu_si128( (const __m128i *)dest );
+		_mm_storeu_si128( (__m128i *)dest, blend_quarters_sse2<QUARTERS, TWO_OUT, ONE_OUT>( s, d ) );
+	}
+	for(  ;  n > 0;  n--, dest++, src++  ) {
+		*dest = blend_quarters<QUARTERS, TWO_OUT, ONE_OUT>( rgbmap_current[*src], *dest );
+	}
+}
+
+
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static void pix_outline_sse2(PIXVAL *dest, const PIXVAL *, const PIXVAL colour, const PIXVAL len)
+{
+	const __m128i c = _mm_set1_epi16( (short)colour );
+	PIXVAL n = len;
+	for(  ;  n >= 8;  n -= 8, dest += 8  ) {
+		const __m128i d = _mm_loadu_si128( (const __m128i *)dest );
+		_mm_storeu_si128( (__m128i *)dest, blend_quarters_sse2<QUARTERS, TWO_OUT, ONE_OUT>( c, d ) );
+	}
+	for(  ;  n > 0;  n--, dest++  ) {
+		*dest = blend_quarters<QUARTERS, TWO_OUT, ONE_OUT>( colour, *dest );
+	}
+}
+#endif
+
+
+#ifdef SIMGRAPH_AVX2
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+AVX2_FUNC static inline __m256i blend_quarters_avx2(const __m256i src, const __m256i dest)
+{
+	if(  QUARTERS == 2  ) {
+		const __m256i one_out = _mm256_set1_epi16( (short)ONE_OUT );
+		return _mm256_add_epi16( _mm256_and_si256( _mm256_srli_epi16( src, 1 ), one_out ), _mm256_and_si256( _mm256_srli_epi16( dest, 1 ), one_out ) );
+	}
+	const __m256i two_out = _mm256_set1_epi16( (short)TWO_OUT );
+	const __m256i s = _mm256_and_si256( _mm256_srli_epi16( src, 2 ), two_out );
+	const __m256i d = _mm256_and_si256( _mm256_srli_epi16( dest, 2 ), two_out );
+	if(  QUARTERS == 1  ) {
+		return _mm256_add_epi16( s, _mm256_add_epi16( d, _mm256_add_epi16( d, d ) ) );
+	}
+	return _mm256_add_epi16( _mm256_add_epi16( s, _mm256_add_epi16( s, s ) ), d );
+}
+
+
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+AVX2_FUNC static void pix_blend_avx2(PIXVAL *dest, const PIXVAL *src, const PIXVAL , const PIXVAL len)
+{
+	PIXVAL n = len;
+	for(  ;  n >= 16;  n -= 16, dest += 16, src += 16  ) {
+		const __m256i s = _mm256_loadu_si256( (const __m256i *)src );
+		const __m256i d = _mm256_loadu_si256( (const __m256i *)dest );
+		_mm256_storeu_si256( (__m256i *)dest, blend_quarters_avx2<QUARTERS, TWO_OUT, ONE_OUT>( s, d ) );
+	}
+	for(  ;  n > 0;  n--, dest++, src++  ) {
+		*dest = blend_quarters<QUARTERS, TWO_OUT, ONE_OUT>( *src, *dest );
+	}
+}
+
+
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+AVX2_FUNC static void pix_blend_recode_avx2(PIXVAL *dest, const PIXVAL *src, const PIXVAL , const PIXVAL len)
+{
+	PIXVAL n = len;
+	for(  ;  n >= 16;  n -= 16, dest += 16, src += 16  ) {
+		const __m256i s = lookup16_avx2( rgbmap_current, src );
+		const __m256i d = _mm256_loadu_si256( (const __m256i *)dest );
+		_mm256_storeu_si256( (__m256i *)dest, blend_quarters_avx2<QUARTERS, TWO_OUT, ONE_OUT>( s, d ) );
+	}
+	for(  ;  n > 0;  n--, dest++, src++  ) {
+		*dest = blend_quarters<QUARTERS, TWO_OUT, ONE_OUT>( rgbmap_current[*src], *dest );
+	}
+}
+
+
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+AVX2_FUNC static void pix_outline_avx2(PIXVAL *dest, const PIXVAL *, const PIXVAL colour, const PIXVAL len)
+{
+	const __m256i c = _mm256_set1_epi16( (short)colour );
+	PIXVAL n = len;
+	for(  ;  n >= 16;  n -= 16, dest += 16  ) {
+		const __m256i d = _mm256_loadu_si256( (const __m256i *)dest );
+		_mm256_storeu_si256( (__m256i *)dest, blend_quarters_avx2<QUARTERS, TWO_OUT, ONE_OUT>( c, d ) );
+	}
+	for(  ;  n > 0;  n--, dest++  ) {
+		*dest = blend_quarters<QUARTERS, TWO_OUT, ONE_OUT>( colour, *dest );
+	}
+}
+#endif
+
+
+#ifdef SIMGRAPH_NEON
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static inline uint16x8_t blend_quarters_neon(const uint16x8_t src, const uint16x8_t dest)
+{
+	if(  QUARTERS == 2  ) {
+		const uint16x8_t one_out = vdupq_n_u16( ONE_OUT );
+		return vaddq_u16( vandq_u16( vshrq_n_u16( src, 1 ), one_out ), vandq_u16( vshrq_n_u16( dest, 1 ), one_out ) );
+	}
+	const uint16x8_t two_out = vdupq_n_u16( TWO_OUT );
+	const uint16x8_t s = vandq_u16( vshrq_n_u16( src, 2 ), two_out );
+	const uint16x8_t d = vandq_u16( vshrq_n_u16( dest, 2 ), two_out );
+	if(  QUARTERS == 1  ) {
+		return vmlaq_n_u16( s, d, 3 );
+	}
+	return vmlaq_n_u16( d, s, 3 );
+}
+
+
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static void pix_blend_neon(PIXVAL *dest, const PIXVAL *src, const PIXVAL , const PIXVAL len)
+{
+	PIXVAL n = len;
+	for(  ;  n >= 8;  n -= 8, dest += 8, src += 8  ) {
+		vst1q_u16( dest, blend_quarters_neon<QUARTERS, TWO_OUT, ONE_OUT>( vld1q_u16( src ), vld1q_u16( dest ) ) );
+	}
+	for(  ;  n > 0;  n--, dest++, src++  ) {
+		*dest = blend_quarters<QUARTERS, TWO_OUT, ONE_OUT>( *src, *dest );
+	}
+}
+
+
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static void pix_blend_recode_neon(PIXVAL *dest, const PIXVAL *src, const PIXVAL , const PIXVAL len)
+{
+	PIXVAL n = len;
+	PIXVAL pix[8];
+	for(  ;  n >= 8;  n -= 8, dest += 8, src += 8  ) {
+		for(  int i = 0;  i < 8;  i++  ) {
+			pix[i] = rgbmap_current[src[i]];
+		}
+		vst1q_u16( dest, blend_quarters_neon<QUARTERS, TWO_OUT, ONE_OUT>( vld1q_u16( pix ), vld1q_u16( dest ) ) );
+	}
+	for(  ;  n > 0;  n--, dest++, src++  ) {
+		*dest = blend_quarters<QUARTERS, TWO_OUT, ONE_OUT>( rgbmap_current[*src], *dest );
+	}
+}
+
+
+template<int QUARTERS, PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static void pix_outline_neon(PIXVAL *dest, const PIXVAL *, const PIXVAL colour, const PIXVAL len)
+{
+	const uint16x8_t c = vdupq_n_u16( colour );
+	PIXVAL n = len;
+	for(  ;  n >= 8;  n -= 8, dest += 8  ) {
+		vst1q_u16( dest, blend_quarters_neon<QUARTERS, TWO_OUT, ONE_OUT>( c, vld1q_u16( dest ) ) );
+	}
+	for(  ;  n > 0;  n--, dest++  ) {
+		*dest = blend_quarters<QUARTERS, TWO_OUT, ONE_OUT>( colour, *dest );
+	}
+}
+#endif
+
+
 // will kept the actual values
 static blend_proc blend[3];
 static blend_proc blend_recode[3];
 static blend_proc outline[3];
 
 
+/**
+ * Replaces the blend routines by vectorized ones, if the CPU has them.
+ */
+template<PIXVAL TWO_OUT, PIXVAL ONE_OUT>
+static void select_vectorized_blend()
+{
+#ifdef SIMGRAPH_AVX2
+	if(  use_avx2  ) {
+		blend[0] = pix_blend_avx2<1, TWO_OUT, ONE_OUT>;
+		blend[1] = pix_blend_avx2<2, TWO_OUT, ONE_OUT>;
+		blend[2] = pix_blend_avx2<3, TWO_OUT, ONE_OUT>;
+		blend_recode[0] = pix_blend_recode_avx2<1, TWO_OUT, ONE_OUT>;
+		blend_recode[1] = pix_blend_recode_avx2<2, TWO_OUT, ONE_OUT>;
+		blend_recode[2] = pix_blend_recode_avx2<3, TWO_OUT, ONE_OUT>;
+		outline[0] = pix_outline_avx2<1, TWO_OUT, ONE_OUT>;
+		outline[1] = pix_outline_avx2<2, TWO_OUT, ONE_OUT>;
+		outline[2] = pix_outline_avx2<3, TWO_OUT, ONE_OUT>;
+		return;
+	}
+#endif
+#if defined(SIMGRAPH_SSE2)
+	blend[0] = pix_blend_sse2<1, TWO_OUT, ONE_OUT>;
+	blend[1] = pix_blend_sse2<2, TWO_OUT, ONE_OUT>;
+	blend[2] = pix_blend_sse2<3, TWO_OUT, ONE_OUT>;
+	blend_recode[0] = pix_blend_recode_sse2<1, TWO_OUT, ONE_OUT>;
+	blend_recode[1] = pix_blend_recode_sse2<2, TWO_OUT, ONE_OUT>;
+	blend_recode[2] = pix_blend_recode_sse2<3, TWO_OUT, ONE_OUT>;
+	outline[0] = pix_outline_sse2<1, TWO_OUT, ONE_OUT>;
+	outline[1] = pix_outline_sse2<2, TWO_OUT, ONE_OUT>;
+	outline[2] = pix_outline_sse2<3, TWO_OUT, ONE_OUT>;
+#elif defined(SIMGRAPH_NEON)
+	blend[0] = pix_blend_neon<1, TWO_OUT, ONE_OUT>;
+	blend[1] = pix_blend_neon<2, TWO_OUT, ONE_OUT>;
+	blend[2] = pix_blend_neon<3, TWO_OUT, ONE_OUT>;
+	blend_recode[0] = pix_blend_recode_neon<1, TWO_OUT, ONE_OUT>;
+	blend_recode[1] = pix_blend_recode_neon<2, TWO_OUT, ONE_OUT>;
+	blend_recode[2] = pix_blend_recode_neon<3, TWO_OUT, ONE_OUT>;
+	outline[0] = pix_outline_neon<1, TWO_OUT, ONE_OUT>;
+	outline[1] = pix_outline_neon<2, TWO_OUT, ONE_OUT>;
+	outline[2] = pix_outline_neon<3, TWO_OUT, ONE_OUT>;
+#endif
+}
+
+
+#ifdef SIMGRAPH_AVX2
+static bool cpu_has_avx2()
+{
+#ifdef __GNUC__
+	__builtin_cpu_init();
+	return __builtin_cpu_supports( "avx2" );
+#else
+	int info[4];
+	__cpuid( info, 0 );
+	if(  info[0] < 7  ) {
+		return false;
+	}
+	// the OS must save the AVX registers too
+	__cpuid( info, 1 );
+	if(  (info[2] & (1 << 27)) == 0  ||  (info[2] & (1 << 28)) == 0  ||  (_xgetbv( 0 ) & 6) != 6  ) {
+		return false;
+	}
+	__cpuidex( info, 7, 0 );
+	return (info[1] & (1 << 5)) != 0;
+#endif
+}
+#endif
+
+
 /**
  * Blends a rectangular region with a color
  */
@@ -3473,7 +3958,7 @@ void display_blend_wh_rgb(scr_coord_val xp, scr_coord_val yp, scr_coord_val w, s
 
 			default:
 				// any percentage blending: SLOW!
-				if(  blend[0] == pix_blend25_15  ) {
+				if(  bitdepth == 15  ) {
 					// 555 BITMAPS
 					const PIXVAL r_src = (colval >> 10) & 0x1F;
 					const PIXVAL g_src = (colval >> 5) & 0x1F;
@@ -3790,7 +4275,7 @@ void display_rezoomed_img_blend(const image_id n, scr_coord_val xp, scr_coord_va
 		else if(  (images[n].player_flags & 1)  ) {
 			recode_img( n, 0 );
 		}
-		PIXVAL *sp = images[n].data[0];
+		PIXVAL *sp = get_recoded_img( n, 0  CLIP_NUM_PAR );
 
 		// now, since zooming may have change this image
 		xp += images[n].x;
@@ -3874,7 +4359,7 @@ void display_rezoomed_img_alpha(const image_id n, const image_id alpha_n, const
 		if(  (images[alpha_n].recode_flags & FLAG_REZOOM)  ) {
 			rezoom_img( alpha_n );
 		}
-		PIXVAL *sp = images[n].data[0];
+		PIXVAL *sp = get_recoded_img( n, 0  CLIP_NUM_PAR );
 		// alphamap image uses base data as we don't want to recode
 		PIXVAL *alphamap = images[alpha_n].zoom_data != NULL ? images[alpha_n].zoom_data : images[alpha_n].base_data;
 		// now, since zooming may have change this image
@@ -5839,6 +6324,10 @@ void display_flush_buffer()
 	uint32 *tmp = tile_dirty_old;
 	tile_dirty_old = tile_dirty;
 	tile_dirty = tmp; // _old was cleared to 0 in above loops
+
+	// nothing is drawn now, so the recoloured images can be freed
+	free_old_recoded_images();
+	recoded_frame++;
 }
 
 
@@ -5942,6 +6431,11 @@ bool simgraph_init(scr_size window_size, sint16 full_screen)
 	memcpy(transparent_map_all_day, transparent_map_day_night, lengthof(transparent_map_day_night) * sizeof(PIXVAL));
 	memcpy(transparent_map_all_day_rgb, transparent_map_day_night_rgb, lengthof(transparent_map_day_night_rgb) * sizeof(uint8));
 
+#ifdef SIMGRAPH_AVX2
+	use_avx2 = cpu_has_avx2();
+	DBG_MESSAGE("simgraph_init()", "vectorized pixel routines: %s", use_avx2 ? "AVX2" : "SSE2");
+#endif
+
 	// find out bit depth
 	{
 		uint32 c = get_system_color( 0, 255, 0 );
@@ -5963,6 +6457,7 @@ bool simgraph_init(scr_size window_size, sint16 full_screen)
 			alpha = pix_alpha_15;
 			alpha_recode = pix_alpha_recode_15;
 			recode_img_src_target = recode_img_src_target_15;
+			select_vectorized_blend<TWO_OUT_15, ONE_OUT_15>();
 #ifndef RGB555
 			dr_fatal_notify( "Compiled for 16 bit color depth but using 15!" );
 #endif
@@ -5980,6 +6475,7 @@ bool simgraph_init(scr_size window_size, sint16 full_screen)
 			alpha = pix_alpha_16;
 			alpha_recode = pix_alpha_recode_16;
 			recode_img_src_target = recode_img_src_target_16;
+			select_vectorized_blend<TWO_OUT_16, ONE_OUT_16>();
 #ifdef RGB555
 			dr_fatal_notify( "Compiled for 15 bit color depth but using 16!" );
 #endif
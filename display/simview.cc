@@ -47,52 +47,146 @@ static const sint8 hours2night[] =
 #endif
 
 #ifdef MULTI_THREAD
+#include <chrono>
+
 #include "../utils/simthread.h"
+#include "../utils/work_stealing.h"
 
 bool spawned_threads=false; // global job indicator array
 static simthread_barrier_t display_barrier_start;
 static simthread_barrier_t display_barrier_end;
 
-// to start a thread
-typedef struct{
+/* The following mutex is only needed for smart cursor */
+// mutex for changing settings on hiding buildings/trees
+static pthread_mutex_t hide_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool threads_req_pause = false;  // set true to pause all threads to display smartcursor region single threaded
+static uint8 num_threads_paused = 0; // number of threads in the paused state
+static pthread_cond_t hiding_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t waiting_cond = PTHREAD_COND_INITIALIZER;
+
+// at most so many strips per thread; more strips balance better, but each draws the tiles at its seams again
+#define MAX_STRIPS_PER_THREAD (4)
+
+// The view is cut into vertical strips, which the threads take as jobs.
+// Strips (rather than rows) keep the drawing order from top to bottom within each of them.
+static struct {
 	main_view_t *show_routine;
-	koord   lt_cl, wh_cl; // pos/size of clipping rect for this thread
-	koord   lt, wh;       // pos/size of region to display. set larger than clipping for correct display of trees at thread seams
-	sint16  y_min;
-	sint16  y_max;
-	sint8   thread_num;
-} display_region_param_t;
+	scr_rect clip;              // the area of the screen to display
+	scr_coord_val strip_width;  // the last strip reaches to the right edge of clip
+	uint32 strip_count;
+	sint16 y_min;
+	sint16 y_max;
+} display_frame;
+
+static work_stealing_ranges_t display_strips;
+
+// when the threads started and each of them ran out of strips in the last frame
+static std::chrono::steady_clock::time_point display_start_time;
+static std::chrono::steady_clock::time_point display_finish_times[MAX_THREADS];
+
+// microseconds per frame, averaged over about the last 16 frames
+static uint32 display_thread_busy_time[MAX_THREADS];
+static uint32 display_thread_idle_time[MAX_THREADS];
+
+
+static void display_strip( uint32 strip, sint8 thread_num )
+{
+	const sint16 IMG_SIZE = get_tile_raster_width();
+	const scr_rect &clip = display_frame.clip;
+	const scr_coord_val x = clip.x + (scr_coord_val)strip * display_frame.strip_width;
+	const scr_coord_val w = strip + 1 < display_frame.strip_count ? display_frame.strip_width : clip.get_right() - x;
+
+	clear_all_poly_clip( thread_num );
+	display_set_clip_wh( x, clip.y, w, clip.h, thread_num );
+	// process tiles IMG_SIZE/2 outside clipping range for correct tree display at strip seams
+	display_frame.show_routine->display_region( koord( x - IMG_SIZE/2, clip.y ), koord( w + IMG_SIZE, clip.h ), display_frame.y_min, display_frame.y_max, false, true, thread_num );
+}
+
+
+static void display_strips_threaded( sint8 thread_num )
+{
+	uint32 strip;
+	while(  display_strips.get_next( thread_num, strip )  ) {
+		display_strip( strip, thread_num );
+	}
+	display_finish_times[thread_num] = std::chrono::steady_clock::now();
+
+	// show thread as paused when finished
+	pthread_mutex_lock( &hide_mutex );
+	num_threads_paused++;
+	pthread_cond_broadcast( &waiting_cond );
+	pthread_mutex_unlock( &hide_mutex );
+}
+
+
+#if COLOUR_DEPTH != 0
+static void update_display_thread_times()
+{
+	std::chrono::steady_clock::time_point last_finish = display_start_time;
+	for(  int t = 0;  t < env_t::num_threads;  t++  ) {
+		if(  display_finish_times[t] > last_finish  ) {
+			last_finish = display_finish_times[t];
+		}
+	}
+	for(  int t = 0;  t < env_t::num_threads;  t++  ) {
+		const uint32 busy = (uint32)std::chrono::duration_cast<std::chrono::microseconds>( display_finish_times[t] - display_start_time ).count();
+		const uint32 idle = (uint32)std::chrono::duration_cast<std::chrono::microseconds>( last_finish - display_finish_times[t] ).count();
+		display_thread_busy_time[t] = display_thread_busy_time[t] - (display_thread_busy_time[t] >> 4) + (busy >> 4);
+		display_thread_idle_time[t] = display_thread_idle_time[t] - (display_thread_idle_time[t] >> 4) + (idle >> 4);
+	}
+}
+#endif
 
-// now the parameters
-static display_region_param_t ka[MAX_THREADS];
 
 void *display_region_thread( void *ptr )
 {
-	display_region_param_t *view = reinterpret_cast<display_region_param_t *>(ptr);
+	const sint8 thread_num = (sint8)(intptr_t)ptr;
 
 	while(true) {
 		simthread_barrier_wait( &display_barrier_start ); // wait for all to start
-		clear_all_poly_clip( view->thread_num );
-		display_set_clip_wh( view->lt_cl.x, view->lt_cl.y, view->wh_cl.x, view->wh_cl.y, view->thread_num );
-		view->show_routine->display_region( view->lt, view->wh, view->y_min, view->y_max, false, true, view->thread_num );
+		display_strips_threaded( thread_num );
 		simthread_barrier_wait( &display_barrier_end ); // wait for all to finish
 	}
 }
 
-/* The following mutex is only needed for smart cursor */
-// mutex for changing settings on hiding buildings/trees
-static pthread_mutex_t hide_mutex = PTHREAD_MUTEX_INITIALIZER;
-static bool threads_req_pause = false;  // set true to pause all threads to display smartcursor region single threaded
-static uint8 num_threads_paused = 0; // number of threads in the paused state
-static pthread_cond_t hiding_cond = PTHREAD_COND_INITIALIZER;
-static pthread_cond_t waiting_cond = PTHREAD_COND_INITIALIZER;
-
 #if COLOUR_DEPTH != 0
 static bool can_multithreading = true;
 #endif
 #endif
 
 
+uint32 main_view_t::get_thread_count()
+{
+#ifdef MULTI_THREAD
+	return spawned_threads ? env_t::num_threads : 0;
+#else
+	return 0;
+#endif
+}
+
+
+uint32 main_view_t::get_thread_busy_time(uint32 thread_num)
+{
+#ifdef MULTI_THREAD
+	return display_thread_busy_time[thread_num];
+#else
+	(void)thread_num;
+	return 0;
+#endif
+}
+
+
+uint32 main_view_t::get_thread_idle_time(uint32 thread_num)
+{
+#ifdef MULTI_THREAD
+	return display_thread_idle_time[thread_num];
+#else
+	(void)thread_num;
+	return 0;
+#endif
+}
+
+
 void main_view_t::display(bool force_dirty)
 {
 	const uint32 rs = get_random_seed();
@@ -217,7 +311,7 @@ void main_view_t::display(bool force_dirty)
 			simthread_barrier_init( &display_barrier_end, NULL, env_t::num_threads );
 
 			for(  int t = 0;  t < env_t::num_threads - 1;  t++  ) {
-				if(  pthread_create( &thread[t], &attr, display_region_thread, (void *)&ka[t] )  ) {
+				if(  pthread_create( &thread[t], &attr, display_region_thread, (void *)(intptr_t)t )  ) {
 					can_multithreading = false;
 					dbg->error( "main_view_t::display()", "cannot multi-thread, error at thread #%i", t+1 );
 					return;
@@ -227,34 +321,27 @@ void main_view_t::display(bool force_dirty)
 			pthread_attr_destroy( &attr );
 		}
 
-		// set parameter for each thread
-		const scr_coord_val wh_x = clip_rr.w / env_t::num_threads;
-		scr_coord_val lt_x = clip_rr.x;
-		for(  int t = 0;  t < env_t::num_threads - 1;  t++  ) {
-			ka[t].show_routine = this;
-			ka[t].lt_cl = koord( lt_x, clip_rr.y );
-			ka[t].wh_cl = koord( wh_x, clip_rr.h );
-			ka[t].lt = ka[t].lt_cl - koord( IMG_SIZE/2, 0 ); // process tiles IMG_SIZE/2 outside clipping range for correct tree display at thread seams
-			ka[t].wh = ka[t].wh_cl + koord( IMG_SIZE, 0 );
-			ka[t].y_min = y_min;
-			ka[t].y_max = dpy_height + 4 * 4;
-			ka[t].thread_num = t;
-			lt_x += wh_x;
-		}
+		// cut the view into strips of at least two tiles, but at least one per thread
+		int strips = min( clip_rr.w / (2 * IMG_SIZE), env_t::num_threads * MAX_STRIPS_PER_THREAD );
+		strips = max( 1, min( max( strips, (int)env_t::num_threads ), (int)clip_rr.w ) );
+		display_frame.show_routine = this;
+		display_frame.clip = clip_rr;
+		display_frame.strip_width = clip_rr.w / strips;
+		display_frame.strip_count = strips;
+		display_frame.y_min = y_min;
+		display_frame.y_max = dpy_height + 4 * 4;
+		display_strips.init( strips, env_t::num_threads );
 
 		// init variables required to draw smart cursor
 		threads_req_pause = false;
 		num_threads_paused = 0;
 
-		// and start drawing
+		// and start drawing; the main thread takes strips too
+		display_start_time = std::chrono::steady_clock::now();
 		simthread_barrier_wait( &display_barrier_start );
-
-		// the last we can run ourselves, setting clip_wh to the screen edge instead of wh_x (in case disp_width % num_threads != 0)
-		clear_all_poly_clip( env_t::num_threads - 1 );
-		display_set_clip_wh( lt_x, clip_rr.y, clip_rr.w, clip_rr.h, env_t::num_threads - 1 );
-		display_region( koord( lt_x - IMG_SIZE / 2, clip_rr.y ), koord( clip_rr.x + clip_rr.w + IMG_SIZE, clip_rr.h ), y_min, dpy_height + 4 * 4, false, true, env_t::num_threads - 1 );
-
+		display_strips_threaded( env_t::num_threads - 1 );
 		simthread_barrier_wait( &display_barrier_end );
+		update_display_thread_times();
 
 		clear_all_poly_clip( 0 );
 		display_set_clip_wh(clip_rr.x, clip_rr.y, clip_rr.w, clip_rr.h);
@@ -366,6 +453,24 @@ void main_view_t::clear_prepared() const
 }
 
 
+/**
+ * The first column x of a row which is not left of the pixel column left, that is,
+ * x * (IMG_SIZE/2) + x_off + IMG_SIZE > left. Columns of a row are x_start + 2*n.
+ */
+static inline sint16 get_first_column( sint16 x_start, int left, int x_off, int IMG_SIZE )
+{
+	const int half = IMG_SIZE / 2;
+	const int limit = left - IMG_SIZE - x_off;
+	// smallest x with x * half > limit; the division truncates towards zero
+	int x = limit / half;
+	if(  x * half <= limit  ) {
+		x++;
+	}
+	x += (x - x_start) & 1;
+	return (sint16)max( x, (int)x_start );
+}
+
+
 #ifdef MULTI_THREAD
 void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max, bool /*force_dirty*/, bool threaded, const sint8 clip_num )
 #else
@@ -393,7 +498,7 @@ void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max
 		// plotted = we plotted something
 		bool plotted = false;
 
-		for(  sint16 x = -2 - ((y  +dpy_width) & 1);  (x * (IMG_SIZE / 2) + const_x_off) < (lt.x + wh.x);  x += 2  ) {
+		for(  sint16 x = get_first_column( -2 - ((y + dpy_width) & 1), lt.x, const_x_off, IMG_SIZE );  (x * (IMG_SIZE / 2) + const_x_off) < (lt.x + wh.x);  x += 2  ) {
 			const sint16 i = ((y + x) >> 1) + i_off;
 			const sint16 j = ((y - x) >> 1) + j_off;
 			const sint16 xpos = x * (IMG_SIZE / 2) + const_x_off;
@@ -469,7 +574,7 @@ void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max
 	for(  int y = y_min;  y < y_max;  y++  ) {
 		const sint16 ypos = y * (IMG_SIZE / 4) + const_y_off;
 
-		for(  sint16 x = -2 - ((y + dpy_width) & 1);  (x * (IMG_SIZE / 2) + const_x_off) < (lt.x + wh.x);  x += 2  ) {
+		for(  sint16 x = get_first_column( -2 - ((y + dpy_width) & 1), lt.x, const_x_off, IMG_SIZE );  (x * (IMG_SIZE / 2) + const_x_off) < (lt.x + wh.x);  x += 2  ) {
 			const int i = ((y + x) >> 1) + i_off;
 			const int j = ((y - x) >> 1) + j_off;
 			const int xpos = x * (IMG_SIZE / 2) + const_x_off;
@@ -580,15 +685,6 @@ void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max
 			}
 		}
 	}
-#ifdef MULTI_THREAD
-	// show thread as paused when finished
-	if(  threaded  ) {
-		pthread_mutex_lock( &hide_mutex );
-		num_threads_paused++;
-		pthread_cond_broadcast( &waiting_cond );
-		pthread_mutex_unlock( &hide_mutex );
-	}
-#endif
 }
 
 
@@ -48,6 +48,15 @@ public:
 	 */
 	void clear_prepared() const;
 
+	/**
+	 * Number of threads which display the view (0 if not multi-threaded),
+	 * and the time in microseconds each of them spent displaying and waiting
+	 * for the others per frame, averaged over recent frames.
+	 */
+	static uint32 get_thread_count();
+	static uint32 get_thread_busy_time(uint32 thread_num);
+	static uint32 get_thread_idle_time(uint32 thread_num);
+
 	/**
 	 * Draws the simulated world in the specified rectangular area of the pixel buffer. This is a internal function of the class.
 	 * <br>
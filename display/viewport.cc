@@ -61,6 +61,20 @@ scr_coord viewport_t::get_screen_coord( const koord3d& pos, const koord& off) co
 }
 
 
+bool viewport_t::is_far_from_view(const koord3d &pos) const
+{
+	if(  cached_img_size <= 0  ) {
+		// nothing shown at all
+		return true;
+	}
+	// the screen spans disp_width/img_size tiles along i-j and 2*disp_height/img_size along i+j
+	// around the center; add some tiles for high buildings and mountains
+	const sint32 radius = (cached_disp_width/2 + cached_disp_height) / cached_img_size + 8;
+	const koord dist = get_map2d_coord( pos ) - get_world_position();
+	return abs(dist.x) > radius  ||  abs(dist.y) > radius;
+}
+
+
 scr_coord viewport_t::scale_offset( const koord &value )
 {
 	return scr_coord(tile_raster_scale_x( value.x, cached_img_size ), tile_raster_scale_y( value.x, cached_img_size ));
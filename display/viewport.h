@@ -145,6 +145,13 @@ public:
 			get_world_position() == get_map2d_coord( pos ) );
 	}
 
+	/**
+	 * Checks a 3d in-map coordinate, to know if it's well outside of the area shown by the viewport.
+	 * @param pos 3D map coordinate to check.
+	 * @return true if nothing at this position can be seen, false otherwise.
+	 */
+	bool is_far_from_view(const koord3d &pos) const;
+
 	/**
 	 * @}
 	 */
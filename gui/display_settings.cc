@@ -12,9 +12,11 @@
 #include "../dataobj/settings.h"
 #include "../dataobj/environment.h"
 #include "../dataobj/translator.h"
+#include "../dataobj/private_car_routes.h"
 #include "../obj/baum.h"
 #include "../obj/zeiger.h"
 #include "../display/simgraph.h"
+#include "../display/simview.h"
 #include "../simmenu.h"
 #include "../player/simplay.h"
 #include "../utils/simstring.h"
@@ -304,6 +306,24 @@ gui_settings_t::gui_settings_t()
 		cities_to_process_label.set_color(SYSCOL_TEXT_TITLE);
 		cities_to_process_label.update();
 		add_component(&cities_to_process_label);
+
+		new_component<gui_label_t>("Convoy threads busy:");
+		convoy_threads_label.buf().printf("-");
+		convoy_threads_label.set_color(SYSCOL_TEXT_TITLE);
+		convoy_threads_label.update();
+		add_component(&convoy_threads_label);
+
+		new_component<gui_label_t>("Display threads busy:");
+		display_threads_label.buf().printf("-");
+		display_threads_label.set_color(SYSCOL_TEXT_TITLE);
+		display_threads_label.update();
+		add_component(&display_threads_label);
+
+		new_component<gui_label_t>("Recoloured image cache:");
+		image_cache_label.buf().printf("-");
+		image_cache_label.set_color(SYSCOL_TEXT_TITLE);
+		image_cache_label.update();
+		add_component(&image_cache_label);
 	}
 	end_table();
 }
@@ -366,7 +386,7 @@ void gui_settings_t::draw(scr_coord offset)
 	reroute_goods_label.buf().printf("%lu", path_explorer_t::get_limit_reroute_goods());
 	reroute_goods_label.update();
 
-	reading_index_label.buf().printf("%lu", weg_t::private_car_routes_currently_reading_element);
+	reading_index_label.buf().printf("%lu", private_car_routes_t::get_reading_table());
 	reading_index_label.update();
 
 	cities_awaiting_private_car_route_check_label.buf().printf("%lu", world()->get_cities_awaiting_private_car_route_check_count());
@@ -375,6 +395,47 @@ void gui_settings_t::draw(scr_coord offset)
 	cities_to_process_label.buf().printf("%i", world()->get_cities_to_process());
 	cities_to_process_label.update();
 
+	// the share of the time the convoy threads spend working rather than waiting for each other
+	const uint32 convoy_threads = world()->get_convoy_thread_count();
+	if(  convoy_threads > 0  ) {
+		uint64 busy = 0, idle = 0;
+		for(  uint32 i = 0;  i < convoy_threads;  i++  ) {
+			busy += world()->get_convoy_thread_busy_time(i);
+			idle += world()->get_convoy_thread_idle_time(i);
+		}
+		const uint32 percent = busy + idle > 0 ? (uint32)((busy * 100) / (busy + idle)) : 100;
+		convoy_threads_label.buf().printf("%u%% (idle %u us)", percent, (uint32)(idle / convoy_threads));
+	}
+	else {
+		convoy_threads_label.buf().printf("-");
+	}
+	convoy_threads_label.update();
+
+	// the same for each of the threads which display the main view
+	const uint32 display_threads = main_view_t::get_thread_count();
+	if(  display_threads > 0  ) {
+		cbuffer_t &buf = display_threads_label.buf();
+		uint64 idle = 0;
+		for(  uint32 i = 0;  i < display_threads;  i++  ) {
+			const uint32 busy_i = main_view_t::get_thread_busy_time(i);
+			const uint32 idle_i = main_view_t::get_thread_idle_time(i);
+			buf.printf(i > 0 ? " %u" : "%u", busy_i + idle_i > 0 ? (uint32)(((uint64)busy_i * 100) / (busy_i + idle_i)) : 100);
+			idle += idle_i;
+		}
+		buf.printf("%% (idle %u us)", (uint32)(idle / display_threads));
+	}
+	else {
+		display_threads_label.buf().printf("-");
+	}
+	display_threads_label.update();
+
+	uint64 image_cache_hits, image_cache_misses;
+	size_t image_cache_bytes;
+	display_get_image_cache_stats(image_cache_hits, image_cache_misses, image_cache_bytes);
+	const uint64 image_cache_lookups = image_cache_hits + image_cache_misses;
+	image_cache_label.buf().printf("%u MB, %u%% hits", (uint32)(image_cache_bytes >> 20), image_cache_lookups > 0 ? (uint32)((image_cache_hits * 100) / image_cache_lookups) : 100);
+	image_cache_label.update();
+
 	// All components are updated, now draw them...
 	gui_aligned_container_t::draw(offset);
 }
@@ -41,7 +41,11 @@ private:
 
 		reading_index_label,
 		cities_awaiting_private_car_route_check_label,
-		cities_to_process_label;
+		cities_to_process_label,
+
+		convoy_threads_label,
+		display_threads_label,
+		image_cache_label;
 
 public:
 	button_t toolbar_pos[4];
@@ -146,7 +146,11 @@ static const char *revision_ex[] =
 	"60",
 	"61",
 	"62",
-	"63"
+	"63",
+	"64",
+	"65",
+	"66",
+	"67"
 };
 
 
@@ -254,6 +258,8 @@ void settings_extended_general_stats_t::init( settings_t *sets )
 
 	INIT_NUM("path_explorer_time_midpoint", sets->get_path_explorer_time_midpoint(), 1, 2048, gui_numberinput_t::PLAIN, false);
 	INIT_BOOL("save_path_explorer_data", sets->get_save_path_explorer_data());
+	INIT_NUM("path_explorer_incremental_threshold", sets->get_path_explorer_incremental_threshold(), 0, 65535, gui_numberinput_t::PLAIN, false);
+	INIT_NUM("path_explorer_compact_threshold", sets->get_path_explorer_compact_threshold(), 0, 65535, gui_numberinput_t::PLAIN, false);
 
 	SEPERATOR;
 
@@ -379,6 +385,8 @@ void settings_extended_general_stats_t::read(settings_t *sets)
 
 	READ_NUM_VALUE(sets->path_explorer_time_midpoint);
 	READ_BOOL_VALUE(sets->save_path_explorer_data);
+	READ_NUM_VALUE(sets->path_explorer_incremental_threshold);
+	READ_NUM_VALUE(sets->path_explorer_compact_threshold);
 
 	READ_BOOL_VALUE(env_t::pause_server_no_clients);
 	READ_BOOL_VALUE(env_t::server_runs_background_tasks_when_paused);
@@ -14,6 +14,36 @@
 class grund_t;
 
 
+/**
+ * Everything apart from the ways themselves which check_next_tile() and get_cost()
+ * of a driver depend on. Drivers with equal profiles find the same routes.
+ */
+struct route_profile_t
+{
+	sint32 min_speed;            // compared to the minimum speed of signs
+	uint32 axle_load;            // only if weight limits are enforced, else 0
+	uint32 weight;               // only if weight limits are enforced, else 0
+	uint8 owner_nr;
+	uint8 access_owner_nr;       // owner of the way the driver is on, any_owner if all ways may be used
+	uint8 waytype;               // of the vehicle, e.g. for depots
+	uint8 way_permissive;        // combined way constraints of all vehicles
+	uint8 way_prohibitive;
+	bool needs_electrification;
+	bool override_way_speed;
+	bool speed_limited;
+
+	enum { no_owner = 0xFF, any_owner = 0xFE };
+
+	bool operator==(const route_profile_t &o) const
+	{
+		return min_speed == o.min_speed  &&  axle_load == o.axle_load  &&  weight == o.weight  &&  owner_nr == o.owner_nr  &&
+			access_owner_nr == o.access_owner_nr  &&  waytype == o.waytype  &&  way_permissive == o.way_permissive  &&
+			way_prohibitive == o.way_prohibitive  &&  needs_electrification == o.needs_electrification  &&
+			override_way_speed == o.override_way_speed  &&  speed_limited == o.speed_limited;
+	}
+};
+
+
 /**
  * Interface to connect the vehicle with its route
  */
@@ -41,6 +71,16 @@ public:
 
 	// return the cost of a single step upwards
 	virtual uint32 get_cost_upslope() const { return 0; } // Standard is 25
+
+	// lower bound of get_cost() for any tile, not counting slopes; used to estimate the remaining cost of a route
+	virtual uint32 get_min_cost() const { return 0; }
+
+	/**
+	 * Describe this driver for sharing routes with others (see route_cache_t).
+	 * @returns false if the routes of this driver must not be shared,
+	 * e.g. because they depend on the current block reservations.
+	 */
+	virtual bool get_route_profile(route_profile_t &) const { return false; }
 };
 
 #endif
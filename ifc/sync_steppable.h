@@ -26,6 +26,15 @@ public:
 	 */
 	virtual sync_result sync_step(uint32 delta_t) = 0;
 
+	/**
+	 * Ticks from now on for which sync_step() would only count down time.
+	 * The object is then left out of the sync steps until the idle time is over.
+	 * When it is due again, it first gets one sync_step() with the time it was
+	 * left out except the current step (which must not do more than counting
+	 * down), then the normal sync_step() of the current step.
+	 */
+	virtual uint32 get_sync_idle_ticks() const { return 0; }
+
 	virtual ~sync_steppable() {}
 };
 
@@ -82,3 +82,23 @@ size_t raw_file_rdwr_stream_t::write(const void *buf, size_t len)
 
 	return bytes_written;
 }
+
+
+bool raw_file_rdwr_stream_t::seek(sint64 offset, int origin)
+{
+#ifdef _MSC_VER
+	return _fseeki64(file, offset, origin) == 0;
+#else
+	return fseeko(file, (off_t)offset, origin) == 0;
+#endif
+}
+
+
+sint64 raw_file_rdwr_stream_t::tell() const
+{
+#ifdef _MSC_VER
+	return _ftelli64(file);
+#else
+	return ftello(file);
+#endif
+}
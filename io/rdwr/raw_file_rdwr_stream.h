@@ -31,6 +31,14 @@ public:
 	/// @copydoc rdwr_stream_t::write
 	size_t write(const void *buf, size_t len) OVERRIDE;
 
+protected:
+	/// Moves the position in the file, like fseek().
+	/// @returns false on failure
+	bool seek(sint64 offset, int origin);
+
+	/// @returns the position in the file, or -1 on failure
+	sint64 tell() const;
+
 private:
 	FILE *file;
 };
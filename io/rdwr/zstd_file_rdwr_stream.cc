@@ -9,13 +9,54 @@
 #include "../../simdebug.h"
 #include "../../simmem.h"
 
+#include <cstring>
+
 
 #define ZSTD_FILE_BUF_SIZE (1 << 20) // 1MiB
 
+// uncompressed data per frame; smaller frames spread better over the workers but compress worse
+#define ZSTD_FRAME_SIZE (1 << 22) // 4MiB
+
+// files with larger frames in their seek table are read as a stream
+#define ZSTD_MAX_FRAME_SIZE (1 << 26) // 64MiB
+
+// seek table as in the zstd seekable format, see contrib/seekable_format in the zstd sources
+#define ZSTD_SKIPPABLE_MAGIC (0x184D2A5E)
+#define ZSTD_SEEKABLE_MAGIC (0x8F92EAB1)
+#define ZSTD_SKIPPABLE_HEADER_SIZE (8)
+#define ZSTD_SEEK_TABLE_FOOTER_SIZE (9)
+#define ZSTD_SEEK_TABLE_CHECKSUM_FLAG (0x80)
+#define ZSTD_SEEK_TABLE_RESERVED_BITS (0x7C)
+
+
+static void put_le32(uint8 *p, uint32 v)
+{
+	v = endian(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+
+static uint32 get_le32(const uint8 *p)
+{
+	uint32 v;
+	memcpy(&v, p, sizeof(v));
+	return endian(v);
+}
+
 
 zstd_file_rdwr_stream_t::zstd_file_rdwr_stream_t(const std::string &filename, bool writing, int compression_level) :
 	raw_file_rdwr_stream_t(filename, writing),
-	zbuff(NULL)
+	compression_level(compression_level),
+	zbuff(NULL),
+	compression_context(NULL),
+	decompression_context(NULL),
+	use_frames(false),
+	frames(NULL),
+	window(0),
+	queued(0),
+	claimed(0),
+	finished(0),
+	frame_pos(0)
 {
 	if (status != STATUS_OK) {
 		return; // Could not open file
@@ -29,36 +70,13 @@ zstd_file_rdwr_stream_t::zstd_file_rdwr_stream_t(const std::string &filename, bo
 			status = STATUS_ERR_CORRUPT;
 			return;
 		}
-#if ZSTD_VERSION_MAJOR<=1  &&  ZSTD_VERSION_MINOR<=3
-		ZSTD_initCStream( compression_context, compression_level );
-#else
-		size_t ret1 = ZSTD_CCtx_setParameter( compression_context, ZSTD_c_compressionLevel, compression_level );
-		if (ZSTD_isError(ret1)) {
-			dbg->error("zstd_file_rdwr_stream_t::zstd_file_rdwr_stream_t", "Cannot set compression level: %s", ZSTD_getErrorName(ret1));
-			status = STATUS_ERR_CORRUPT;
-			return;
-		}
-
-// 		const size_t ret2 = ZSTD_CCtx_setParameter( compression_context, ZSTD_c_checksumFlag, 1 );
-// 		if (ZSTD_isError(ret2)) {
-// 			dbg->error("zstd_file_rdwr_stream_t::zstd_file_rdwr_stream_t", "Cannot enable file checksumming: %s", ZSTD_getErrorName(ret2));
-// 			status = STATUS_ERR_CORRUPT;
-// 			return;
-// 		}
-
-#ifdef MULTI_THREAD
-		ret1 = ZSTD_CCtx_setParameter( compression_context, ZSTD_c_nbWorkers, env_t::num_threads );
-		if (ZSTD_isError(ret1)) {
-			// since compression should continue anyway, do not stop!
-			dbg->warning("zstd_file_rdwr_stream_t::zstd_file_rdwr_stream_t", "Cannot set workers: %s", ZSTD_getErrorName(ret1));
-		}
-#endif
 
-#endif
 		// the additional magic for zstd
 		if (raw_file_rdwr_stream_t::write("ZD", 2) != 2) {
 			return;
 		}
+
+		use_frames = true;
 	}
 	else {
 		// decompressing
@@ -78,20 +96,19 @@ zstd_file_rdwr_stream_t::zstd_file_rdwr_stream_t(const std::string &filename, bo
 			status = STATUS_ERR_CORRUPT;
 			return;
 		}
-	}
-
-	zbuff = xmalloc(ZSTD_FILE_BUF_SIZE);
 
-	if (writing) {
-		zin.src = NULL;
-		zin.size = 0;
-		zin.pos = 0;
+		use_frames = read_seek_table();
+		if (status != STATUS_OK) {
+			return;
+		}
+	}
 
-		zout.dst = zbuff;
-		zout.size = ZSTD_FILE_BUF_SIZE;
-		zout.pos = 0;
+	if (use_frames) {
+		start_workers();
 	}
 	else {
+		zbuff = xmalloc(ZSTD_FILE_BUF_SIZE);
+
 		zin.src = zbuff;
 		zin.size = ZSTD_FILE_BUF_SIZE;
 		zin.pos = ZSTD_FILE_BUF_SIZE;
@@ -107,30 +124,31 @@ zstd_file_rdwr_stream_t::zstd_file_rdwr_stream_t(const std::string &filename, bo
 
 zstd_file_rdwr_stream_t::~zstd_file_rdwr_stream_t()
 {
-	if (is_writing()) {
-		// write zero length dummy to indicate end of data
-		zin.src = "";
-		zin.size = 0;
-		zin.pos = 0;
+	if (frames) {
+		if (is_writing()  &&  status == STATUS_OK) {
+			// the last frame is usually not full
+			if (queued - finished < window  &&  frames[queued % window].src_len > 0) {
+				submit_frame();
+			}
 
-		zout.dst = zbuff;
-		zout.size = ZSTD_FILE_BUF_SIZE;
-		zout.pos = 0;
+			while (finished < queued  &&  write_frame()) {
+			}
 
-		size_t ret;
-		do {
-			zout.pos = 0;
-			ret = ZSTD_endStream( compression_context, &zout );
-			if (ZSTD_isError(ret)) {
-				dbg->error("zstd_file_rdwr_stream_t::~zstd_file_rdwr_stream_t", "Error flushing stream: %s", ZSTD_getErrorName(ret));
+			if (status == STATUS_OK) {
+				write_seek_table();
 			}
+			if (status != STATUS_OK) {
+				dbg->error("zstd_file_rdwr_stream_t::~zstd_file_rdwr_stream_t", "Error flushing stream");
+			}
+		}
 
-			raw_file_rdwr_stream_t::write( zout.dst, zout.pos );
-		} while( ret>0 );
+		stop_workers();
+	}
 
+	if (compression_context) {
 		ZSTD_freeCCtx( compression_context );
 	}
-	else {
+	if (decompression_context) {
 		ZSTD_freeDCtx( decompression_context );
 	}
 
@@ -138,7 +156,392 @@ zstd_file_rdwr_stream_t::~zstd_file_rdwr_stream_t()
 }
 
 
+bool zstd_file_rdwr_stream_t::read_seek_table()
+{
+	const sint64 data_start = tell();
+	const bool found = parse_seek_table(data_start);
+
+	// whatever was read, continue at the first frame
+	status = STATUS_OK;
+	if (!seek(data_start, SEEK_SET)) {
+		status = STATUS_ERR_CORRUPT;
+		return false;
+	}
+	if (!found) {
+		seek_table.clear();
+	}
+	return found;
+}
+
+
+bool zstd_file_rdwr_stream_t::parse_seek_table(sint64 data_start)
+{
+	uint8 footer[ZSTD_SEEK_TABLE_FOOTER_SIZE];
+	if (data_start < 0  ||  !seek(-ZSTD_SEEK_TABLE_FOOTER_SIZE, SEEK_END)) {
+		return false;
+	}
+	const sint64 table_end = tell() + ZSTD_SEEK_TABLE_FOOTER_SIZE;
+	if (raw_file_rdwr_stream_t::read(footer, sizeof(footer)) != sizeof(footer)) {
+		return false;
+	}
+
+	const uint32 frame_count = get_le32(footer);
+	const uint8 descriptor = footer[4];
+	if (get_le32(footer + 5) != ZSTD_SEEKABLE_MAGIC  ||  (descriptor & ZSTD_SEEK_TABLE_RESERVED_BITS)  ||  frame_count > (1u << 24)) {
+		// no seek table (e.g. written by older versions) or one we do not understand
+		return false;
+	}
+
+	const uint32 entry_size = (descriptor & ZSTD_SEEK_TABLE_CHECKSUM_FLAG) ? 12 : 8;
+	const uint32 table_size = frame_count * entry_size + ZSTD_SEEK_TABLE_FOOTER_SIZE;
+	const sint64 table_start = table_end - table_size - ZSTD_SKIPPABLE_HEADER_SIZE;
+	if (table_start < data_start  ||  !seek(table_start, SEEK_SET)) {
+		return false;
+	}
+
+	uint8 header[ZSTD_SKIPPABLE_HEADER_SIZE];
+	if (raw_file_rdwr_stream_t::read(header, sizeof(header)) != sizeof(header)) {
+		return false;
+	}
+	if (get_le32(header) != ZSTD_SKIPPABLE_MAGIC  ||  get_le32(header + 4) != table_size) {
+		return false;
+	}
+
+	const uint32 entries_size = frame_count * entry_size;
+	uint8 *entries = MALLOCN(uint8, entries_size + 1);
+	if (entries_size > 0  &&  raw_file_rdwr_stream_t::read(entries, entries_size) != entries_size) {
+		free(entries);
+		return false;
+	}
+
+	bool valid = true;
+	sint64 data_size = 0;
+	seek_table.resize(frame_count);
+	for (uint32 i = 0; i < frame_count  &&  valid; i++) {
+		frame_size_t frame;
+		frame.compressed = get_le32(entries + i * entry_size);
+		frame.decompressed = get_le32(entries + i * entry_size + 4);
+		valid = frame.decompressed <= ZSTD_MAX_FRAME_SIZE  &&  frame.compressed <= ZSTD_compressBound(ZSTD_MAX_FRAME_SIZE);
+		data_size += frame.compressed;
+		seek_table.append(frame);
+	}
+	free(entries);
+
+	// the frames must fill the file up to the seek table
+	return valid  &&  data_start + data_size == table_start;
+}
+
+
+void zstd_file_rdwr_stream_t::write_seek_table()
+{
+	const uint32 frame_count = seek_table.get_count();
+	const uint32 table_size = frame_count * 8 + ZSTD_SEEK_TABLE_FOOTER_SIZE;
+
+	const uint32 size = ZSTD_SKIPPABLE_HEADER_SIZE + table_size;
+	uint8 *table = MALLOCN(uint8, size);
+
+	uint8 *p = table;
+	put_le32(p, ZSTD_SKIPPABLE_MAGIC);
+	put_le32(p + 4, table_size);
+	p += ZSTD_SKIPPABLE_HEADER_SIZE;
+
+	FOR(vector_tpl<frame_size_t>, const &frame, seek_table) {
+		put_le32(p, frame.compressed);
+		put_le32(p + 4, frame.decompressed);
+		p += 8;
+	}
+
+	put_le32(p, frame_count);
+	p[4] = 0; // no checksums
+	put_le32(p + 5, ZSTD_SEEKABLE_MAGIC);
+
+	if (raw_file_rdwr_stream_t::write(table, size) != size) {
+		status = STATUS_ERR_FULL;
+	}
+	free(table);
+}
+
+
+void zstd_file_rdwr_stream_t::start_workers()
+{
+	uint32 worker_count = 0;
+#ifdef MULTI_THREAD
+	if (env_t::num_threads > 1) {
+		worker_count = env_t::num_threads;
+	}
+#endif
+	// enough frames to keep all workers busy while the oldest one is written or read
+	window = worker_count + 2;
+
+	frames = new frame_t[window];
+	for (uint32 i = 0; i < window; i++) {
+		frame_t &frame = frames[i];
+		frame.src = NULL;
+		frame.src_len = 0;
+		frame.src_size = 0;
+		frame.dst = NULL;
+		frame.dst_len = 0;
+		frame.dst_size = 0;
+		frame.done = false;
+		frame.failed = false;
+
+		if (is_writing()) {
+			frame.src_size = ZSTD_FRAME_SIZE;
+			frame.src = (char *)xmalloc(frame.src_size);
+			frame.dst_size = ZSTD_compressBound(ZSTD_FRAME_SIZE);
+			frame.dst = (char *)xmalloc(frame.dst_size);
+		}
+	}
+
+#ifdef MULTI_THREAD
+	pthread_mutex_init(&queue_mutex, NULL);
+	pthread_cond_init(&work_cond, NULL);
+	pthread_cond_init(&done_cond, NULL);
+	stopping = false;
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	for (uint32 i = 0; i < worker_count; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, &attr, worker_thread, (void *)this) != 0) {
+			dbg->warning("zstd_file_rdwr_stream_t::start_workers", "Could only start %u of %u workers", i, worker_count);
+			break;
+		}
+		workers.append(thread);
+	}
+	pthread_attr_destroy(&attr);
+#endif
+}
+
+
+void zstd_file_rdwr_stream_t::stop_workers()
+{
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&queue_mutex);
+	stopping = true;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&queue_mutex);
+
+	FOR(vector_tpl<pthread_t>, const &thread, workers) {
+		pthread_join(thread, NULL);
+	}
+	workers.clear();
+
+	pthread_cond_destroy(&done_cond);
+	pthread_cond_destroy(&work_cond);
+	pthread_mutex_destroy(&queue_mutex);
+#endif
+
+	for (uint32 i = 0; i < window; i++) {
+		free(frames[i].src);
+		free(frames[i].dst);
+	}
+	delete [] frames;
+	frames = NULL;
+}
+
+
+#ifdef MULTI_THREAD
+void *zstd_file_rdwr_stream_t::worker_thread(void *ptr)
+{
+	zstd_file_rdwr_stream_t *stream = reinterpret_cast<zstd_file_rdwr_stream_t *>(ptr);
+
+	// every worker needs its own context
+	void *context = stream->is_writing() ? (void *)ZSTD_createCCtx() : (void *)ZSTD_createDCtx();
+
+	pthread_mutex_lock(&stream->queue_mutex);
+	while (true) {
+		while (!stream->stopping  &&  stream->claimed == stream->queued) {
+			pthread_cond_wait(&stream->work_cond, &stream->queue_mutex);
+		}
+		if (stream->stopping) {
+			break;
+		}
+
+		frame_t &frame = stream->frames[stream->claimed % stream->window];
+		stream->claimed++;
+		pthread_mutex_unlock(&stream->queue_mutex);
+
+		stream->process_frame(frame, context);
+
+		pthread_mutex_lock(&stream->queue_mutex);
+		frame.done = true;
+		pthread_cond_broadcast(&stream->done_cond);
+	}
+	pthread_mutex_unlock(&stream->queue_mutex);
+
+	if (stream->is_writing()) {
+		ZSTD_freeCCtx((ZSTD_CCtx *)context);
+	}
+	else {
+		ZSTD_freeDCtx((ZSTD_DCtx *)context);
+	}
+	return NULL;
+}
+#endif
+
+
+void zstd_file_rdwr_stream_t::process_frame(frame_t &frame, void *context) const
+{
+	if (context == NULL) {
+		frame.failed = true;
+		return;
+	}
+
+	if (is_writing()) {
+		const size_t ret = ZSTD_compressCCtx((ZSTD_CCtx *)context, frame.dst, frame.dst_size, frame.src, frame.src_len, compression_level);
+		frame.failed = ZSTD_isError(ret);
+		frame.dst_len = frame.failed ? 0 : ret;
+	}
+	else {
+		const size_t ret = ZSTD_decompressDCtx((ZSTD_DCtx *)context, frame.dst, frame.dst_len, frame.src, frame.src_len);
+		frame.failed = ZSTD_isError(ret)  ||  ret != frame.dst_len;
+	}
+}
+
+
+void zstd_file_rdwr_stream_t::submit_frame()
+{
+	frame_t &frame = frames[queued % window];
+	frame.done = false;
+	frame.failed = false;
+
+#ifdef MULTI_THREAD
+	if (!workers.empty()) {
+		pthread_mutex_lock(&queue_mutex);
+		queued++;
+		pthread_cond_signal(&work_cond);
+		pthread_mutex_unlock(&queue_mutex);
+		return;
+	}
+#endif
+
+	process_frame(frame, is_writing() ? (void *)compression_context : (void *)decompression_context);
+	frame.done = true;
+	queued++;
+	claimed++;
+}
+
+
+zstd_file_rdwr_stream_t::frame_t &zstd_file_rdwr_stream_t::wait_for_frame()
+{
+	frame_t &frame = frames[finished % window];
+
+#ifdef MULTI_THREAD
+	if (!workers.empty()) {
+		pthread_mutex_lock(&queue_mutex);
+		while (!frame.done) {
+			pthread_cond_wait(&done_cond, &queue_mutex);
+		}
+		pthread_mutex_unlock(&queue_mutex);
+	}
+#endif
+
+	return frame;
+}
+
+
+bool zstd_file_rdwr_stream_t::write_frame()
+{
+	frame_t &frame = wait_for_frame();
+	if (frame.failed) {
+		dbg->error("zstd_file_rdwr_stream_t::write", "Error during compression of frame %u", finished);
+		status = STATUS_ERR_CORRUPT;
+		return false;
+	}
+
+	if (raw_file_rdwr_stream_t::write(frame.dst, frame.dst_len) != frame.dst_len) {
+		status = STATUS_ERR_FULL;
+		return false;
+	}
+
+	frame_size_t size;
+	size.compressed = (uint32)frame.dst_len;
+	size.decompressed = (uint32)frame.src_len;
+	seek_table.append(size);
+
+	frame.src_len = 0;
+	finished++;
+	return true;
+}
+
+
+bool zstd_file_rdwr_stream_t::fetch_frame()
+{
+	frame_t &frame = frames[queued % window];
+	const frame_size_t &size = seek_table[queued];
+
+	if (frame.src_size < size.compressed) {
+		frame.src = (char *)xrealloc(frame.src, size.compressed);
+		frame.src_size = size.compressed;
+	}
+	if (frame.dst_size < size.decompressed) {
+		frame.dst = (char *)xrealloc(frame.dst, size.decompressed);
+		frame.dst_size = size.decompressed;
+	}
+
+	if (size.compressed > 0  &&  raw_file_rdwr_stream_t::read(frame.src, size.compressed) != size.compressed) {
+		dbg->error("zstd_file_rdwr_stream_t::read", "Frame %u is truncated", queued);
+		status = STATUS_ERR_CORRUPT;
+		return false;
+	}
+
+	frame.src_len = size.compressed;
+	frame.dst_len = size.decompressed;
+	submit_frame();
+	return true;
+}
+
+
 size_t zstd_file_rdwr_stream_t::read(void *buf, size_t len)
+{
+	if (!use_frames) {
+		return read_stream(buf, len);
+	}
+
+	size_t copied = 0;
+	while (copied < len) {
+		// keep the workers busy with the next frames
+		while (queued < seek_table.get_count()  &&  queued - finished < window) {
+			if (!fetch_frame()) {
+				return 0;
+			}
+		}
+
+		if (finished == queued) {
+			// end of decompressed data reached
+			status = STATUS_EOF;
+			return copied;
+		}
+
+		frame_t &frame = wait_for_frame();
+		if (frame.failed) {
+			dbg->error("zstd_file_rdwr_stream_t::read", "Error during decompression of frame %u", finished);
+			status = STATUS_ERR_CORRUPT;
+			return 0;
+		}
+
+		size_t count = frame.dst_len - frame_pos;
+		if (count > len - copied) {
+			count = len - copied;
+		}
+		memcpy((char *)buf + copied, frame.dst + frame_pos, count);
+		copied += count;
+		frame_pos += count;
+
+		if (frame_pos == frame.dst_len) {
+			finished++;
+			frame_pos = 0;
+		}
+	}
+
+	status = STATUS_OK;
+	return copied;
+}
+
+
+size_t zstd_file_rdwr_stream_t::read_stream(void *buf, size_t len)
 {
 	zout.dst = buf;
 	zout.size = len;
@@ -146,6 +549,7 @@ size_t zstd_file_rdwr_stream_t::read(void *buf, size_t len)
 
 	do {
 		// first decompress from remaining input buffer
+		// (at the end of a frame the next one follows, if there is any)
 		while(  zin.pos < zin.size  &&  zout.pos < zout.size  ) {
 			const size_t ret = ZSTD_decompressStream( decompression_context, &zout, &zin );
 			if (ZSTD_isError(ret)) {
@@ -153,10 +557,6 @@ size_t zstd_file_rdwr_stream_t::read(void *buf, size_t len)
 				status = STATUS_ERR_CORRUPT;
 				return 0;
 			}
-
-			if(  ret == 0  ) {
-				zout.size = zout.pos;
-			}
 		}
 
 		// not enough data to fill output buffer => read more data from file
@@ -188,26 +588,35 @@ size_t zstd_file_rdwr_stream_t::read(void *buf, size_t len)
 
 size_t zstd_file_rdwr_stream_t::write(const void *buf, size_t len)
 {
-	// compress the next data
-	zin.src = buf;
-	zin.size = len;
-	zin.pos = 0;
+	if(  frames == NULL  ) {
+		return 0; // could not start
+	}
 
-	while(  zin.pos < zin.size  ) {
-		zout.pos = 0;
+	const char *src = (const char *)buf;
+	size_t left = len;
 
-		const size_t ret = ZSTD_compressStream( compression_context, &zout, &zin );
-		if (ZSTD_isError(ret)) {
-			dbg->error("zstd_file_rdwr_stream_t::write", "Error during compression: %s", ZSTD_getErrorName(ret));
-			status = STATUS_ERR_CORRUPT;
-			return 0;
+	while(  left > 0  ) {
+		if(  queued - finished == window  ) {
+			// all frames in flight: make room by writing the oldest one
+			if(  !write_frame()  ) {
+				return 0;
+			}
 		}
 
-		if (raw_file_rdwr_stream_t::write( zout.dst, zout.pos ) != zout.pos) {
-			status = STATUS_ERR_FULL;
-			return 0;
+		frame_t &frame = frames[queued % window];
+		size_t count = frame.src_size - frame.src_len;
+		if(  count > left  ) {
+			count = left;
+		}
+		memcpy(frame.src + frame.src_len, src, count);
+		frame.src_len += count;
+		src += count;
+		left -= count;
+
+		if(  frame.src_len == frame.src_size  ) {
+			submit_frame();
 		}
 	}
 
-	return zin.pos;
+	return len;
 }
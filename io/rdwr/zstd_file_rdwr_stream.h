@@ -8,16 +8,29 @@
 
 
 #include "raw_file_rdwr_stream.h"
+#include "../../tpl/vector_tpl.h"
 
 #include <zstd.h>
 
+#ifdef MULTI_THREAD
+#include "../../utils/simthread.h"
+#endif
+
 
 #if !USE_ZSTD
 #  error "Cannot use zstd_file_rdwr_stream_t: zstd not enabled"
 #endif
 
 
-/// Reads/writes data data from/to a zstd compressed file.
+/**
+ * Reads/writes data data from/to a zstd compressed file.
+ *
+ * The data is written as a sequence of independent zstd frames, which are
+ * compressed by a pool of worker threads, followed by a seek table in a
+ * skippable frame (zstd seekable format). Any zstd decoder reads this as one
+ * stream. When reading a file with a seek table, the frames are decompressed
+ * by the workers ahead of the reader; other files are decompressed as a stream.
+ */
 class zstd_file_rdwr_stream_t : public raw_file_rdwr_stream_t
 {
 public:
@@ -32,12 +45,92 @@ public:
 	size_t write(const void *buf, size_t len) OVERRIDE;
 
 private:
+	/// one entry of the seek table
+	struct frame_size_t
+	{
+		uint32 compressed;
+		uint32 decompressed;
+	};
+
+	/// a frame in the queue of the workers
+	struct frame_t
+	{
+		char *src;
+		size_t src_len;
+		size_t src_size; ///< allocated size of src
+
+		char *dst;
+		size_t dst_len;
+		size_t dst_size; ///< allocated size of dst
+
+		bool done;
+		bool failed;
+	};
+
+	/// reads the seek table at the end of the file, leaves the file at the first frame
+	bool read_seek_table();
+	bool parse_seek_table(sint64 data_start);
+
+	void write_seek_table();
+
+	/// decompresses the data as one stream, for files without seek table
+	size_t read_stream(void *buf, size_t len);
+
+	/// (de)compresses a frame with the given context
+	void process_frame(frame_t &frame, void *context) const;
+
+	/// hands the next frame to the workers
+	void submit_frame();
+
+	/// waits until the oldest frame in the queue is done
+	frame_t &wait_for_frame();
+
+	/// writes the oldest frame in the queue to the file
+	bool write_frame();
+
+	/// reads the compressed data of the next frame from the file
+	bool fetch_frame();
+
+	void start_workers();
+	void stop_workers();
+
+	int compression_level;
+
 	void *zbuff; // buffer for compressed data, i.e. file <-> zbuff
 
 	ZSTD_inBuffer zin;
 	ZSTD_outBuffer zout;
 	ZSTD_CCtx *compression_context;
 	ZSTD_DCtx *decompression_context;
+
+	/// true when reading frame by frame along the seek table
+	bool use_frames;
+
+	vector_tpl<frame_size_t> seek_table;
+
+	/// frames in flight, used as a ring
+	frame_t *frames;
+	uint32 window;
+
+	/// frames handed to the workers so far
+	uint32 queued;
+	/// frames picked up by the workers so far
+	uint32 claimed;
+	/// frames written to the file or read by the caller so far
+	uint32 finished;
+
+	/// read position in the oldest frame
+	size_t frame_pos;
+
+#ifdef MULTI_THREAD
+	static void *worker_thread(void *ptr);
+
+	vector_tpl<pthread_t> workers;
+	pthread_mutex_t queue_mutex;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	bool stopping;
+#endif
 };
 
 #endif
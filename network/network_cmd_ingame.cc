@@ -765,6 +765,9 @@ void nwc_sync_t::do_command(karte_t *welt)
 		}
 
 		// save game
+		// (this cannot be done in the background, since the server reloads the game like the clients;
+		// but a background save still running should finish first)
+		welt->check_background_save(true);
 		sprintf( fn, "server%d-network.sve", env_t::server );
 		bool old_restore_UI = env_t::restore_UI;
 		env_t::restore_UI = true;
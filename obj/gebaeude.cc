@@ -42,6 +42,8 @@ static pthread_mutex_t add_to_city_mutex = PTHREAD_MUTEX_INITIALIZER;
 #include "../dataobj/settings.h"
 #include "../dataobj/environment.h"
 
+#include "../display/viewport.h"
+
 #include "../gui/building_info.h"
 #include "../gui/headquarter_info.h"
 #include "../gui/obj_info.h"
@@ -559,7 +561,9 @@ sync_result gebaeude_t::sync_step(uint32 delta_t)
 			// normal animated building
 			anim_time += delta_t;
 			if (anim_time > tile->get_desc()->get_animation_time()) {
-				anim_time -= tile->get_desc()->get_animation_time();
+				// after being idle, skip the phases nobody has seen
+				const uint16 animation_time = tile->get_desc()->get_animation_time();
+				anim_time = animation_time ? anim_time % animation_time : 0;
 
 				// old positions need redraw
 				if (background_animated) {
@@ -589,6 +593,22 @@ sync_result gebaeude_t::sync_step(uint32 delta_t)
 }
 
 
+uint32 gebaeude_t::get_sync_idle_ticks() const
+{
+	if (show_construction) {
+		// nothing to do until the construction ends
+		const sint64 remaining = construction_start + 5001 - welt->get_ticks();
+		return remaining > 0 ? (uint32)remaining : 0;
+	}
+	const viewport_t *vp = welt->get_viewport();
+	if (!vp || vp->is_far_from_view(get_pos())) {
+		// nobody sees the animation: look again later
+		return 4096;
+	}
+	return 0;
+}
+
+
 
 void gebaeude_t::calc_image()
 {
@@ -240,6 +240,11 @@ public:
 	 */
 	sync_result sync_step(uint32 delta_t) OVERRIDE;
 
+	/**
+	 * Idle while under construction and while far from the viewport.
+	 */
+	uint32 get_sync_idle_ticks() const OVERRIDE;
+
 	void set_tile( const building_tile_desc_t *t, bool start_with_construction );
 
 	const building_tile_desc_t *get_tile() const { return tile; }
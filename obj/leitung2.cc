@@ -99,7 +99,7 @@ leitung_t::leitung_t(typ type, loadsave_t *file) : obj_t(type)
 {
 	city = NULL;
 	image = IMG_EMPTY;
-	set_net(NULL);
+	net = NULL;
 	ribi = ribi_t::none;
 	rdwr(file);
 	modified_production_delta_t = welt->calc_adjusted_monthly_figure(PRODUCTION_DELTA_T);
@@ -112,7 +112,7 @@ leitung_t::leitung_t(loadsave_t *file) : obj_t()
 {
 	city = NULL;
 	image = IMG_EMPTY;
-	set_net(NULL);
+	net = NULL;
 	ribi = ribi_t::none;
 	rdwr(file);
 	modified_production_delta_t = welt->calc_adjusted_monthly_figure(PRODUCTION_DELTA_T);
@@ -124,7 +124,7 @@ leitung_t::leitung_t(typ type, koord3d pos, player_t *player) : obj_t(type, pos)
 {
 	city = NULL;
 	image = IMG_EMPTY;
-	set_net(NULL);
+	net = NULL;
 	set_owner( player );
 	set_desc(way_builder_t::leitung_desc);
 	modified_production_delta_t = welt->calc_adjusted_monthly_figure(PRODUCTION_DELTA_T);
@@ -137,7 +137,7 @@ leitung_t::leitung_t(koord3d pos, player_t *player) : obj_t(pos)
 {
 	city = NULL;
 	image = IMG_EMPTY;
-	set_net(NULL);
+	net = NULL;
 	set_owner( player );
 	set_desc(way_builder_t::leitung_desc);
 	modified_production_delta_t = welt->calc_adjusted_monthly_figure(PRODUCTION_DELTA_T);
@@ -157,17 +157,12 @@ leitung_t::~leitung_t()
 		gr->obj_remove(this);
 		set_flag( obj_t::not_on_map );
 
-		if(neighbours>1) {
-			// only reconnect if two connections ...
-			bool first = true;
+		if(neighbours>0) {
+			// The neighbours get new nets in the next step. Even a single neighbour is
+			// recorded: it may be the only one left of a gap made by removing several lines.
 			for(int i=0; i<4; i++) {
 				if(conn[i]!=NULL) {
-					if(!first) {
-						// replace both nets
-						powernet_t *new_net = new powernet_t();
-						conn[i]->replace(new_net);
-					}
-					first = false;
+					split_positions.append(conn[i]->get_pos());
 				}
 			}
 		}
@@ -179,13 +174,12 @@ leitung_t::~leitung_t()
 			}
 		}
 
-		if(neighbours==0) {
-			delete net;
-		}
 		if(!gr->ist_tunnel()) {
 			player_t::add_maintenance(get_owner(), -desc->get_maintenance(), powerline_wt);
 		}
 	}
+	// deletes the net if this was the last powerline of it
+	set_net(NULL);
 }
 
 
@@ -221,26 +215,30 @@ void leitung_t::rotate90()
 }
 
 
-/**
- * replace networks connection
- * non-trivial to handle transformers correctly
- */
-void leitung_t::replace(powernet_t* new_net)
+vector_tpl<koord3d> leitung_t::split_positions;
+
+
+powernet_t *leitung_t::get_net() const
 {
-	if (get_net() != new_net) {
-		// convert myself ...
-//DBG_MESSAGE("leitung_t::replace()","My net %p by %p at (%i,%i)",new_net,current,base_pos.x,base_pos.y);
-		set_net(new_net);
-	}
+	return net ? net->get_root() : NULL;
+}
 
-	leitung_t * conn[4];
-	if(gimme_neighbours(conn)>0) {
-		for(int i=0; i<4; i++) {
-			if(conn[i] && conn[i]->get_net()!=new_net) {
-				conn[i]->replace(new_net);
-			}
-		}
+
+void leitung_t::set_net(powernet_t *p)
+{
+	if(  p  ) {
+		p->add_reference();
 	}
+	if(  net  ) {
+		net->release();
+	}
+	net = p;
+}
+
+
+void leitung_t::new_world()
+{
+	split_positions.clear();
 }
 
 
@@ -251,41 +249,62 @@ void leitung_t::replace(powernet_t* new_net)
 void leitung_t::verbinde()
 {
 	// first get my own ...
-	powernet_t *new_net = get_net();
-//DBG_MESSAGE("leitung_t::verbinde()","Searching net at (%i,%i)",get_pos().x,get_pos().x);
+	powernet_t *new_net = net ? net->find_root() : NULL;
 	leitung_t * conn[4];
 	if(gimme_neighbours(conn)>0) {
-		for( uint8 i=0;  i<4 && new_net==NULL;  i++  ) {
-			if(conn[i]) {
-				new_net = conn[i]->get_net();
+		for( uint8 i=0;  i<4;  i++  ) {
+			if(conn[i]  &&  conn[i]->net) {
+				new_net = new_net ? powernet_t::merge(new_net, conn[i]->net) : conn[i]->net->find_root();
 			}
 		}
 	}
 
-//DBG_MESSAGE("leitung_t::verbinde()","Found net %p",new_net);
+	// we are alone? then we start a new net
+	if(new_net==NULL) {
+		new_net = new powernet_t();
+	}
+	set_net(new_net);
 
-	// we are alone?
-	if(get_net()==NULL) {
-		if(new_net!=NULL) {
-			replace(new_net);
-		}
-		else {
-			// then we start a new net
-			set_net(new powernet_t());
-//DBG_MESSAGE("leitung_t::verbinde()","Creating new net %p",new_net);
+	// keep the way to the root short for the neighbours, too
+	for( uint8 i=0;  i<4;  i++  ) {
+		if(conn[i]  &&  conn[i]->net  &&  conn[i]->net!=new_net) {
+			conn[i]->set_net(new_net);
 		}
 	}
-	else if(new_net) {
-		powernet_t *my_net = get_net();
-		for( uint8 i=0;  i<4;  i++  ) {
-			if(conn[i] && conn[i]->get_net()!=new_net) {
-				conn[i]->replace(new_net);
-			}
+}
+
+
+void leitung_t::split_nets()
+{
+	// the nets created here: powerlines in them were already reached
+	vector_tpl<powernet_t *> new_nets;
+	vector_tpl<leitung_t *> open;
+
+	FOR(vector_tpl<koord3d>, const &pos, split_positions) {
+		const grund_t *gr = welt->lookup(pos);
+		leitung_t *start = gr ? gr->get_leitung() : NULL;
+		if(  start == NULL  ||  new_nets.is_contained(start->net)  ) {
+			continue;
 		}
-		if(my_net && my_net!=new_net) {
-			delete my_net;
+
+		powernet_t *new_net = new powernet_t();
+		new_nets.append(new_net);
+		start->set_net(new_net);
+		open.append(start);
+		while(  !open.empty()  ) {
+			leitung_t *lt = open.pop_back();
+			leitung_t *conn[4];
+			if(  lt->gimme_neighbours(conn) > 0  ) {
+				for(  uint8 i=0;  i<4;  i++  ) {
+					if(  conn[i]  &&  conn[i]->net != new_net  ) {
+						conn[i]->set_net(new_net);
+						open.append(conn[i]);
+					}
+				}
+			}
 		}
 	}
+	split_positions.clear();
 }
 
 
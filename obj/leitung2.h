@@ -13,6 +13,7 @@
 #include "../simcity.h"
 #include "simobj.h"
 #include "../tpl/slist_tpl.h"
+#include "../tpl/vector_tpl.h"
 
 #define POWER_TO_MW (12)  // bitshift for converting internal power values to mW for display. This is equivalent to dividing by 5,000
 #define KW_DIVIDER (5) // Divider for converting internal power to kW for display. A bitshift will not suffice, so use a divider.
@@ -34,10 +35,13 @@ protected:
 	ribi_t::ribi ribi:4;
 
 	/**
-	* We are part of this network
+	* We are part of this network (or a network merged into it, see get_net)
 	*/
 	powernet_t * net;
 
+	/// Powerlines next to removed ones, which may no longer be connected to the rest of their network
+	static vector_tpl<koord3d> split_positions;
+
 	const way_desc_t *desc;
 
 	fabrik_t *fab;
@@ -48,8 +52,6 @@ protected:
 	*/
 	void verbinde();
 
-	void replace(powernet_t* neu);
-
 	void add_ribi(ribi_t::ribi r) { ribi |= r; }
 
 	/**
@@ -65,8 +67,18 @@ protected:
 	sint32 modified_production_delta_t;
 
 public:
-	powernet_t* get_net() const { return net; }
-	void set_net(powernet_t* p) { net = p; }
+	powernet_t* get_net() const;
+	void set_net(powernet_t* p);
+
+	/// Must be called when a new map is started or loaded.
+	static void new_world();
+
+	/**
+	 * Give the powerlines no longer connected to the network they are in
+	 * (after a powerline was removed) networks of their own: each part
+	 * reached from a recorded neighbour, which is still there, gets a new one.
+	 */
+	static void split_nets();
 
 	const way_desc_t * get_desc() { return desc; }
 	void set_desc(const way_desc_t *new_desc) { desc = new_desc; }
@@ -15,6 +15,8 @@
 
 #include "../tpl/vector_tpl.h"
 
+#include "../display/viewport.h"
+
 
 vector_tpl<const skin_desc_t *>wolke_t::all_clouds(0);
 
@@ -128,6 +130,17 @@ sync_result wolke_t::sync_step(uint32 delta_t)
 }
 
 
+uint32 wolke_t::get_sync_idle_ticks() const
+{
+	const viewport_t *vp = welt->get_viewport();
+	if (!vp || vp->is_far_from_view(get_pos())) {
+		// nobody sees the cloud: only wait for it to vanish
+		return 2499 - purchase_time;
+	}
+	return 0;
+}
+
+
 // called during map rotation
 void wolke_t::rotate90()
 {
@@ -42,6 +42,9 @@ public:
 
 	sync_result sync_step(uint32 delta_t) OVERRIDE;
 
+	/// far from the viewport, the cloud only waits to vanish
+	uint32 get_sync_idle_ticks() const OVERRIDE;
+
 	const char* get_name() const OVERRIDE { return "Wolke"; }
 #ifdef INLINE_OBJ_TYPE
 #else
@@ -3,9 +3,12 @@
  * (see LICENSE.txt)
  */
 
+#include <algorithm>
+
 #include "path_explorer.h"
 
 #include "tpl/slist_tpl.h"
+#include "tpl/binary_heap_tpl.h"
 #include "dataobj/translator.h"
 #include "bauer/goods_manager.h"
 #include "descriptor/goods_desc.h"
@@ -16,6 +19,16 @@
 #include "dataobj/schedule.h"
 #include "simconvoi.h"
 #include "simloadingscreen.h"
+#ifdef MULTI_THREAD
+#include "utils/simthread.h"
+#endif
+
+#ifdef SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SIMD_AVX2
+#include <immintrin.h>
+#endif
 
 
 // #define DEBUG_EXPLORER_SPEED
@@ -38,10 +51,86 @@ uint32 path_explorer_t::compartment_t::time_midpoint;
 uint32 path_explorer_t::compartment_t::time_lower_limit;
 uint32 path_explorer_t::compartment_t::time_upper_limit;
 uint32 path_explorer_t::compartment_t::time_threshold;
+uint32 path_explorer_t::compartment_t::incremental_threshold;
+uint32 path_explorer_t::compartment_t::compact_threshold;
 bool path_explorer_t::must_refresh_on_loading;
 
 #ifdef MULTI_THREAD
 bool thread_local path_explorer_t::allow_path_explorer_on_this_thread = false;
+
+static vector_tpl<pthread_t> path_explorer_worker_threads;
+static simthread_barrier_t path_explorer_worker_barrier;
+static bool path_explorer_workers_terminating = false;
+
+void *path_explorer_worker_threaded(void* args)
+{
+	const uint32 thread_number = *(const uint32*)args;
+	delete (const uint32*)args;
+
+	while (true)
+	{
+		simthread_barrier_wait(&path_explorer_worker_barrier);
+		if (path_explorer_workers_terminating)
+		{
+			return NULL;
+		}
+		path_explorer_t::compartment_t::parallel_compartment->explore_parallel_origins(thread_number);
+		simthread_barrier_wait(&path_explorer_worker_barrier);
+	}
+
+	return NULL;
+}
+
+void path_explorer_t::initialise_workers(const uint32 count)
+{
+	if (count == 0 || compartment_t::worker_count > 0)
+	{
+		return;
+	}
+
+	path_explorer_workers_terminating = false;
+	simthread_barrier_init(&path_explorer_worker_barrier, NULL, count + 1);
+
+	pthread_attr_t thread_attributes;
+	pthread_attr_init(&thread_attributes);
+	pthread_attr_setdetachstate(&thread_attributes, PTHREAD_CREATE_JOINABLE);
+	for (uint32 i = 1; i <= count; i++)
+	{
+		pthread_t thread;
+		uint32* thread_number = new uint32;
+		*thread_number = i;
+		const int rc = pthread_create(&thread, &thread_attributes, &path_explorer_worker_threaded, (void*)thread_number);
+		if (rc)
+		{
+			dbg->fatal("void path_explorer_t::initialise_workers()", "Failed to create path explorer worker thread, error %d. See here for a translation of the error numbers: http://epydoc.sourceforge.net/stdlib/errno-module.html", rc);
+		}
+		path_explorer_worker_threads.append(thread);
+	}
+	pthread_attr_destroy(&thread_attributes);
+
+	compartment_t::worker_count = count;
+}
+
+void path_explorer_t::finalise_workers()
+{
+	if (compartment_t::worker_count == 0)
+	{
+		return;
+	}
+
+	// no transfer can be explored in parallel from here on
+	compartment_t::worker_count = 0;
+
+	path_explorer_workers_terminating = true;
+	simthread_barrier_wait(&path_explorer_worker_barrier);
+	FOR(vector_tpl<pthread_t>, const thread, path_explorer_worker_threads)
+	{
+		pthread_join(thread, NULL);
+	}
+	path_explorer_worker_threads.clear();
+	simthread_barrier_destroy(&path_explorer_worker_barrier);
+	path_explorer_workers_terminating = false;
+}
 #endif
 
 void path_explorer_t::initialise(karte_t *welt)
@@ -276,7 +365,8 @@ void path_explorer_t::step()
 	{
 		if ( current_compartment_category != category_empty
 			 && (!goods_compartment[current_compartment_category][current_compartment_class].is_refresh_completed()
-			     || goods_compartment[current_compartment_category][current_compartment_class].is_refresh_requested() ) )
+			     || goods_compartment[current_compartment_category][current_compartment_class].is_refresh_requested()
+			     || goods_compartment[current_compartment_category][current_compartment_class].is_compacting() ) )
 		{
 			processing = true;	// this step performs something
 			// perform step
@@ -418,7 +508,7 @@ void path_explorer_t::refresh_all_categories(const bool reset_working_set)
 	}
 }
 
-void path_explorer_t::refresh_category(uint8 category)
+void path_explorer_t::refresh_category(uint8 category, const bool incremental)
 {
 #ifdef MULTI_THREAD
 	world->await_path_explorer();
@@ -427,13 +517,13 @@ void path_explorer_t::refresh_category(uint8 category)
 	uint8 number_of_classes = goods_manager_t::get_classes_catg_index(category);
 	for (uint8 i = 0; i < number_of_classes; i++)
 	{
-		goods_compartment[category][i].set_refresh();
+		goods_compartment[category][i].set_refresh(incremental);
 	}
 }
 
-void path_explorer_t::refresh_class_category(uint8 category, uint8 g_class)
+void path_explorer_t::refresh_class_category(uint8 category, uint8 g_class, const bool incremental)
 {
-	goods_compartment[category][g_class].set_refresh();
+	goods_compartment[category][g_class].set_refresh(incremental);
 }
 
 ///////////////////////////////////////////////
@@ -472,11 +562,22 @@ bool path_explorer_t::compartment_t::local_limits_changed = false;
 uint16 path_explorer_t::compartment_t::representative_halt_count = 0;
 uint8 path_explorer_t::compartment_t::representative_category = 0;
 
+path_explorer_t::compartment_t::relax_kernel_t path_explorer_t::compartment_t::relax_kernel = &path_explorer_t::compartment_t::relax_targets_scalar;
+
+#ifdef MULTI_THREAD
+path_explorer_t::compartment_t *path_explorer_t::compartment_t::parallel_compartment = NULL;
+uint16 path_explorer_t::compartment_t::parallel_via = 0;
+vector_tpl<uint32> path_explorer_t::compartment_t::parallel_origins;
+uint32 path_explorer_t::compartment_t::worker_count = 0;
+#endif
+
 path_explorer_t::compartment_t::compartment_t()
 {
 	refresh_start_time = 0;
 
 	finished_matrix = NULL;
+	finished_table = NULL;
+	compacting_table = NULL;
 	finished_halt_index_map = NULL;
 	finished_halt_count = 0;
 
@@ -492,6 +593,9 @@ path_explorer_t::compartment_t::compartment_t()
 
 	linkages = NULL;
 
+	full_refresh_requested = true;
+	incremental_refresh = false;
+
 	transfer_list = NULL;
 	transfer_count = 0;
 
@@ -529,11 +633,15 @@ path_explorer_t::compartment_t::~compartment_t()
 {
 	if (finished_matrix)
 	{
-		for (uint16 i = 0; i < finished_halt_count; ++i)
-		{
-			delete[] finished_matrix[i];
-		}
-		delete[] finished_matrix;
+		delete finished_matrix;
+	}
+	if (finished_table)
+	{
+		delete finished_table;
+	}
+	if (compacting_table)
+	{
+		delete compacting_table;
 	}
 	if (finished_halt_index_map)
 	{
@@ -543,11 +651,7 @@ path_explorer_t::compartment_t::~compartment_t()
 
 	if (working_matrix)
 	{
-		for (uint16 i = 0; i < working_halt_count; ++i)
-		{
-			delete[] working_matrix[i];
-		}
-		delete[] working_matrix;
+		delete working_matrix;
 	}
 	if (transport_index_map)
 	{
@@ -555,10 +659,6 @@ path_explorer_t::compartment_t::~compartment_t()
 	}
 	if (transport_matrix)
 	{
-		for (uint16 i = 0; i < working_halt_count; ++i)
-		{
-			delete[] transport_matrix[i];
-		}
 		delete[] transport_matrix;
 	}
 	if (working_halt_index_map)
@@ -611,13 +711,19 @@ void path_explorer_t::compartment_t::reset(const bool reset_finished_set)
 	{
 		if (finished_matrix)
 		{
-			for (uint16 i = 0; i < finished_halt_count; ++i)
-			{
-				delete[] finished_matrix[i];
-			}
-			delete[] finished_matrix;
+			delete finished_matrix;
 			finished_matrix = NULL;
 		}
+		if (finished_table)
+		{
+			delete finished_table;
+			finished_table = NULL;
+		}
+		if (compacting_table)
+		{
+			delete compacting_table;
+			compacting_table = NULL;
+		}
 		if (finished_halt_index_map)
 		{
 			delete[] finished_halt_index_map;
@@ -629,11 +735,7 @@ void path_explorer_t::compartment_t::reset(const bool reset_finished_set)
 
 	if (working_matrix)
 	{
-		for (uint16 i = 0; i < working_halt_count; ++i)
-		{
-			delete[] working_matrix[i];
-		}
-		delete[] working_matrix;
+		delete working_matrix;
 		working_matrix = NULL;
 	}
 	if (transport_index_map)
@@ -643,10 +745,6 @@ void path_explorer_t::compartment_t::reset(const bool reset_finished_set)
 	}
 	if (transport_matrix)
 	{
-		for (uint16 i = 0; i < working_halt_count; ++i)
-		{
-			delete[] transport_matrix[i];
-		}
 		delete[] transport_matrix;
 		transport_matrix = NULL;
 	}
@@ -677,6 +775,10 @@ void path_explorer_t::compartment_t::reset(const bool reset_finished_set)
 		linkages = NULL;
 	}
 
+	connexion_changes.clear();
+	full_refresh_requested = true;
+	incremental_refresh = false;
+
 
 	if (transfer_list)
 	{
@@ -727,6 +829,18 @@ void path_explorer_t::compartment_t::reset(const bool reset_finished_set)
 void path_explorer_t::compartment_t::initialise()
 {
 	initialise_connexion_list();
+
+	// select the fastest relaxation kernel available; all of them produce identical results
+	relax_kernel = &relax_targets_scalar;
+#ifdef SIMD_SSE2
+	relax_kernel = &relax_targets_sse2;
+#endif
+#ifdef SIMD_AVX2
+	if (cpu_has_avx2())
+	{
+		relax_kernel = &relax_targets_avx2;
+	}
+#endif
 }
 
 
@@ -741,6 +855,13 @@ void path_explorer_t::compartment_t::set_absolute_limits()
 	time_lower_limit = time_midpoint - time_deviation;
 	time_upper_limit = time_midpoint + time_deviation;
 	time_threshold = time_midpoint / 2;
+	// the changes are counted in the 16 bit phase counter
+	incremental_threshold = get_world()->get_settings().get_path_explorer_incremental_threshold();
+	if ( incremental_threshold > 65535u )
+	{
+		incremental_threshold = 65535u;
+	}
+	compact_threshold = get_world()->get_settings().get_path_explorer_compact_threshold();
 }
 
 void path_explorer_t::compartment_t::step()
@@ -766,10 +887,20 @@ void path_explorer_t::compartment_t::step()
 		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		case phase_check_flag :
 		{
+			if (compacting_table)
+			{
+				// a new refresh would need the memory of a new matrix as well
+				step_compacting();
+				return;
+			}
 			if (refresh_requested)
 			{
 				refresh_requested = false;	// immediately reset it so that we can take new requests
 				refresh_completed = false;	// indicate that processing is at work
+				// changes can only be applied incrementally to a complete matrix, and never during a full instant refresh
+				incremental_refresh = !full_refresh_requested && use_limits && incremental_threshold > 0 && paths_available && finished_matrix;
+				full_refresh_requested = false;
+				connexion_changes.clear();
 				//refresh_start_time = dr_time();
 				refresh_start_time = world->get_ticks(); // Possibly more network safe than the original (commented out above)
 				current_phase = phase_init_prepare;	// proceed to next phase
@@ -1286,9 +1417,22 @@ void path_explorer_t::compartment_t::step()
 					++working_halt_count;
 				}
 
+				if ( incremental_refresh && ( current_halt->get_schedule_count(catg, g_class, max_classes) > 1 ) != ( connexion_list[current_halt.get_id()].serving_transport > 1 ) )
+				{
+					// the halt becomes or ceases to be a transfer halt, which changes the paths through it
+					incremental_refresh = false;
+					connexion_changes.clear();
+				}
+
 				// swap the old connexion hash table with a new one
 				current_halt->swap_connexions(catg, g_class, connexion_list[current_halt.get_id()].connexion_table);
 
+				if ( incremental_refresh )
+				{
+					// compare the old connexions, on which the finished matrix is based, with the new ones
+					record_connexion_changes(current_halt, connexion_list[current_halt.get_id()].connexion_table, current_halt->get_connexions(catg, g_class));
+				}
+
 				// transfer the value of the serving transport counter
 				current_halt->set_schedule_count( catg, g_class, max_classes, connexion_list[ current_halt.get_id() ].serving_transport );
 
@@ -1359,6 +1503,13 @@ void path_explorer_t::compartment_t::step()
 					representative_halt_count = working_halt_count;
 				}
 
+				if ( incremental_refresh && !can_update_incrementally() )
+				{
+					// fall back to a full refresh
+					incremental_refresh = false;
+					connexion_changes.clear();
+				}
+
 				current_phase = phase_fill_matrix;	// proceed to the next phase
 				phase_counter = 0;	// reset counter
 
@@ -1384,24 +1535,66 @@ void path_explorer_t::compartment_t::step()
 
 			printf("\t\tCurrent Step : %lu \n", step_count);
 #endif
+			if (incremental_refresh)
+			{
+				// only few connexions have changed -> repair the finished matrix in place
+				start = dr_time();	// start timing
+
+				const incremental_state_t state = apply_connexion_changes();
+
+				diff = dr_time() - start;	// stop timing
+#ifdef DEBUG_COMPARTMENT_STEP
+				printf("\t\t\tApplying %u connexion changes takes :  %lu ms \n", phase_counter, diff);
+#endif
+				if (state == incremental_suspended)
+				{
+					// resume in the next step
+					return;
+				}
+
+				connexion_changes.clear();
+				incremental_refresh = false;
+
+				if (state == incremental_failed)
+				{
+					// fall back to a full refresh : the working set is still complete, so the matrix can be filled from the start
+					phase_counter = 0;
+					return;
+				}
+
+				// delete the working set, as neither the working matrix nor path exploration are needed
+				if (working_halt_list)
+				{
+					delete[] working_halt_list;
+					working_halt_list = NULL;
+				}
+				if (transport_index_map)
+				{
+					delete[] transport_index_map;
+					transport_index_map = NULL;
+				}
+				if (working_halt_index_map)
+				{
+					delete[] working_halt_index_map;
+					working_halt_index_map = NULL;
+				}
+				working_halt_count = 0;
+
+				paths_available = true;
+				current_phase = phase_reroute_goods;	// proceed directly to rerouting
+				return;
+			}
+
 			// build working matrix and transfer list only if we are not resuming
 			if (phase_counter == 0)
 			{
 				if (working_halt_count > 0)
 				{
 					// build working matrix
-					working_matrix = new path_element_t*[working_halt_count];
-					for (uint16 i = 0; i < working_halt_count; ++i)
-					{
-						working_matrix[i] = new path_element_t[working_halt_count];
-					}
+					working_matrix = new path_matrix_t(working_halt_count);
 
 					// build transport matrix
-					transport_matrix = new transport_element_t*[working_halt_count];
-					for (uint16 i = 0; i < working_halt_count; ++i)
-					{
-						transport_matrix[i] = new transport_element_t[working_halt_count];
-					}
+					transport_matrix = new transport_element_t[(size_t)working_halt_count * working_halt_count];
 
 					// build transfer list
 					transfer_list = new uint16[working_halt_count];
@@ -1479,18 +1672,17 @@ void path_explorer_t::compartment_t::step()
 					}
 
 					// update corresponding matrix element
-					working_matrix[phase_counter][reachable_halt_index].next_transfer = reachable_halt;
-					working_matrix[phase_counter][reachable_halt_index].aggregate_time = current_connexion->waiting_time + current_connexion->journey_time + current_connexion->transfer_time;
-					transport_matrix[phase_counter][reachable_halt_index].first_transport
-						= transport_matrix[phase_counter][reachable_halt_index].last_transport
-						= transport_idx;
+					working_matrix->transfer_id(phase_counter, reachable_halt_index) = reachable_halt.get_id();
+					working_matrix->time(phase_counter, reachable_halt_index) = current_connexion->waiting_time + current_connexion->journey_time + current_connexion->transfer_time;
+					transport_element_t &transport = transport_matrix[(size_t)phase_counter * working_halt_count + reachable_halt_index];
+					transport.first_transport = transport.last_transport = transport_idx;
 
 					// Debug journey times
-					// printf("\n%s -> %s : %lu \n",current_halt->get_name(), reachable_halt->get_name(), working_matrix[phase_counter][reachable_halt_index].journey_time);
+					// printf("\n%s -> %s : %lu \n",current_halt->get_name(), reachable_halt->get_name(), working_matrix->time(phase_counter, reachable_halt_index));
 				}
 
 				// Special case
-				working_matrix[phase_counter][phase_counter].aggregate_time = 0;
+				working_matrix->time(phase_counter, phase_counter) = 0;
 
 				++phase_counter;
 
@@ -1586,8 +1778,6 @@ void path_explorer_t::compartment_t::step()
 			printf("\t\tCurrent Step : %lu \n", step_count);
 #endif
 			// temporary variables
-			uint32 combined_time;
-			uint32 target_member_index;
 			uint64 iterations_processed = 0;
 
 			// initialize only when not resuming
@@ -1611,12 +1801,14 @@ void path_explorer_t::compartment_t::step()
 					process_next_transfer = false;
 
 					// identify halts which are connected with the current transfer halt
+					const uint32 *const via_times = working_matrix->get_time_row(via);
+					const transport_element_t *const via_transports = transport_matrix + (size_t)via * working_halt_count;
 					for ( uint16 idx = 0; idx < working_halt_count; ++idx )
 					{
-						if ( working_matrix[via][idx].aggregate_time != UINT32_MAX_VALUE && via != idx )
+						if ( via_times[idx] != UINT32_MAX_VALUE && via != idx )
 						{
-							inbound_connections->register_connection( transport_matrix[idx][via].last_transport, idx );
-							outbound_connections->register_connection( transport_matrix[via][idx].first_transport, idx );
+							inbound_connections->register_connection( transport_matrix[(size_t)idx * working_halt_count + via].last_transport, idx );
+							outbound_connections->register_connection( via_transports[idx].first_transport, idx );
 						}
 					}
 
@@ -1625,6 +1817,30 @@ void path_explorer_t::compartment_t::step()
 					total_iterations += (uint32)working_halt_count + ( inbound_connections->get_total_member_count() << 1 );
 				}
 
+#ifdef MULTI_THREAD
+				// explore the whole transfer in parallel if it fits into the remaining iterations;
+				// otherwise the serial loop below is used, which can be suspended and resumed
+				if ( worker_count > 0 && origin_cluster_index == 0 && target_cluster_index == 0 && origin_member_index == 0 )
+				{
+					const uint64 transfer_iterations = count_transfer_iterations();
+					if ( transfer_iterations >= min_parallel_iterations && ( !use_limits || iterations_processed + transfer_iterations < limit_explore_paths ) )
+					{
+						explore_transfer_in_parallel(via);
+
+						iterations_processed += transfer_iterations;
+						total_iterations += (uint32)transfer_iterations;
+
+						// clear the inbound/outbound connections
+						inbound_connections->reset();
+						outbound_connections->reset();
+						process_next_transfer = true;
+
+						++via_index;
+						continue;
+					}
+				}
+#endif
+
 				// for each origin cluster
 				while ( origin_cluster_index < inbound_connections->get_cluster_count() )
 				{
@@ -1643,27 +1859,21 @@ void path_explorer_t::compartment_t::step()
 							continue;
 						}
 						const vector_tpl<uint16> &target_halt_list = target_cluster.connected_halts;
+						const uint32 *const via_times = working_matrix->get_time_row(via);
+						const transport_element_t *const via_transports = transport_matrix + (size_t)via * working_halt_count;
 
 						// for each origin cluster member
 						while ( origin_member_index < origin_halt_list.get_count() )
 						{
 							const uint16 origin = origin_halt_list[origin_member_index];
+							uint32 *const origin_times = working_matrix->get_time_row(origin);
+							uint16 *const origin_transfers = working_matrix->get_transfer_row(origin);
+							transport_element_t *const origin_transports = transport_matrix + (size_t)origin * working_halt_count;
 
 							// for each target cluster member
-							for ( target_member_index = 0; target_member_index < target_halt_list.get_count(); ++target_member_index )
-							{
-								const uint16 target = target_halt_list[target_member_index];
-
-								if ( ( combined_time = working_matrix[origin][via].aggregate_time
-													 + working_matrix[via][target].aggregate_time )
-											< working_matrix[origin][target].aggregate_time			   )
-								{
-									working_matrix[origin][target].aggregate_time = combined_time;
-									working_matrix[origin][target].next_transfer = working_matrix[origin][via].next_transfer;
-									transport_matrix[origin][target].first_transport = transport_matrix[origin][via].first_transport;
-									transport_matrix[origin][target].last_transport = transport_matrix[via][target].last_transport;
-								}
-							}	// loop : target cluster member
+							relax_kernel(origin_times, origin_transfers, origin_transports, via_times, via_transports,
+										 target_halt_list.begin(), target_halt_list.get_count(),
+										 origin_times[via], origin_transfers[via], origin_transports[via].first_transport);
 
 							++origin_member_index;
 
@@ -1751,13 +1961,19 @@ void path_explorer_t::compartment_t::step()
 				// path search completed -> delete old path info
 				if (finished_matrix)
 				{
-					for (uint16 i = 0; i < finished_halt_count; ++i)
-					{
-						delete[] finished_matrix[i];
-					}
-					delete[] finished_matrix;
+					delete finished_matrix;
 					finished_matrix = NULL;
 				}
+				if (finished_table)
+				{
+					delete finished_table;
+					finished_table = NULL;
+				}
+				if (compacting_table)
+				{
+					delete compacting_table;
+					compacting_table = NULL;
+				}
 				if (finished_halt_index_map)
 				{
 					delete[] finished_halt_index_map;
@@ -1775,10 +1991,6 @@ void path_explorer_t::compartment_t::step()
 				// path search completed -> delete auxilliary data structures
 				if (transport_matrix)
 				{
-					for (uint16 i = 0; i < working_halt_count; ++i)
-					{
-						delete[] transport_matrix[i];
-					}
 					delete[] transport_matrix;
 					transport_matrix = NULL;
 				}
@@ -1926,6 +2138,9 @@ void path_explorer_t::compartment_t::step()
 
 				refresh_start_time = 0;
 				refresh_completed = true;
+
+				// the next steps replace the new matrix by a next hop table, before a new refresh is started
+				compact_finished_paths();
 			}
 
 			iterations = 0;	// reset iteration counter
@@ -1943,127 +2158,961 @@ void path_explorer_t::compartment_t::step()
 }
 
 
-void path_explorer_t::compartment_t::enumerate_all_paths(const path_element_t *const *const matrix, const halthandle_t *const halt_list,
-														 const uint16 *const halt_map, const uint16 halt_count)
+path_explorer_t::compartment_t::path_matrix_t::path_matrix_t(const uint16 count) :
+	halt_count(count)
 {
-	// Debugging code : Enumerate all paths for validation
-	halthandle_t transfer_halt;
+	const size_t element_count = (size_t)count * count;
+	aggregate_time = new uint32[element_count];
+	next_transfer = new uint16[element_count]();	// initialise all elements to null halt ids
 
-	for (uint16 x = 0; x < halt_count; ++x)
-	{
-		for (uint16 y = 0; y < halt_count; ++y)
-		{
-			if (x != y)
-			{
-				// print origin
-				printf("\n\nOrigin :  %s\n", halt_list[x]->get_name());
+	// all bytes set means UINT32_MAX_VALUE, i.e. no path
+	memset(aggregate_time, 0xFF, element_count * sizeof(uint32));
+}
 
-				transfer_halt = matrix[x][y].next_transfer;
 
-				if (matrix[x][y].aggregate_time == UINT32_MAX_VALUE)
-				{
-					printf("\t\t\t\t******** No Route ********\n");
-				}
-				else
-				{
-					while (transfer_halt != halt_list[y])
-					{
-						printf("\t\t\t\t%s\n", transfer_halt->get_name());
+path_explorer_t::compartment_t::path_matrix_t::~path_matrix_t()
+{
+	delete[] aggregate_time;
+	delete[] next_transfer;
+}
 
-						if ( halt_map[transfer_halt.get_id()] != 65535)
-						{
-							transfer_halt = matrix[ halt_map[transfer_halt.get_id()] ][y].next_transfer;
-						}
-						else
-						{
-							printf("\t\t\t\tError!!!");
-							break;
-						}
-					}
-				}
 
-				// print destination
-				printf("Target :  %s\n\n", halt_list[y]->get_name());
+path_explorer_t::compartment_t::next_hop_table_t::next_hop_table_t(const uint16 count, const uint16 *halt_map) :
+	halt_count(count),
+	halt_index_map(halt_map),
+	run_start(NULL),
+	runs(NULL),
+	time_start(NULL),
+	times(NULL),
+	built_rows(0)
+{
+	// sort the targets by their position on the map, interleaving the bits of the coordinates
+	vector_tpl<uint64> keys(halt_count);
+	for ( uint32 id = 1; id < 65536; ++id )
+	{
+		const uint16 index = halt_index_map[id];
+		if ( index < halt_count )
+		{
+			halthandle_t halt;
+			halt.set_id(id);
+			const koord pos = halt.is_bound() ? halt->get_basis_pos() : koord(0, 0);
+			uint32 code = 0;
+			for ( uint8 bit = 0; bit < 16; ++bit )
+			{
+				code |= ( ( (uint32)(uint16)pos.x >> bit & 1 ) << ( 2 * bit ) ) | ( ( (uint32)(uint16)pos.y >> bit & 1 ) << ( 2 * bit + 1 ) );
 			}
+			keys.append( ( (uint64)code << 16 ) | index );
 		}
 	}
-}
-
-
-bool path_explorer_t::compartment_t::get_path_between(const halthandle_t origin_halt, const halthandle_t target_halt,
-													  uint32 &aggregate_time, halthandle_t &next_transfer)
-{
-	uint16 origin_index, target_index;
+	std::sort(keys.begin(), keys.end());
 
-	// check if origin and target halts are both present in matrix; if yes, check the validity of the next transfer
-	if ( paths_available /*&& origin_halt.is_bound() && target_halt.is_bound()*/
-			&& ( origin_index = finished_halt_index_map[ origin_halt.get_id() ] ) != 65535
-			&& ( target_index = finished_halt_index_map[ target_halt.get_id() ] ) != 65535
-			&& finished_matrix[origin_index][target_index].next_transfer.is_bound() )
+	target_position = new uint16[halt_count];
+	for ( uint16 i = 0; i < halt_count; ++i )
 	{
-		aggregate_time = finished_matrix[origin_index][target_index].aggregate_time;
-		next_transfer = finished_matrix[origin_index][target_index].next_transfer;
-		return true;
+		target_position[i] = i;
+	}
+	for ( uint32 i = 0; i < keys.get_count(); ++i )
+	{
+		target_position[ (uint16)keys[i] ] = (uint16)i;
 	}
 
-	// requested path not found
-	aggregate_time = UINT32_MAX_VALUE;
-	next_transfer = halthandle_t();
-	return false;
+	run_start = new uint32[(uint32)halt_count + 1];
+	time_start = new uint32[(uint32)halt_count + 1];
+	run_list = new vector_tpl<run_t>(halt_count);
+	time_list = new vector_tpl<stored_time_t>(halt_count);
 }
 
 
-void path_explorer_t::compartment_t::set_category(uint8 category)
+path_explorer_t::compartment_t::next_hop_table_t::~next_hop_table_t()
 {
-	catg = category;
-	const goods_desc_t *ware_type = goods_manager_t::get_info_catg_index(catg);
-	catg_name = ware_type->get_catg_name();
+	delete[] target_position;
+	delete[] run_start;
+	delete[] runs;
+	delete[] time_start;
+	delete[] times;
+	delete run_list;
+	delete time_list;
 }
 
-void path_explorer_t::compartment_t::set_class(uint8 value)
+
+uint64 path_explorer_t::compartment_t::next_hop_table_t::build(const path_matrix_t &matrix, const uint64 limit, bool &too_large)
 {
-	g_class = value;
-	delete[] class_name;
-	class_name = new char[96];
+	too_large = false;
+	const size_t matrix_size = (size_t)halt_count * halt_count * ( sizeof(uint32) + sizeof(uint16) );
 
-	if (catg == goods_manager_t::INDEX_PAS)
+	// the targets in the order of their positions
+	uint16 *const order = new uint16[halt_count];
+	for ( uint16 i = 0; i < halt_count; ++i )
 	{
-		sprintf(class_name, "%s_%u", translator::translate("p_class"), g_class);
+		order[ target_position[i] ] = i;
 	}
-	else if (catg == goods_manager_t::INDEX_MAIL)
+
+	uint64 iterations = 0;
+	while ( built_rows < halt_count && ( limit == 0 || iterations < limit ) )
 	{
-		sprintf(class_name, "%s_%u", translator::translate("m_class"), g_class);
+		const uint16 row = built_rows;
+		const uint32 *const row_times = matrix.get_time_row(row);
+		const uint16 *const row_transfers = matrix.get_transfer_row(row);
+		run_start[row] = run_list->get_count();
+		time_start[row] = time_list->get_count();
+
+		for ( uint16 position = 0; position < halt_count; ++position )
+		{
+			const uint16 next_transfer = row_transfers[ order[position] ];
+			if ( position == 0 || run_list->back().next_transfer != next_transfer )
+			{
+				run_t run;
+				run.first_position = position;
+				run.next_transfer = next_transfer;
+				run_list->append(run);
+			}
+		}
+
+		for ( uint16 column = 0; column < halt_count; ++column )
+		{
+			const uint32 aggregate_time = row_times[column];
+			if ( aggregate_time == UINT32_MAX_VALUE && row_transfers[column] == 0 )
+			{
+				// no path, as the run says
+				continue;
+			}
+
+			// the time is the time of the direct connexion to the next transfer plus the time from there
+			const uint16 via = row_transfers[column] ? halt_index_map[ row_transfers[column] ] : 65535;
+			if ( aggregate_time != UINT32_MAX_VALUE && via < halt_count && via != column && row_transfers[via] == row_transfers[column] )
+			{
+				const uint32 via_time = row_times[via];
+				const uint32 onward_time = matrix.time(via, column);
+				// a positive time to the next transfer ensures that adding up the times comes to an end
+				if ( via_time > 0 && via_time != UINT32_MAX_VALUE && onward_time != UINT32_MAX_VALUE
+					 && via_time + onward_time >= via_time && via_time + onward_time == aggregate_time )
+				{
+					continue;
+				}
+			}
+
+			stored_time_t stored_time;
+			stored_time.target = column;
+			stored_time.aggregate_time = aggregate_time;
+			time_list->append(stored_time);
+		}
+
+		++built_rows;
+		iterations += (uint64)halt_count * 2;
+
+		if ( get_memory_size() >= matrix_size )
+		{
+			too_large = true;
+			break;
+		}
 	}
-	else
+	delete[] order;
+
+	if ( is_complete() && !too_large )
 	{
-		class_name[0] = '\0';
+		run_start[halt_count] = run_list->get_count();
+		time_start[halt_count] = time_list->get_count();
+
+		// keep exactly what is needed
+		runs = new run_t[run_list->get_count()];
+		for ( uint32 i = 0; i < run_list->get_count(); ++i )
+		{
+			runs[i] = (*run_list)[i];
+		}
+		times = new stored_time_t[time_list->get_count()];
+		for ( uint32 i = 0; i < time_list->get_count(); ++i )
+		{
+			times[i] = (*time_list)[i];
+		}
+		delete run_list;
+		run_list = NULL;
+		delete time_list;
+		time_list = NULL;
 	}
+	return iterations;
 }
 
 
-void path_explorer_t::compartment_t::initialise_connexion_list()
+uint16 path_explorer_t::compartment_t::next_hop_table_t::get_next_transfer(const uint16 row, const uint16 column) const
 {
-	for (uint32 i = 0; i < 65536; ++i)
-	{
-		// Note that the connexion_tables created here will be
-		// swapped with connexion_tables created/stored in halts.
-		connexion_list[i].connexion_table = new haltestelle_t::connexions_map ();
-		connexion_list[i].serving_transport = 0;
+	// the last run starting at or before the position of the target
+	const uint16 position = target_position[column];
+	uint32 low = run_start[row];
+	uint32 high = run_start[row + 1];
+	while ( high - low > 1 )
+	{
+		const uint32 middle = low + ( ( high - low ) >> 1 );
+		if ( runs[middle].first_position <= position )
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
 	}
+	return runs[low].next_transfer;
 }
 
 
-void path_explorer_t::compartment_t::reset_connexion_entry(const uint16 halt_id)
+bool path_explorer_t::compartment_t::next_hop_table_t::get_stored_time(const uint16 row, const uint16 column, uint32 &aggregate_time) const
 {
-	if ( !connexion_list[halt_id].connexion_table->empty() )
+	// stored times are sorted by target
+	uint32 low = time_start[row];
+	uint32 high = time_start[row + 1];
+	while ( low < high )
 	{
-		FOR(haltestelle_t::connexions_map, const& iter, (*(connexion_list[halt_id].connexion_table)))
+		const uint32 middle = low + ( ( high - low ) >> 1 );
+		if ( times[middle].target < column )
 		{
-			delete iter.value;
+			low = middle + 1;
 		}
-
-		connexion_list[halt_id].connexion_table->clear();
-	}
+		else
+		{
+			high = middle;
+		}
+	}
+	if ( low < time_start[row + 1] && times[low].target == column )
+	{
+		aggregate_time = times[low].aggregate_time;
+		return true;
+	}
+	return false;
+}
+
+
+void path_explorer_t::compartment_t::next_hop_table_t::get_path(const uint16 row, const uint16 column, uint32 &aggregate_time, uint16 &next_transfer) const
+{
+	next_transfer = get_next_transfer(row, column);
+
+	// add up the times along the next transfers until a stored time is reached
+	aggregate_time = 0;
+	uint16 current = row;
+	for ( uint32 i = 0; i < halt_count; ++i )
+	{
+		uint32 time;
+		if ( get_stored_time(current, column, time) )
+		{
+			aggregate_time += time;
+			return;
+		}
+		const uint16 transfer = current == row ? next_transfer : get_next_transfer(current, column);
+		const uint16 via = transfer ? halt_index_map[transfer] : 65535;
+		if ( via >= halt_count || !get_stored_time(current, via, time) )
+		{
+			break;
+		}
+		aggregate_time += time;
+		current = via;
+	}
+
+	// no path
+	aggregate_time = UINT32_MAX_VALUE;
+	next_transfer = 0;
+}
+
+
+void path_explorer_t::compartment_t::next_hop_table_t::get_row(const uint16 row, uint32 *row_times, uint16 *row_transfers) const
+{
+	for ( uint16 column = 0; column < halt_count; ++column )
+	{
+		get_path(row, column, row_times[column], row_transfers[column]);
+	}
+}
+
+
+size_t path_explorer_t::compartment_t::next_hop_table_t::get_memory_size() const
+{
+	const uint32 run_count = run_list ? run_list->get_count() : run_start[halt_count];
+	const uint32 time_count = time_list ? time_list->get_count() : time_start[halt_count];
+	return (size_t)halt_count * sizeof(uint16)
+		+ ( (size_t)halt_count + 1 ) * 2 * sizeof(uint32)
+		+ (size_t)run_count * sizeof(run_t)
+		+ (size_t)time_count * sizeof(stored_time_t);
+}
+
+
+/*
+ * Relaxation kernels for path exploration.
+ * For a single origin, every target reachable from the current transfer (via) is checked
+ * for whether the path through the transfer is shorter than the one known so far.
+ * Targets never include the transfer itself, so the origin-to-transfer element cannot change
+ * while a kernel is running; the vectorised kernels only use this to compare several targets
+ * at once, and apply the updates in the same order as the scalar kernel.
+ * Note that the addition deliberately wraps around like the original scalar code does.
+ */
+inline void path_explorer_t::compartment_t::relax_single_target(uint32 *origin_times, uint16 *origin_transfers, transport_element_t *origin_transports,
+																  const uint32 *via_times, const transport_element_t *via_transports,
+																  const uint16 target, const uint32 origin_via_time, const uint16 origin_via_transfer, const uint16 origin_via_transport)
+{
+	const uint32 combined_time = origin_via_time + via_times[target];
+	if ( combined_time < origin_times[target] )
+	{
+		origin_times[target] = combined_time;
+		origin_transfers[target] = origin_via_transfer;
+		origin_transports[target].first_transport = origin_via_transport;
+		origin_transports[target].last_transport = via_transports[target].last_transport;
+	}
+}
+
+
+void path_explorer_t::compartment_t::relax_targets_scalar(uint32 *origin_times, uint16 *origin_transfers, transport_element_t *origin_transports,
+														   const uint32 *via_times, const transport_element_t *via_transports,
+														   const uint16 *targets, const uint32 target_count,
+														   const uint32 origin_via_time, const uint16 origin_via_transfer, const uint16 origin_via_transport)
+{
+	for ( uint32 i = 0; i < target_count; ++i )
+	{
+		relax_single_target(origin_times, origin_transfers, origin_transports, via_times, via_transports,
+							targets[i], origin_via_time, origin_via_transfer, origin_via_transport);
+	}
+}
+
+
+#ifdef SIMD_SSE2
+void path_explorer_t::compartment_t::relax_targets_sse2(uint32 *origin_times, uint16 *origin_transfers, transport_element_t *origin_transports,
+														 const uint32 *via_times, const transport_element_t *via_transports,
+														 const uint16 *targets, const uint32 target_count,
+														 const uint32 origin_via_time, const uint16 origin_via_transfer, const uint16 origin_via_transport)
+{
+	// SSE2 has no unsigned comparison : flip the sign bits and compare signed instead
+	const __m128i sign_bias = _mm_set1_epi32( (int)0x80000000u );
+	const __m128i origin_via = _mm_set1_epi32( (int)origin_via_time );
+
+	uint32 i = 0;
+	for ( ; i + 4 <= target_count; i += 4 )
+	{
+		const uint16 *const t = targets + i;
+		const __m128i via = _mm_set_epi32( (int)via_times[t[3]], (int)via_times[t[2]], (int)via_times[t[1]], (int)via_times[t[0]] );
+		const __m128i current = _mm_set_epi32( (int)origin_times[t[3]], (int)origin_times[t[2]], (int)origin_times[t[1]], (int)origin_times[t[0]] );
+		const __m128i combined = _mm_add_epi32( origin_via, via );
+		const __m128i shorter = _mm_cmplt_epi32( _mm_xor_si128(combined, sign_bias), _mm_xor_si128(current, sign_bias) );
+
+		// most candidates are rejected, so only look at the individual lanes if any is shorter
+		int mask = _mm_movemask_ps( _mm_castsi128_ps(shorter) );
+		for ( uint32 lane = 0; mask; ++lane, mask >>= 1 )
+		{
+			if ( mask & 1 )
+			{
+				relax_single_target(origin_times, origin_transfers, origin_transports, via_times, via_transports,
+									t[lane], origin_via_time, origin_via_transfer, origin_via_transport);
+			}
+		}
+	}
+
+	relax_targets_scalar(origin_times, origin_transfers, origin_transports, via_times, via_transports,
+						 targets + i, target_count - i, origin_via_time, origin_via_transfer, origin_via_transport);
+}
+#endif
+
+
+#ifdef SIMD_AVX2
+SIMD_AVX2_TARGET
+void path_explorer_t::compartment_t::relax_targets_avx2(uint32 *origin_times, uint16 *origin_transfers, transport_element_t *origin_transports,
+														 const uint32 *via_times, const transport_element_t *via_transports,
+														 const uint16 *targets, const uint32 target_count,
+														 const uint32 origin_via_time, const uint16 origin_via_transfer, const uint16 origin_via_transport)
+{
+	const __m256i sign_bias = _mm256_set1_epi32( (int)0x80000000u );
+	const __m256i origin_via = _mm256_set1_epi32( (int)origin_via_time );
+
+	uint32 i = 0;
+	for ( ; i + 8 <= target_count; i += 8 )
+	{
+		const uint16 *const t = targets + i;
+		const __m256i indices = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i *)t ) );
+		const __m256i via = _mm256_i32gather_epi32( (const int *)via_times, indices, 4 );
+		const __m256i current = _mm256_i32gather_epi32( (const int *)origin_times, indices, 4 );
+		const __m256i combined = _mm256_add_epi32( origin_via, via );
+		const __m256i shorter = _mm256_cmpgt_epi32( _mm256_xor_si256(current, sign_bias), _mm256_xor_si256(combined, sign_bias) );
+
+		int mask = _mm256_movemask_ps( _mm256_castsi256_ps(shorter) );
+		for ( uint32 lane = 0; mask; ++lane, mask >>= 1 )
+		{
+			if ( mask & 1 )
+			{
+				relax_single_target(origin_times, origin_transfers, origin_transports, via_times, via_transports,
+									t[lane], origin_via_time, origin_via_transfer, origin_via_transport);
+			}
+		}
+	}
+
+	relax_targets_scalar(origin_times, origin_transfers, origin_transports, via_times, via_transports,
+						 targets + i, target_count - i, origin_via_time, origin_via_transfer, origin_via_transport);
+}
+#endif
+
+
+#ifdef MULTI_THREAD
+/*
+ * Parallel exploration of a single transfer halt.
+ * The rows of different origins are disjoint and only read the row of the transfer, which is never
+ * modified while exploring this transfer (targets never include the transfer itself). Each thread
+ * therefore relaxes its own share of the origins, and the result is identical to the serial loop.
+ */
+uint64 path_explorer_t::compartment_t::count_transfer_iterations() const
+{
+	uint64 iterations = 0;
+	for ( uint32 i = 0; i < inbound_connections->get_cluster_count(); ++i )
+	{
+		const connection_t::connection_cluster_t &origin_cluster = (*inbound_connections)[i];
+		uint32 target_member_count = 0;
+		for ( uint32 j = 0; j < outbound_connections->get_cluster_count(); ++j )
+		{
+			const connection_t::connection_cluster_t &target_cluster = (*outbound_connections)[j];
+			if ( origin_cluster.transport != target_cluster.transport || origin_cluster.transport == 0u )
+			{
+				target_member_count += target_cluster.connected_halts.get_count();
+			}
+		}
+		iterations += (uint64)origin_cluster.connected_halts.get_count() * target_member_count;
+	}
+	return iterations;
+}
+
+
+void path_explorer_t::compartment_t::explore_transfer_in_parallel(const uint16 via)
+{
+	parallel_origins.clear();
+	for ( uint32 i = 0; i < inbound_connections->get_cluster_count(); ++i )
+	{
+		const connection_t::connection_cluster_t &origin_cluster = (*inbound_connections)[i];
+		FOR(vector_tpl<uint16>, const origin, origin_cluster.connected_halts)
+		{
+			parallel_origins.append( ( (uint32)origin_cluster.transport << 16 ) | origin );
+		}
+	}
+	parallel_compartment = this;
+	parallel_via = via;
+
+	// the calling thread takes the first share of the origins
+	simthread_barrier_wait(&path_explorer_worker_barrier);
+	explore_parallel_origins(0);
+	simthread_barrier_wait(&path_explorer_worker_barrier);
+
+	parallel_compartment = NULL;
+}
+
+
+void path_explorer_t::compartment_t::explore_parallel_origins(const uint32 thread_number) const
+{
+	const uint16 via = parallel_via;
+	const uint32 thread_count = worker_count + 1;
+	const uint32 *const via_times = working_matrix->get_time_row(via);
+	const transport_element_t *const via_transports = transport_matrix + (size_t)via * working_halt_count;
+
+	// origins are interleaved among the threads, as cluster sizes vary a lot
+	for ( uint32 i = thread_number; i < parallel_origins.get_count(); i += thread_count )
+	{
+		const uint16 inbound_transport = (uint16)( parallel_origins[i] >> 16 );
+		const uint16 origin = (uint16)( parallel_origins[i] & 0xFFFFu );
+		uint32 *const origin_times = working_matrix->get_time_row(origin);
+		uint16 *const origin_transfers = working_matrix->get_transfer_row(origin);
+		transport_element_t *const origin_transports = transport_matrix + (size_t)origin * working_halt_count;
+
+		for ( uint32 j = 0; j < outbound_connections->get_cluster_count(); ++j )
+		{
+			const connection_t::connection_cluster_t &target_cluster = (*outbound_connections)[j];
+			if ( inbound_transport == target_cluster.transport && inbound_transport != 0u )
+			{
+				continue;
+			}
+			relax_kernel(origin_times, origin_transfers, origin_transports, via_times, via_transports,
+						 target_cluster.connected_halts.begin(), target_cluster.connected_halts.get_count(),
+						 origin_times[via], origin_transfers[via], origin_transports[via].first_transport);
+		}
+	}
+}
+#endif
+
+
+void path_explorer_t::compartment_t::enumerate_all_paths(const path_matrix_t *const matrix, const halthandle_t *const halt_list,
+														 const uint16 *const halt_map, const uint16 halt_count)
+{
+	// Debugging code : Enumerate all paths for validation
+	halthandle_t transfer_halt;
+
+	for (uint16 x = 0; x < halt_count; ++x)
+	{
+		for (uint16 y = 0; y < halt_count; ++y)
+		{
+			if (x != y)
+			{
+				// print origin
+				printf("\n\nOrigin :  %s\n", halt_list[x]->get_name());
+
+				transfer_halt = matrix->get_next_transfer(x, y);
+
+				if (matrix->time(x, y) == UINT32_MAX_VALUE)
+				{
+					printf("\t\t\t\t******** No Route ********\n");
+				}
+				else
+				{
+					while (transfer_halt != halt_list[y])
+					{
+						printf("\t\t\t\t%s\n", transfer_halt->get_name());
+
+						if ( halt_map[transfer_halt.get_id()] != 65535)
+						{
+							transfer_halt = matrix->get_next_transfer( halt_map[transfer_halt.get_id()], y );
+						}
+						else
+						{
+							printf("\t\t\t\tError!!!");
+							break;
+						}
+					}
+				}
+
+				// print destination
+				printf("Target :  %s\n\n", halt_list[y]->get_name());
+			}
+		}
+	}
+}
+
+
+bool path_explorer_t::compartment_t::get_path_between(const halthandle_t origin_halt, const halthandle_t target_halt,
+													  uint32 &aggregate_time, halthandle_t &next_transfer)
+{
+	uint16 origin_index, target_index;
+
+	// check if origin and target halts are both present in matrix; if yes, check the validity of the next transfer
+	if ( paths_available /*&& origin_halt.is_bound() && target_halt.is_bound()*/
+			&& ( origin_index = finished_halt_index_map[ origin_halt.get_id() ] ) != 65535
+			&& ( target_index = finished_halt_index_map[ target_halt.get_id() ] ) != 65535 )
+	{
+		if ( finished_table )
+		{
+			uint16 next_transfer_id;
+			finished_table->get_path(origin_index, target_index, aggregate_time, next_transfer_id);
+			next_transfer.set_id(next_transfer_id);
+			if ( next_transfer.is_bound() )
+			{
+				return true;
+			}
+		}
+		else if ( ( next_transfer = finished_matrix->get_next_transfer(origin_index, target_index) ).is_bound() )
+		{
+			aggregate_time = finished_matrix->time(origin_index, target_index);
+			return true;
+		}
+	}
+
+	// requested path not found
+	aggregate_time = UINT32_MAX_VALUE;
+	next_transfer = halthandle_t();
+	return false;
+}
+
+
+uint32 path_explorer_t::compartment_t::get_connexion_time(const haltestelle_t::connexion *cnx)
+{
+	// the same validation as when the working matrix is filled
+	if ( ( cnx->best_line.is_null() && cnx->best_convoy.is_null() ) || cnx->best_line.is_bound() || cnx->best_convoy.is_bound() )
+	{
+		return cnx->waiting_time + cnx->journey_time + cnx->transfer_time;
+	}
+	return UINT32_MAX_VALUE;
+}
+
+
+uint32 path_explorer_t::compartment_t::get_transport_key(const haltestelle_t::connexion *cnx)
+{
+	// the same order as in the transport index map
+	if ( cnx->best_line.is_bound() )
+	{
+		return 1u + cnx->best_line.get_id();
+	}
+	if ( cnx->best_convoy.is_bound() )
+	{
+		return 65537u + cnx->best_convoy.get_id();
+	}
+	return 0;
+}
+
+
+void path_explorer_t::compartment_t::record_connexion_changes(const halthandle_t &halt, const haltestelle_t::connexions_map *old_connexions,
+															  const haltestelle_t::connexions_map *new_connexions)
+{
+	connexion_change_t change;
+	change.origin_id = halt.get_id();
+
+	// new and changed connexions
+	for(auto const& iter : *new_connexions)
+	{
+		change.target_id = iter.key.get_id();
+		change.new_time = get_connexion_time(iter.value);
+		const haltestelle_t::connexion *const old_connexion = old_connexions->get(iter.key);
+		change.old_time = old_connexion ? get_connexion_time(old_connexion) : UINT32_MAX_VALUE;
+		if ( change.old_time != change.new_time )
+		{
+			connexion_changes.append(change);
+		}
+	}
+
+	// removed connexions
+	for(auto const& iter : *old_connexions)
+	{
+		if ( !new_connexions->is_contained(iter.key) )
+		{
+			change.target_id = iter.key.get_id();
+			change.old_time = get_connexion_time(iter.value);
+			change.new_time = UINT32_MAX_VALUE;
+			if ( change.old_time != change.new_time )
+			{
+				connexion_changes.append(change);
+			}
+		}
+	}
+
+	if ( connexion_changes.get_count() > incremental_threshold )
+	{
+		// too many changes -> a full refresh is cheaper
+		incremental_refresh = false;
+		connexion_changes.clear();
+	}
+}
+
+
+bool path_explorer_t::compartment_t::can_update_incrementally() const
+{
+	// the finished matrix can only be repaired if it covers exactly the same halts in the same order
+	return finished_matrix && finished_halt_index_map && working_halt_index_map
+		&& working_halt_count == finished_halt_count
+		&& memcmp(working_halt_index_map, finished_halt_index_map, 65536 * sizeof(uint16)) == 0;
+}
+
+
+path_explorer_t::compartment_t::incremental_state_t path_explorer_t::compartment_t::apply_connexion_changes()
+{
+	uint64 iterations_processed = 0;
+	while ( phase_counter < connexion_changes.get_count() )
+	{
+		const connexion_change_t &change = connexion_changes[phase_counter];
+		const uint16 origin = finished_halt_index_map[change.origin_id];
+		const uint16 target = finished_halt_index_map[change.target_id];
+		if ( origin == 65535 || target == 65535 || origin == target )
+		{
+			// connexions to halts outside of the matrix are ignored when filling it, too
+		}
+		else if ( change.new_time < change.old_time )
+		{
+			iterations_processed += insert_improved_connexion(origin, target, change.new_time);
+		}
+		else if ( !repair_worsened_connexion(origin, target, iterations_processed) )
+		{
+			return incremental_failed;
+		}
+
+		++phase_counter;
+
+		// iteration control
+		if ( use_limits && iterations_processed >= limit_explore_paths && phase_counter < connexion_changes.get_count() )
+		{
+			return incremental_suspended;
+		}
+	}
+	return incremental_done;
+}
+
+
+bool path_explorer_t::compartment_t::is_transfer_halt(const uint16 index) const
+{
+	const halthandle_t &halt = working_halt_list[index];
+	return halt.is_bound() && halt->get_schedule_count(catg, g_class, max_classes) > 1;
+}
+
+
+uint64 path_explorer_t::compartment_t::insert_improved_connexion(const uint16 origin, const uint16 target, const uint32 aggregate_time)
+{
+	// A path x -> y can only become shorter by using the improved connexion origin -> target if
+	// both x -> target improves by going through origin, and origin -> y improves by going through target.
+	// Hence only the rows and columns in these two sets need to be updated.
+	// Other halts than the origin and the target can only use the connexion by transferring there.
+	const uint16 halt_count = finished_halt_count;
+	const bool via_origin = is_transfer_halt(origin);
+	const bool via_target = is_transfer_halt(target);
+	vector_tpl<uint16> affected_rows;
+	vector_tpl<uint16> affected_columns;
+
+	for ( uint16 x = 0; x < halt_count; ++x )
+	{
+		const uint32 to_origin = finished_matrix->time(x, origin);
+		if ( ( x == origin || via_origin ) && to_origin != UINT32_MAX_VALUE && (uint64)to_origin + aggregate_time < finished_matrix->time(x, target) )
+		{
+			affected_rows.append(x);
+		}
+	}
+
+	const uint32 *const origin_times = finished_matrix->get_time_row(origin);
+	const uint32 *const target_times = finished_matrix->get_time_row(target);
+	for ( uint16 y = 0; y < halt_count; ++y )
+	{
+		if ( ( y == target || via_target ) && target_times[y] != UINT32_MAX_VALUE && (uint64)aggregate_time + target_times[y] < origin_times[y] )
+		{
+			affected_columns.append(y);
+		}
+	}
+
+	// neither the origin column nor the target row can change below, so they can be read from the matrix directly
+	for ( uint32 r = 0; r < affected_rows.get_count(); ++r )
+	{
+		const uint16 x = affected_rows[r];
+		uint32 *const times = finished_matrix->get_time_row(x);
+		uint16 *const transfers = finished_matrix->get_transfer_row(x);
+		const uint64 to_target = (uint64)times[origin] + aggregate_time;
+		const uint16 first_transfer = x == origin ? working_halt_list[target].get_id() : transfers[origin];
+
+		for ( uint32 c = 0; c < affected_columns.get_count(); ++c )
+		{
+			const uint16 y = affected_columns[c];
+			const uint64 combined_time = to_target + target_times[y];
+			if ( combined_time < times[y] )
+			{
+				times[y] = (uint32)combined_time;
+				transfers[y] = first_transfer;
+			}
+		}
+	}
+
+	return (uint64)halt_count * 2 + (uint64)affected_rows.get_count() * affected_columns.get_count();
+}
+
+
+bool path_explorer_t::compartment_t::repair_worsened_connexion(const uint16 origin, const uint16 target, uint64 &iterations)
+{
+	// Goods follow the transfers stored in the matrix from halt to halt. So the goods from x to y use the connexion
+	// if their transfers lead them to the origin, and the transfer from the origin to y is the target.
+	// This cannot be told from the stored times, since the path exploration does not try all paths
+	// (see is_transfer_halt, and no transfer is made between the same transport).
+	const uint16 halt_count = finished_halt_count;
+	const uint16 target_id = working_halt_list[target].get_id();
+	const uint32 *const origin_times = finished_matrix->get_time_row(origin);
+	const uint16 *const origin_transfers = finished_matrix->get_transfer_row(origin);
+
+	// 0 : unknown, 1 : being followed, 2 : passes the origin, 3 : does not pass the origin
+	vector_tpl<uint8> state(halt_count);
+	vector_tpl<uint16> chain;
+	// affected entries as (x << 16) | y
+	vector_tpl<uint32> affected_entries;
+
+	for ( uint16 y = 0; y < halt_count; ++y )
+	{
+		if ( y == origin || origin_times[y] == UINT32_MAX_VALUE || origin_transfers[y] != target_id )
+		{
+			continue;
+		}
+
+		state.clear();
+		for ( uint16 i = 0; i < halt_count; ++i )
+		{
+			state.append(0);
+		}
+		state[origin] = 2;
+		state[y] = 3;
+
+		for ( uint16 x = 0; x < halt_count; ++x )
+		{
+			// follow the transfers from x until a halt whose state is known
+			chain.clear();
+			uint16 current = x;
+			while ( state[current] == 0 )
+			{
+				state[current] = 1;
+				chain.append(current);
+				const uint16 next = finished_matrix->time(current, y) != UINT32_MAX_VALUE ? finished_halt_index_map[finished_matrix->transfer_id(current, y)] : 65535;
+				if ( next >= halt_count )
+				{
+					// y cannot be reached from here
+					current = y;
+					break;
+				}
+				current = next;
+			}
+			if ( state[current] == 1 )
+			{
+				// the transfers lead in a circle -> the stored paths cannot be repaired
+				return false;
+			}
+			const uint8 result = state[current];
+			if ( result == 2 && x == origin )
+			{
+				affected_entries.append(((uint32)origin << 16) | y);
+			}
+			for ( uint32 i = 0; i < chain.get_count(); ++i )
+			{
+				state[chain[i]] = result;
+				if ( result == 2 )
+				{
+					affected_entries.append(((uint32)chain[i] << 16) | y);
+				}
+			}
+		}
+		iterations += halt_count;
+	}
+
+	// repair the affected entries row by row
+	std::sort(affected_entries.begin(), affected_entries.end());
+	vector_tpl<uint16> affected_columns;
+	for ( uint32 i = 0; i < affected_entries.get_count(); )
+	{
+		const uint16 x = affected_entries[i] >> 16;
+		affected_columns.clear();
+		for ( ; i < affected_entries.get_count() && ( affected_entries[i] >> 16 ) == x; ++i )
+		{
+			affected_columns.append(affected_entries[i] & 0xFFFF);
+		}
+		iterations += repair_row(x, affected_columns);
+	}
+	return true;
+}
+
+
+uint64 path_explorer_t::compartment_t::repair_row(const uint16 origin, const vector_tpl<uint16> &columns)
+{
+	// Dijkstra search from the origin over the current connexions of all halts in the matrix,
+	// with the same restrictions on transfers as the path exploration
+	const uint16 halt_count = finished_halt_count;
+	vector_tpl<uint32> times(halt_count);
+	vector_tpl<uint16> first_transfers(halt_count);
+	for ( uint16 i = 0; i < halt_count; ++i )
+	{
+		times.append(UINT32_MAX_VALUE);
+		first_transfers.append(0);
+	}
+	uint64 iterations = halt_count;
+
+	binary_heap_tpl<repair_node_t*> open_nodes;
+	repair_node_t *node = new repair_node_t;
+	node->aggregate_time = 0;
+	node->index = origin;
+	node->first_transfer = 0;
+	node->transport = 0;
+	open_nodes.insert(node);
+	times[origin] = 0;
+
+	while ( !open_nodes.empty() )
+	{
+		node = open_nodes.pop();
+		const uint16 current = node->index;
+		const uint32 current_time = node->aggregate_time;
+		const uint16 current_first_transfer = node->first_transfer;
+		const uint32 current_transport = node->transport;
+		delete node;
+
+		if ( current_time > times[current] )
+		{
+			// outdated entry
+			continue;
+		}
+
+		const halthandle_t &current_halt = working_halt_list[current];
+		if ( !current_halt.is_bound() || ( current != origin && !is_transfer_halt(current) ) )
+		{
+			continue;
+		}
+
+		for(auto const& iter : *(current_halt->get_connexions(catg, g_class)))
+		{
+			++iterations;
+			if ( !iter.key.is_bound() )
+			{
+				continue;
+			}
+			const uint16 next = finished_halt_index_map[iter.key.get_id()];
+			const uint32 connexion_time = get_connexion_time(iter.value);
+			const uint32 transport = get_transport_key(iter.value);
+			if ( next == 65535 || connexion_time == UINT32_MAX_VALUE || ( current != origin && transport != 0 && transport == current_transport ) )
+			{
+				continue;
+			}
+
+			const uint64 next_time = (uint64)current_time + connexion_time;
+			if ( next_time < times[next] )
+			{
+				times[next] = (uint32)next_time;
+				first_transfers[next] = current == origin ? iter.key.get_id() : current_first_transfer;
+
+				node = new repair_node_t;
+				node->aggregate_time = (uint32)next_time;
+				node->index = next;
+				node->first_transfer = first_transfers[next];
+				node->transport = transport;
+				open_nodes.insert(node);
+			}
+		}
+	}
+	open_nodes.delete_all_node_objects();
+
+	uint32 *const row_times = finished_matrix->get_time_row(origin);
+	uint16 *const row_transfers = finished_matrix->get_transfer_row(origin);
+	for ( uint32 c = 0; c < columns.get_count(); ++c )
+	{
+		const uint16 y = columns[c];
+		if ( y == origin )
+		{
+			continue;
+		}
+		row_times[y] = times[y];
+		row_transfers[y] = first_transfers[y];
+	}
+	return iterations;
+}
+
+
+void path_explorer_t::compartment_t::set_category(uint8 category)
+{
+	catg = category;
+	const goods_desc_t *ware_type = goods_manager_t::get_info_catg_index(catg);
+	catg_name = ware_type->get_catg_name();
+}
+
+void path_explorer_t::compartment_t::set_class(uint8 value)
+{
+	g_class = value;
+	delete[] class_name;
+	class_name = new char[96];
+
+	if (catg == goods_manager_t::INDEX_PAS)
+	{
+		sprintf(class_name, "%s_%u", translator::translate("p_class"), g_class);
+	}
+	else if (catg == goods_manager_t::INDEX_MAIL)
+	{
+		sprintf(class_name, "%s_%u", translator::translate("m_class"), g_class);
+	}
+	else
+	{
+		class_name[0] = '\0';
+	}
+}
+
+
+void path_explorer_t::compartment_t::initialise_connexion_list()
+{
+	for (uint32 i = 0; i < 65536; ++i)
+	{
+		// Note that the connexion_tables created here will be
+		// swapped with connexion_tables created/stored in halts.
+		connexion_list[i].connexion_table = new haltestelle_t::connexions_map ();
+		connexion_list[i].serving_transport = 0;
+	}
+}
+
+
+void path_explorer_t::compartment_t::reset_connexion_entry(const uint16 halt_id)
+{
+	if ( !connexion_list[halt_id].connexion_table->empty() )
+	{
+		FOR(haltestelle_t::connexions_map, const& iter, (*(connexion_list[halt_id].connexion_table)))
+		{
+			delete iter.value;
+		}
+
+		connexion_list[halt_id].connexion_table->clear();
+	}
 	connexion_list[halt_id].serving_transport = 0;
 }
 
@@ -2105,28 +3154,57 @@ void path_explorer_t::compartment_t::rdwr(loadsave_t* file)
 		{
 			finished_halt_index_map = new uint16[65536];
 		}
-		for (uint32 i = 0; i < 65536; ++i)
+		if (file->is_version_ex_atleast(14, 65))
+		{
+			rdwr_sparse_shorts(file, finished_halt_index_map, 65536, 65535);
+		}
+		else
 		{
-			file->rdwr_short(finished_halt_index_map[i]);
+			for (uint32 i = 0; i < 65536; ++i)
+			{
+				file->rdwr_short(finished_halt_index_map[i]);
+			}
 		}
 	}
 
-	bool finished_matrix_live = finished_matrix != NULL;
+	bool finished_matrix_live = finished_matrix != NULL || finished_table != NULL;
 	file->rdwr_bool(finished_matrix_live);
 
-	if (finished_matrix_live)
+	if (finished_matrix_live && file->is_version_ex_atleast(14, 65))
+	{
+		if (file->is_loading())
+		{
+			finished_matrix = finished_halt_count > 0 ? new path_matrix_t(finished_halt_count) : NULL;
+		}
+		if (finished_matrix)
+		{
+			rdwr_sparse_matrix(file, finished_matrix, NULL);
+		}
+		else if (finished_table)
+		{
+			// expand the rows one at a time
+			uint32 *const times = new uint32[finished_halt_count];
+			uint16 *const transfers = new uint16[finished_halt_count];
+			for (uint16 i = 0; i < finished_halt_count; i++)
+			{
+				finished_table->get_row(i, times, transfers);
+				rdwr_sparse_row(file, times, transfers, NULL, finished_halt_count);
+			}
+			delete[] times;
+			delete[] transfers;
+		}
+	}
+	else if (finished_matrix_live)
 	{
 		if (file->is_saving())
 		{
-			uint16 tmp_idx;
 			for (uint16 i = 0; i < finished_halt_count; i++)
 			{
 				//  This is a 2 dimensional array
 				for (uint32 j = 0; j < finished_halt_count; j++)
 				{
-					file->rdwr_long(finished_matrix[i][j].aggregate_time);
-					tmp_idx = finished_matrix[i][j].next_transfer.get_id();
-					file->rdwr_short(tmp_idx);
+					file->rdwr_long(finished_matrix->time(i, j));
+					file->rdwr_short(finished_matrix->transfer_id(i, j));
 				}
 			}
 		}
@@ -2136,48 +3214,64 @@ void path_explorer_t::compartment_t::rdwr(loadsave_t* file)
 			if (finished_halt_count > 0)
 			{
 				// Build the (empty) finished matrix
-				uint16 tmp_idx;
-				finished_matrix = new path_element_t*[finished_halt_count];
-				for (uint16 i = 0; i < finished_halt_count; ++i)
-				{
-					finished_matrix[i] = new path_element_t[finished_halt_count];
-				}
+				finished_matrix = new path_matrix_t(finished_halt_count);
 
 				// Now load them. These are 2 dimensional arrays.
 				for (uint16 i = 0; i < finished_halt_count; i++)
 				{
 					for (uint32 j = 0; j < finished_halt_count; j++)
 					{
-						file->rdwr_long(finished_matrix[i][j].aggregate_time);
-						file->rdwr_short(tmp_idx);
-						finished_matrix[i][j].next_transfer.set_id(tmp_idx);
+						file->rdwr_long(finished_matrix->time(i, j));
+						file->rdwr_short(finished_matrix->transfer_id(i, j));
 					}
 				}
 			}
 		}
 	}
 
+	// the connexions on which the finished matrix is based; checked once the category and class are known
+	uint64 connexion_hash = 0;
+	if (file->is_version_ex_atleast(14, 65))
+	{
+		if (file->is_saving())
+		{
+			connexion_hash = get_connexion_hash();
+		}
+		file->rdwr_longlong((sint64&)connexion_hash);
+	}
+
 	file->rdwr_short(working_halt_count);
 
 	// Working matrix
 	bool working_matrix_live = working_matrix != NULL;
 	file->rdwr_bool(working_matrix_live);
 
-	if (working_matrix_live)
+	if (working_matrix_live && file->is_version_ex_atleast(14, 65))
+	{
+		if (file->is_loading() && working_halt_count > 0)
+		{
+			working_matrix = new path_matrix_t(working_halt_count);
+			transport_matrix = new transport_element_t[(size_t)working_halt_count * working_halt_count];
+		}
+		if (working_matrix)
+		{
+			rdwr_sparse_matrix(file, working_matrix, transport_matrix);
+		}
+	}
+	else if (working_matrix_live)
 	{
 		if (file->is_saving())
 		{
-			uint16 tmp_idx;
 			for (uint16 i = 0; i < working_halt_count; i++)
 			{
 				for (uint32 j = 0; j < working_halt_count; j++)
 				{
-					file->rdwr_long(working_matrix[i][j].aggregate_time);
-					tmp_idx = working_matrix[i][j].next_transfer.get_id();
-					file->rdwr_short(tmp_idx);
+					file->rdwr_long(working_matrix->time(i, j));
+					file->rdwr_short(working_matrix->transfer_id(i, j));
 
-					file->rdwr_short(transport_matrix[i][j].first_transport);
-					file->rdwr_short(transport_matrix[i][j].last_transport);
+					transport_element_t &transport = transport_matrix[(size_t)i * working_halt_count + j];
+					file->rdwr_short(transport.first_transport);
+					file->rdwr_short(transport.last_transport);
 				}
 			}
 		}
@@ -2188,32 +3282,22 @@ void path_explorer_t::compartment_t::rdwr(loadsave_t* file)
 			if (working_halt_count > 0)
 			{
 				// build working matrix
-				uint16 tmp_idx;
-				working_matrix = new path_element_t*[working_halt_count];
-				for (uint16 i = 0; i < working_halt_count; ++i)
-				{
-					working_matrix[i] = new path_element_t[working_halt_count];
-
-				}
+				working_matrix = new path_matrix_t(working_halt_count);
 
 				// build transport matrix
-				transport_matrix = new transport_element_t*[working_halt_count];
-				for (uint16 i = 0; i < working_halt_count; ++i)
-				{
-					transport_matrix[i] = new transport_element_t[working_halt_count];
-				}
+				transport_matrix = new transport_element_t[(size_t)working_halt_count * working_halt_count];
 
 				// Now load them. These are 2 dimensional arrays.
 				for (uint16 i = 0; i < working_halt_count; i++)
 				{
 					for (uint32 j = 0; j < working_halt_count; j++)
 					{
-						file->rdwr_long(working_matrix[i][j].aggregate_time);
-						file->rdwr_short(tmp_idx);
-						working_matrix[i][j].next_transfer.set_id(tmp_idx);
+						file->rdwr_long(working_matrix->time(i, j));
+						file->rdwr_short(working_matrix->transfer_id(i, j));
 
-						file->rdwr_short(transport_matrix[i][j].first_transport);
-						file->rdwr_short(transport_matrix[i][j].last_transport);
+						transport_element_t &transport = transport_matrix[(size_t)i * working_halt_count + j];
+						file->rdwr_short(transport.first_transport);
+						file->rdwr_short(transport.last_transport);
 					}
 				}
 			}
@@ -2237,9 +3321,16 @@ void path_explorer_t::compartment_t::rdwr(loadsave_t* file)
 				working_halt_index_map[i] = 65535;
 			}
 		}
-		for (uint32 i = 0; i < 65536; ++i)
+		if (file->is_version_ex_atleast(14, 65))
+		{
+			rdwr_sparse_shorts(file, working_halt_index_map, 65536, 65535);
+		}
+		else
 		{
-			file->rdwr_short(working_halt_index_map[i]);
+			for (uint32 i = 0; i < 65536; ++i)
+			{
+				file->rdwr_short(working_halt_index_map[i]);
+			}
 		}
 	}
 
@@ -2253,9 +3344,16 @@ void path_explorer_t::compartment_t::rdwr(loadsave_t* file)
 			transport_index_map = new uint16[131072]();		// initialise all elements to zero
 		}
 
-		for (uint32 i = 0; i < 131072; i++)
+		if (file->is_version_ex_atleast(14, 65))
+		{
+			rdwr_sparse_shorts(file, transport_index_map, 131072, 0);
+		}
+		else
 		{
-			file->rdwr_short(transport_index_map[i]);
+			for (uint32 i = 0; i < 131072; i++)
+			{
+				file->rdwr_short(transport_index_map[i]);
+			}
 		}
 	}
 
@@ -2416,6 +3514,222 @@ void path_explorer_t::compartment_t::rdwr(loadsave_t* file)
 
 	file->rdwr_long(statistic_duration);
 	file->rdwr_long(statistic_iteration);
+
+	if (file->is_version_ex_atleast(14, 64))
+	{
+		file->rdwr_bool(full_refresh_requested);
+		file->rdwr_bool(incremental_refresh);
+
+		uint32 connexion_changes_count = connexion_changes.get_count();
+		file->rdwr_long(connexion_changes_count);
+		if (file->is_loading())
+		{
+			connexion_changes.clear();
+			connexion_changes.resize(connexion_changes_count);
+		}
+		for (uint32 i = 0; i < connexion_changes_count; i++)
+		{
+			connexion_change_t change;
+			if (file->is_saving())
+			{
+				change = connexion_changes[i];
+			}
+			file->rdwr_short(change.origin_id);
+			file->rdwr_short(change.target_id);
+			file->rdwr_long(change.old_time);
+			file->rdwr_long(change.new_time);
+			if (file->is_loading())
+			{
+				connexion_changes.append(change);
+			}
+		}
+	}
+	else if (file->is_loading())
+	{
+		full_refresh_requested = true;
+		incremental_refresh = false;
+		connexion_changes.clear();
+	}
+
+	if (file->is_loading() && file->is_version_ex_atleast(14, 65) && finished_matrix
+		&& catg < path_explorer_t::max_categories && g_class < goods_manager_t::get_classes_catg_index(catg)
+		&& connexion_hash != get_connexion_hash())
+	{
+		// The halts or their connexions differ from those on which the saved paths are based.
+		dbg->warning("path_explorer_t::compartment_t::rdwr()", "Saved paths of category %s, class %s do not match the connexions; refreshing all paths", get_category_name(), get_class_name());
+		path_explorer_t::set_must_refresh_on_loading();
+	}
+
+	if (file->is_loading() && current_phase == phase_check_flag)
+	{
+		// otherwise, this is done when the refresh in progress is completed
+		compact_finished_paths();
+	}
+}
+
+
+void path_explorer_t::compartment_t::rdwr_sparse_shorts(loadsave_t *file, uint16 *values, const uint32 count, const uint16 empty_value)
+{
+	// alternating runs of empty and other values; only the latter are stored
+	uint32 i = 0;
+	while (i < count)
+	{
+		uint32 empty_run = 0;
+		uint32 value_run = 0;
+		if (file->is_saving())
+		{
+			while (i + empty_run < count && values[i + empty_run] == empty_value)
+			{
+				++empty_run;
+			}
+			while (i + empty_run + value_run < count && values[i + empty_run + value_run] != empty_value)
+			{
+				++value_run;
+			}
+		}
+		file->rdwr_long(empty_run);
+		file->rdwr_long(value_run);
+		if (empty_run + value_run == 0 || i + empty_run + value_run > count)
+		{
+			dbg->fatal("path_explorer_t::compartment_t::rdwr_sparse_shorts()", "Corrupt path explorer data");
+		}
+
+		for (uint32 j = 0; j < empty_run; ++j)
+		{
+			values[i++] = empty_value;
+		}
+		for (uint32 j = 0; j < value_run; ++j)
+		{
+			file->rdwr_short(values[i++]);
+		}
+	}
+}
+
+
+void path_explorer_t::compartment_t::rdwr_sparse_matrix(loadsave_t *file, path_matrix_t *matrix, transport_element_t *transports)
+{
+	const uint16 halt_count = matrix->get_halt_count();
+	for (uint16 row = 0; row < halt_count; ++row)
+	{
+		rdwr_sparse_row(file, matrix->get_time_row(row), matrix->get_transfer_row(row), transports ? transports + (size_t)row * halt_count : NULL, halt_count);
+	}
+}
+
+
+void path_explorer_t::compartment_t::rdwr_sparse_row(loadsave_t *file, uint32 *times, uint16 *transfers, transport_element_t *row_transports, const uint16 halt_count)
+{
+	// A row is stored as alternating runs of unreachable and reachable elements; only the latter are stored.
+	// Unreachable elements are left as initialised when the matrix was created.
+	uint32 col = 0;
+	while (col < halt_count)
+	{
+		uint16 empty_run = 0;
+		uint16 value_run = 0;
+		if (file->is_saving())
+		{
+			while (col + empty_run < halt_count && times[col + empty_run] == UINT32_MAX_VALUE && transfers[col + empty_run] == 0
+				   && (!row_transports || (row_transports[col + empty_run].first_transport == 0 && row_transports[col + empty_run].last_transport == 0)))
+			{
+				++empty_run;
+			}
+			while (col + empty_run + value_run < halt_count && (times[col + empty_run + value_run] != UINT32_MAX_VALUE || transfers[col + empty_run + value_run] != 0
+				   || (row_transports && (row_transports[col + empty_run + value_run].first_transport != 0 || row_transports[col + empty_run + value_run].last_transport != 0))))
+			{
+				++value_run;
+			}
+		}
+		file->rdwr_short(empty_run);
+		file->rdwr_short(value_run);
+		if (empty_run + value_run == 0 || col + empty_run + value_run > halt_count)
+		{
+			dbg->fatal("path_explorer_t::compartment_t::rdwr_sparse_row()", "Corrupt path explorer data");
+		}
+
+		col += empty_run;
+		for (uint16 i = 0; i < value_run; ++i, ++col)
+		{
+			file->rdwr_long(times[col]);
+			file->rdwr_short(transfers[col]);
+			if (row_transports)
+			{
+				file->rdwr_short(row_transports[col].first_transport);
+				file->rdwr_short(row_transports[col].last_transport);
+			}
+		}
+	}
+}
+
+
+void path_explorer_t::compartment_t::compact_finished_paths()
+{
+	if ( !finished_matrix || compacting_table || compact_threshold == 0 || finished_halt_count < compact_threshold )
+	{
+		return;
+	}
+
+	compacting_table = new next_hop_table_t(finished_halt_count, finished_halt_index_map);
+}
+
+
+void path_explorer_t::compartment_t::step_compacting()
+{
+	bool too_large;
+	total_iterations += (uint32)compacting_table->build(*finished_matrix, use_limits ? limit_explore_paths : 0, too_large);
+	if ( too_large )
+	{
+		// too many different next transfers for the table to be any smaller
+		delete compacting_table;
+		compacting_table = NULL;
+	}
+	else if ( compacting_table->is_complete() )
+	{
+		delete finished_matrix;
+		finished_matrix = NULL;
+		finished_table = compacting_table;
+		compacting_table = NULL;
+	}
+}
+
+
+uint64 path_explorer_t::compartment_t::get_connexion_hash() const
+{
+	// FNV-1a over the halts of the finished matrix in index order. The connexions of each halt are
+	// summed up, as the iteration order of the connexion hash tables is not preserved in the savegame.
+	const uint64 fnv_prime = 1099511628211ull;
+	uint64 hash = 14695981039346656037ull;
+	if (!finished_halt_index_map)
+	{
+		return hash;
+	}
+
+	for (uint32 id = 1; id < 65536; ++id)
+	{
+		const uint16 index = finished_halt_index_map[id];
+		if (index == 65535)
+		{
+			continue;
+		}
+
+		halthandle_t halt;
+		halt.set_id((uint16)id);
+		uint64 connexions_sum = 0;
+		const haltestelle_t::connexions_map *const connexions = halt.is_bound() ? halt->get_connexions(catg, g_class) : NULL;
+		if (connexions)
+		{
+			for (auto const& iter : *connexions)
+			{
+				uint64 value = ((uint64)iter.key.get_id() << 32) | get_connexion_time(iter.value);
+				value *= 0x9E3779B97F4A7C15ull;
+				connexions_sum += value ^ (value >> 29);
+			}
+		}
+
+		hash = (hash ^ id) * fnv_prime;
+		hash = (hash ^ index) * fnv_prime;
+		hash = (hash ^ (halt.is_bound() ? 1 : 0)) * fnv_prime;
+		hash = (hash ^ connexions_sum) * fnv_prime;
+	}
+	return hash;
 }
 
 void path_explorer_t::compartment_t::connection_t::rdwr(loadsave_t* file)
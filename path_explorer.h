@@ -17,6 +17,8 @@
 #include "simtypes.h"
 #include "simdebug.h"
 
+#include "utils/cpu_features.h"
+
 #include "tpl/vector_tpl.h"
 #include "tpl/quickstone_hashtable_tpl.h"
 
@@ -114,6 +116,9 @@ private:
 	class compartment_t
 	{
 		friend class path_explorer_t;
+#ifdef MULTI_THREAD
+		friend void *path_explorer_worker_threaded(void* args);
+#endif
 
 	protected:
 		// structure for storing connexion hashtable and serving transport counter
@@ -125,15 +130,101 @@ private:
 
 	private:
 
-		// element used during path search and for storing calculated paths
-		struct path_element_t
+		// matrix used during path search and for storing calculated paths
+		// the data is stored as a structure of arrays in row-major order :
+		// a contiguous matrix of aggregate times, and a separate matrix of next transfer halt ids
+		class path_matrix_t
 		{
-			uint32 aggregate_time;
-			halthandle_t next_transfer;
+			uint32 *aggregate_time;
+			uint16 *next_transfer;
+			uint16 halt_count;
 
-			path_element_t() :
-				aggregate_time(UINT32_MAX_VALUE)
-			{}
+		public:
+
+			explicit path_matrix_t(const uint16 count);
+			~path_matrix_t();
+
+			uint16 get_halt_count() const { return halt_count; }
+
+			uint32 *get_time_row(const uint16 row) { return aggregate_time + (size_t)row * halt_count; }
+			const uint32 *get_time_row(const uint16 row) const { return aggregate_time + (size_t)row * halt_count; }
+
+			uint16 *get_transfer_row(const uint16 row) { return next_transfer + (size_t)row * halt_count; }
+			const uint16 *get_transfer_row(const uint16 row) const { return next_transfer + (size_t)row * halt_count; }
+
+			uint32 &time(const uint16 row, const uint16 column) { return aggregate_time[(size_t)row * halt_count + column]; }
+			uint32 time(const uint16 row, const uint16 column) const { return aggregate_time[(size_t)row * halt_count + column]; }
+
+			uint16 &transfer_id(const uint16 row, const uint16 column) { return next_transfer[(size_t)row * halt_count + column]; }
+			uint16 transfer_id(const uint16 row, const uint16 column) const { return next_transfer[(size_t)row * halt_count + column]; }
+
+			halthandle_t get_next_transfer(const uint16 row, const uint16 column) const
+			{
+				halthandle_t halt;
+				halt.set_id( transfer_id(row, column) );
+				return halt;
+			}
+		};
+
+		// compact storage of calculated paths for compartments with many halts
+		// Each row keeps the next transfers to all targets as runs over the targets sorted by their
+		// position on the map, since nearby targets are mostly reached over the same next transfer.
+		// Aggregate times are only stored where they cannot be added up along the next transfers:
+		// for direct connexions, and for paths which do not go on like the path of their next transfer.
+		// The table is built a number of rows at a time from the finished matrix, and lookups
+		// always return exactly the calculated paths.
+		class next_hop_table_t
+		{
+			struct run_t
+			{
+				uint16 first_position;	// of the first target of the run in the target order
+				uint16 next_transfer;
+			};
+
+			struct stored_time_t
+			{
+				uint16 target;
+				uint32 aggregate_time;
+			};
+
+			uint16 halt_count;
+			const uint16 *halt_index_map;	// of the compartment, which keeps it as long as this table
+
+			// position of each target in the order of the runs
+			uint16 *target_position;
+
+			// runs and stored times of all rows; those of row i range from start[i] to start[i+1]
+			uint32 *run_start;
+			run_t *runs;
+			uint32 *time_start;
+			stored_time_t *times;
+
+			// used while building
+			uint16 built_rows;
+			vector_tpl<run_t> *run_list;
+			vector_tpl<stored_time_t> *time_list;
+
+			uint16 get_next_transfer(const uint16 row, const uint16 column) const;
+			bool get_stored_time(const uint16 row, const uint16 column, uint32 &aggregate_time) const;
+
+		public:
+
+			next_hop_table_t(const uint16 count, const uint16 *halt_map);
+			~next_hop_table_t();
+
+			// build further rows from the matrix until the iteration limit (0 for no limit) is reached;
+			// returns the number of iterations, and false in too_large if the table is no smaller than the matrix
+			uint64 build(const path_matrix_t &matrix, const uint64 limit, bool &too_large);
+			bool is_complete() const { return built_rows == halt_count; }
+
+			uint16 get_halt_count() const { return halt_count; }
+
+			void get_path(const uint16 row, const uint16 column, uint32 &aggregate_time, uint16 &next_transfer) const;
+
+			// expand a complete row, e.g. for saving
+			void get_row(const uint16 row, uint32 *times, uint16 *transfers) const;
+
+			size_t get_memory_size() const;
 		};
 
 		// element used during path search only for storing best lines/convoys
@@ -268,18 +359,41 @@ private:
 			convoihandle_t convoy;
 		};
 
+		// element used for recording a changed connexion between two refreshes
+		struct connexion_change_t
+		{
+			uint16 origin_id;	// halt ids, not matrix indices
+			uint16 target_id;
+			uint32 old_time;	// UINT32_MAX_VALUE if the connexion is new
+			uint32 new_time;	// UINT32_MAX_VALUE if the connexion was removed
+		};
+
+		// element used for repairing single rows of the finished matrix
+		struct repair_node_t
+		{
+			uint32 aggregate_time;
+			uint16 index;
+			uint16 first_transfer;
+			uint32 transport;	// see get_transport_key()
+
+			bool operator <= (const repair_node_t &other) const { return aggregate_time <= other.aggregate_time; }
+		};
+
 		// store the start time of refresh
 		sint64 refresh_start_time;
 
 		// set of variables for finished path data
-		path_element_t **finished_matrix;
+		// at most one of finished_matrix and finished_table is used; compacting_table is built from finished_matrix
+		path_matrix_t *finished_matrix;
+		next_hop_table_t *finished_table;
+		next_hop_table_t *compacting_table;
 		uint16 *finished_halt_index_map;
 		uint16 finished_halt_count;
 
 		// set of variables for working path data
-		path_element_t **working_matrix;
+		path_matrix_t *working_matrix;
 		uint16 *transport_index_map;
-		transport_element_t **transport_matrix;
+		transport_element_t *transport_matrix;	// contiguous, row-major; same dimensions as working matrix
 		uint16 *working_halt_index_map;
 		halthandle_t *working_halt_list;
 		uint16 working_halt_count;
@@ -291,6 +405,13 @@ private:
 		// a vector for storing lines and lineless convoys
 		vector_tpl<linkage_t> *linkages;
 
+		// set of variables for incremental refreshes
+		// -> if only few connexions have changed and the set of halts is unchanged, the finished matrix
+		//    is repaired in place instead of being recalculated from scratch
+		vector_tpl<connexion_change_t> connexion_changes;
+		bool full_refresh_requested;	// the next refresh must recalculate the whole matrix
+		bool incremental_refresh;		// the current refresh collects connexion changes for an incremental update
+
 		// set of variables for transfer list
 		uint16 *transfer_list;
 		uint16 transfer_count;
@@ -389,12 +510,97 @@ private:
 		static uint32 time_upper_limit;
 		static uint32 time_threshold;
 
+		// maximum number of changed connexions which are still applied incrementally
+		// 0 means that incremental refreshes are disabled. Set by simuconf.tab.
+		static uint32 incremental_threshold;
+
+		// minimum number of halts from which finished paths are stored in a next hop table
+		// 0 means that finished paths are always stored in a matrix. Set by simuconf.tab.
+		static uint32 compact_threshold;
+
 		// percentage time limits
 		static const uint32 percent_deviation = 5;
 		static const uint32 percent_lower_limit = 100 - percent_deviation;
 		static const uint32 percent_upper_limit = 100 + percent_deviation;
 
-		void enumerate_all_paths(const path_element_t *const *const matrix, const halthandle_t *const halt_list,
+		// signature of the relaxation kernel used in path exploration
+		// for one origin, relax all targets in the list via the current transfer
+		typedef void (*relax_kernel_t)(uint32 *origin_times, uint16 *origin_transfers, transport_element_t *origin_transports,
+									   const uint32 *via_times, const transport_element_t *via_transports,
+									   const uint16 *targets, const uint32 target_count,
+									   const uint32 origin_via_time, const uint16 origin_via_transfer, const uint16 origin_via_transport);
+
+		// kernel selected at initialisation according to the processor's capabilities
+		static relax_kernel_t relax_kernel;
+
+		static void relax_single_target(uint32 *origin_times, uint16 *origin_transfers, transport_element_t *origin_transports,
+										const uint32 *via_times, const transport_element_t *via_transports,
+										const uint16 target, const uint32 origin_via_time, const uint16 origin_via_transfer, const uint16 origin_via_transport);
+
+		static void relax_targets_scalar(uint32 *origin_times, uint16 *origin_transfers, transport_element_t *origin_transports,
+										 const uint32 *via_times, const transport_element_t *via_transports,
+										 const uint16 *targets, const uint32 target_count,
+										 const uint32 origin_via_time, const uint16 origin_via_transfer, const uint16 origin_via_transport);
+#ifdef SIMD_SSE2
+		static void relax_targets_sse2(uint32 *origin_times, uint16 *origin_transfers, transport_element_t *origin_transports,
+									   const uint32 *via_times, const transport_element_t *via_transports,
+									   const uint16 *targets, const uint32 target_count,
+									   const uint32 origin_via_time, const uint16 origin_via_transfer, const uint16 origin_via_transport);
+#endif
+#ifdef SIMD_AVX2
+		static void relax_targets_avx2(uint32 *origin_times, uint16 *origin_transfers, transport_element_t *origin_transports,
+									   const uint32 *via_times, const transport_element_t *via_transports,
+									   const uint16 *targets, const uint32 target_count,
+									   const uint32 origin_via_time, const uint16 origin_via_transfer, const uint16 origin_via_transport);
+#endif
+
+#ifdef MULTI_THREAD
+		// the transfer currently explored by the helper threads
+		static compartment_t *parallel_compartment;
+		static uint16 parallel_via;
+		// origins of the current transfer : inbound transport in the upper 16 bits, origin index in the lower 16 bits
+		static vector_tpl<uint32> parallel_origins;
+
+		// number of helper threads; 0 means that all paths are explored by the calling thread only
+		static uint32 worker_count;
+
+		// a transfer is only explored in parallel if it requires at least this number of iterations
+		static const uint64 min_parallel_iterations = 0x4000;
+
+		uint64 count_transfer_iterations() const;
+		void explore_transfer_in_parallel(const uint16 via);
+		void explore_parallel_origins(const uint32 thread_number) const;
+#endif
+
+		static uint32 get_connexion_time(const haltestelle_t::connexion *cnx);
+		// 0 for walking, otherwise unique for each line and lineless convoy
+		static uint32 get_transport_key(const haltestelle_t::connexion *cnx);
+
+		// compact storage of the path data in savegames
+		static void rdwr_sparse_shorts(loadsave_t *file, uint16 *values, const uint32 count, const uint16 empty_value);
+		static void rdwr_sparse_row(loadsave_t *file, uint32 *times, uint16 *transfers, transport_element_t *transports, const uint16 count);
+		static void rdwr_sparse_matrix(loadsave_t *file, path_matrix_t *matrix, transport_element_t *transports);
+
+		// start replacing the finished matrix by a next hop table if this may save memory
+		void compact_finished_paths();
+		// build the next hop table further within the iteration limit, and use it once it is complete
+		void step_compacting();
+		uint64 get_connexion_hash() const;
+
+		// functions for incremental refreshes
+		void record_connexion_changes(const halthandle_t &halt, const haltestelle_t::connexions_map *old_connexions, const haltestelle_t::connexions_map *new_connexions);
+		bool can_update_incrementally() const;
+		enum incremental_state_t { incremental_done, incremental_suspended, incremental_failed };
+		// resumes at the change phase_counter and stops when the iteration limit is reached
+		incremental_state_t apply_connexion_changes();
+		// like in path exploration, goods only change between different transports at transfer halts
+		bool is_transfer_halt(const uint16 index) const;
+		// these return the number of iterations, or false if the matrix cannot be repaired
+		uint64 insert_improved_connexion(const uint16 origin, const uint16 target, const uint32 aggregate_time);
+		bool repair_worsened_connexion(const uint16 origin, const uint16 target, uint64 &iterations);
+		uint64 repair_row(const uint16 origin, const vector_tpl<uint16> &columns);
+
+		void enumerate_all_paths(const path_matrix_t *const matrix, const halthandle_t *const halt_list,
 								 const uint16 *const halt_map, const uint16 halt_count);
 
 	public:
@@ -415,6 +621,7 @@ private:
 		bool are_paths_available() const { return paths_available; }
 		bool is_refresh_completed() const { return refresh_completed; }
 		bool is_refresh_requested() const { return refresh_requested; }
+		bool is_compacting() const { return compacting_table != NULL; }
 
 		// Note that these are only used for the client/server synchronisation checklist for diagnostic purposes.
 		uint8 get_current_phase() const { return current_phase; }
@@ -426,7 +633,15 @@ private:
 
 		void set_category(uint8 category);
 		void set_class(uint8 value);
-		void set_refresh() { refresh_requested = true; }
+		// an incremental refresh only repairs the finished matrix where connexions have changed, if possible
+		void set_refresh(const bool incremental = false)
+		{
+			refresh_requested = true;
+			if( !incremental )
+			{
+				full_refresh_requested = true;
+			}
+		}
 
 		bool get_path_between(const halthandle_t origin_halt, const halthandle_t target_halt,
 							  uint32 &aggregate_time, halthandle_t &next_transfer);
@@ -502,6 +717,11 @@ public:
 #ifdef MULTI_THREAD
 	static thread_local bool allow_path_explorer_on_this_thread;
 	friend void *path_explorer_threaded(void* args);
+	friend void *path_explorer_worker_threaded(void* args);
+
+	// helper threads which explore the paths of a single transfer halt in parallel
+	static void initialise_workers(const uint32 count);
+	static void finalise_workers();
 #endif
 	static void initialise(karte_t *welt);
 	static void finalise();
@@ -510,8 +730,8 @@ public:
 
 	static void full_instant_refresh();
 	static void refresh_all_categories(const bool reset_working_set);
-	static void refresh_category(const uint8 category);
-	static void refresh_class_category(const uint8 category, const uint8 g_class);
+	static void refresh_category(const uint8 category, const bool incremental = false);
+	static void refresh_class_category(const uint8 category, const uint8 g_class, const bool incremental = false);
 	static bool get_catg_path_between(const uint8 category, const halthandle_t origin_halt, const halthandle_t target_halt,
 									  uint32 &aggregate_time, halthandle_t &next_transfer, uint8 g_class = 0)
 	{
@@ -1418,6 +1418,9 @@ void player_t::take_over(player_t* target_player)
 		}
 	}
 
+	// the ways and the private way signs changed their owners
+	weg_t::invalidate_all_routes();
+
 	// Transfer stops
 	// Adapted from the liquidation algorithm
 	slist_tpl<halthandle_t> halt_list;
@@ -1469,6 +1472,8 @@ void player_t::take_over(player_t* target_player)
 			}
 		}
 	}
+	// the ways of the taken over player have changed hands
+	weg_t::invalidate_all_routes();
 
 	calc_assets();
 
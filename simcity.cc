@@ -71,8 +71,6 @@
 
 #include "tpl/minivec_tpl.h"
 
-uint32 weg_t::private_car_routes_currently_reading_element;
-
 // since we use 32 bit per growth steps, we use this variable to take care of the remaining sub citizen growth
 #define CITYGROWTH_PER_CITIZEN (0x0000000100000000ll)
 
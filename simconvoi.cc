@@ -1734,10 +1734,26 @@ bool convoi_t::drive_to()
  * Ein Fahrzeug hat ein Problem erkannt und erzwingt die
  * Berechnung einer neuen Route
  */
+void convoi_t::set_wait_lock(sint32 value)
+{
+	wait_lock = value;
+	// a shorter wait must not be held up by the idle time of the old one
+	welt->sync.wake(this);
+}
+
+
+sint32 convoi_t::get_wait_lock() const
+{
+	// while idle, the waiting time is not counted down
+	return wait_lock - (sint32)welt->sync.get_idle_time(this);
+}
+
+
 void convoi_t::suche_neue_route()
 {
 	state = ROUTING_1;
 	wait_lock = 0;
+	welt->sync.wake(this);
 }
 
 /**
@@ -2672,7 +2688,8 @@ void convoi_t::enter_depot(depot_t *dep)
 	close_windows();
 
 	state = INITIAL;
-	wait_lock = 0;
+	// also sent to a depot from outside the sync step, e.g. by the player
+	set_wait_lock(0);
 }
 
 
@@ -2744,7 +2761,7 @@ void convoi_t::start(depot_t* dep)
 			// Added by : Knightly
 			haltestelle_t::refresh_routing(schedule, goods_catg_index, NULL, NULL, owner);
 		}
-		wait_lock = 0;
+		set_wait_lock(0);
 
 		DBG_MESSAGE("convoi_t::start()","Convoi %s wechselt von INITIAL nach ROUTING_1", name_and_id);
 	}
@@ -3228,6 +3245,7 @@ bool convoi_t::set_schedule(schedule_t * sch)
 	// to avoid jumping trains
 	alte_direction = front()->get_direction();
 	wait_lock = 0;
+	welt->sync.wake(this);
 	return true;
 }
 
@@ -3968,7 +3986,14 @@ void convoi_t::rdwr(loadsave_t *file)
 	wait_lock += wait_lock_next_step;
 	wait_lock_next_step = 0;
 
-	file->rdwr_long(wait_lock);
+	if(  file->is_saving()  ) {
+		// an idle convoy has not counted down the time it was left out of the sync steps yet
+		sint32 current_wait_lock = get_wait_lock();
+		file->rdwr_long(current_wait_lock);
+	}
+	else {
+		file->rdwr_long(wait_lock);
+	}
 	// some versions may produce broken savegames apparently
 	if(wait_lock > 1470000 && file->get_extended_version() < 11)
 	{
@@ -5191,7 +5216,7 @@ void convoi_t::open_schedule_window( bool show )
 	if(state!=INITIAL) {
 		state = EDIT_SCHEDULE;
 	}
-	wait_lock = 25000;
+	set_wait_lock(25000);
 	alte_direction = front()->get_direction();
 
 	// Added by : Knightly
@@ -6204,6 +6229,7 @@ void convoi_t::self_destruct()
 	else {
 		state = SELF_DESTRUCT;
 		wait_lock = 0;
+		welt->sync.wake(this);
 	}
 }
 
@@ -6587,6 +6613,7 @@ end_check:
 			// make this change immediately
 			if(  !is_loading()  ) {
 				wait_lock = 0;
+				welt->sync.wake(this);
 			}
 		}
 	}
@@ -7562,12 +7589,12 @@ void convoi_t::snprintf_remaining_loading_time(char *p, size_t size) const
  */
 void convoi_t::snprintf_remaining_reversing_time(char *p, size_t size) const
 {
-	welt->sprintf_ticks(p, size, wait_lock);
+	welt->sprintf_ticks(p, size, get_wait_lock());
 }
 
 void convoi_t::snprintf_remaining_emergency_stop_time(char *p, size_t size) const
 {
-	welt->sprintf_ticks(p, size, wait_lock);
+	welt->sprintf_ticks(p, size, get_wait_lock());
 }
 
 uint32 convoi_t::calc_highest_axle_load()
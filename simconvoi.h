@@ -1008,6 +1008,11 @@ public:
 	 */
 	sync_result sync_step(uint32 delta_t) OVERRIDE;
 
+	/**
+	 * While the wait_lock runs, sync_step() only counts it down.
+	 */
+	uint32 get_sync_idle_ticks() const OVERRIDE { return wait_lock > 0 ? wait_lock : 0; }
+
 	/**
 	 * All things like route search or loading, that may take a little
 	 */
@@ -1138,8 +1143,8 @@ public:
 	void set_maximum_signal_speed(sint32 value) { max_signal_speed = value; }
 	sint32 get_max_signal_speed() const { return max_signal_speed; }
 
-	inline void set_wait_lock(sint32 value) { wait_lock = value; }
-	inline sint32 get_wait_lock() { return wait_lock; }
+	void set_wait_lock(sint32 value);
+	sint32 get_wait_lock() const;
 
 	bool check_destination_reverse(route_t* current_route = NULL, route_t* target_rt = NULL);
 
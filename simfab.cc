@@ -38,6 +38,7 @@
 
 #include "dataobj/settings.h"
 #include "dataobj/environment.h"
+#include "dataobj/halt_grid.h"
 #include "dataobj/translator.h"
 #include "dataobj/loadsave.h"
 
@@ -56,6 +57,11 @@
 
 #include "path_explorer.h"
 
+#ifdef MULTI_THREAD
+#include "utils/simthread.h"
+#include "utils/work_stealing.h"
+#endif
+
 
 // Fabrik_t
 
@@ -2300,6 +2306,160 @@ void fabrik_t::remove_contracts(){
 	calc_max_intransit_percentages();
 }
 
+#ifdef MULTI_THREAD
+static vector_tpl<pthread_t> contract_route_worker_threads;
+static simthread_barrier_t contract_route_worker_barrier;
+static bool contract_route_workers_terminating = false;
+static uint32 contract_route_worker_count = 0;
+
+// the factories searching contract routes in parallel, and which thread does which
+static const vector_tpl<fabrik_t *> *contract_route_fabs = NULL;
+static uint32 contract_route_delta_t = 0;
+static work_stealing_ranges_t contract_route_jobs;
+
+void *contract_route_worker_threaded(void* args)
+{
+	const uint32 thread_number = *(const uint32*)args;
+	delete (const uint32*)args;
+
+	while (true)
+	{
+		simthread_barrier_wait(&contract_route_worker_barrier);
+		if (contract_route_workers_terminating)
+		{
+			return NULL;
+		}
+		fabrik_t::prepare_contract_routes_jobs(thread_number);
+		simthread_barrier_wait(&contract_route_worker_barrier);
+	}
+
+	return NULL;
+}
+#endif
+
+
+void fabrik_t::initialise_workers(uint32 count)
+{
+#ifdef MULTI_THREAD
+	if (count == 0 || contract_route_worker_count > 0)
+	{
+		return;
+	}
+
+	contract_route_workers_terminating = false;
+	simthread_barrier_init(&contract_route_worker_barrier, NULL, count + 1);
+
+	pthread_attr_t thread_attributes;
+	pthread_attr_init(&thread_attributes);
+	pthread_attr_setdetachstate(&thread_attributes, PTHREAD_CREATE_JOINABLE);
+	for (uint32 i = 1; i <= count; i++)
+	{
+		pthread_t thread;
+		uint32* thread_number = new uint32;
+		*thread_number = i;
+		const int rc = pthread_create(&thread, &thread_attributes, &contract_route_worker_threaded, (void*)thread_number);
+		if (rc)
+		{
+			dbg->fatal("void fabrik_t::initialise_workers()", "Failed to create factory contract route thread, error %d. See here for a translation of the error numbers: http://epydoc.sourceforge.net/stdlib/errno-module.html", rc);
+		}
+		contract_route_worker_threads.append(thread);
+	}
+	pthread_attr_destroy(&thread_attributes);
+
+	contract_route_worker_count = count;
+#else
+	(void)count;
+#endif
+}
+
+
+void fabrik_t::finalise_workers()
+{
+#ifdef MULTI_THREAD
+	if (contract_route_worker_count == 0)
+	{
+		return;
+	}
+
+	contract_route_worker_count = 0;
+
+	contract_route_workers_terminating = true;
+	simthread_barrier_wait(&contract_route_worker_barrier);
+	FOR(vector_tpl<pthread_t>, const thread, contract_route_worker_threads)
+	{
+		pthread_join(thread, NULL);
+	}
+	contract_route_worker_threads.clear();
+	simthread_barrier_destroy(&contract_route_worker_barrier);
+	contract_route_workers_terminating = false;
+#endif
+}
+
+
+void fabrik_t::prepare_contract_routes_jobs(uint32 thread_number)
+{
+#ifdef MULTI_THREAD
+	uint32 i;
+	while (contract_route_jobs.get_next(thread_number, i))
+	{
+		(*contract_route_fabs)[i]->prepare_contract_routes(contract_route_delta_t);
+	}
+#else
+	(void)thread_number;
+#endif
+}
+
+
+void fabrik_t::step_all(const vector_tpl<fabrik_t *> &fabs, uint32 delta_t)
+{
+	FOR(vector_tpl<fabrik_t *>, const fab, fabs)
+	{
+		if (!fab->has_calculated_intransit_percentages)
+		{
+			// Can only do it here (once after loading) as paths
+			// are not available when loading, even in finish_rd
+			fab->calc_max_intransit_percentages();
+		}
+	}
+
+	if (delta_t == 0)
+	{
+		return;
+	}
+
+	// Each factory produces and hands out its goods before the next one steps, as handing out
+	// reads the storage of the consumers (see verteile_waren and distribute_contracts).
+	// Only the route searches for the contracts do not depend on that, so they can run in parallel.
+	if(welt->get_settings().using_fab_contracts()) {
+#ifdef MULTI_THREAD
+		if (contract_route_worker_count > 0 && fabs.get_count() > 1)
+		{
+			contract_route_fabs = &fabs;
+			contract_route_delta_t = delta_t;
+			contract_route_jobs.init(fabs.get_count(), contract_route_worker_count + 1);
+			simthread_barrier_wait(&contract_route_worker_barrier);
+			prepare_contract_routes_jobs(0);
+			simthread_barrier_wait(&contract_route_worker_barrier);
+			contract_route_fabs = NULL;
+		}
+		else
+#endif
+		{
+			FOR(vector_tpl<fabrik_t *>, const fab, fabs)
+			{
+				fab->prepare_contract_routes(delta_t);
+			}
+		}
+	}
+
+	FOR(vector_tpl<fabrik_t *>, const fab, fabs)
+	{
+		fab->step_production(delta_t);
+		fab->step_distribution(delta_t);
+	}
+}
+
+
 void fabrik_t::step(uint32 delta_t)
 {
 	if(!has_calculated_intransit_percentages)
@@ -2313,6 +2473,16 @@ void fabrik_t::step(uint32 delta_t)
 		return;
 	}
 
+	if(welt->get_settings().using_fab_contracts()){
+		prepare_contract_routes(delta_t);
+	}
+	step_production(delta_t);
+	step_distribution(delta_t);
+}
+
+
+void fabrik_t::step_production(uint32 delta_t)
+{
 	if(welt->get_settings().using_fab_contracts()){
 		step_contracts(delta_t);
 		return;
@@ -2517,6 +2687,24 @@ void fabrik_t::step(uint32 delta_t)
 	if(  !desc->is_electricity_producer()  ) {
 		power = 0;
 	}
+}
+
+
+void fabrik_t::step_distribution(uint32 delta_t)
+{
+	if(welt->get_settings().using_fab_contracts()){
+		distribute_contracts(delta_t);
+
+		delta_t_sum += delta_t;
+		if(delta_t_sum > PRODUCTION_DELTA_T){
+			delta_t_sum %= PRODUCTION_DELTA_T;
+			recalc_factory_status();
+			rescale_delta();
+		}
+
+		advance_slot(delta_t);
+		return;
+	}
 
 	delta_t_sum += delta_t;
 	if(  delta_t_sum > PRODUCTION_DELTA_T  ) {
@@ -2677,17 +2865,6 @@ void fabrik_t::step_contracts(uint32 delta_t){
 	if(  !desc->is_electricity_producer()  ) {
 		power = 0;
 	}
-
-	distribute_contracts(delta_t);
-
-	delta_t_sum += delta_t;
-	if(delta_t_sum > PRODUCTION_DELTA_T){
-		delta_t_sum %= PRODUCTION_DELTA_T;
-		recalc_factory_status();
-		rescale_delta();
-	}
-
-	advance_slot(delta_t);
 }
 
 void fabrik_t::rescale_delta(){
@@ -2743,20 +2920,62 @@ void fabrik_t::advance_slot(uint32 delta_t){
 	}
 }
 
+uint64 fabrik_t::get_contract_step_amount(uint32 product, uint32 link, uint32 delta_t) const
+{
+	const uint64 current_ticks=welt->get_ticks();
+	const uint64 last_ticks=welt->get_ticks()-delta_t;
+	const uint64 monthly_contract=output[product].get_contract(link);
+	uint64 current_tonnes=current_ticks * monthly_contract / (welt->ticks_per_world_month << fabrik_t::precision_bits);
+	current_tonnes-=last_ticks * monthly_contract / (welt->ticks_per_world_month << fabrik_t::precision_bits);
+	return current_tonnes;
+}
+
+bool fabrik_t::can_cart_contract_to(koord consumer_pos) const
+{
+	return shortest_distance(consumer_pos, pos.get_2d()) <= welt->get_settings().get_station_coverage_factories()
+		&& get_fab(consumer_pos)
+		&& get_desc()->get_placement() != factory_desc_t::Water;
+}
+
+void fabrik_t::prepare_contract_routes(uint32 delta_t){
+	// The routes from the nearby halts only depend on the paths, so they can be
+	// searched for all factories in parallel before they step. Which halt gets the
+	// goods depends on the goods waiting there, so that is decided in distribute_contracts().
+	// The stock is not known before production, so this searches for every link due goods.
+	contract_routes.clear();
+	for(uint32 j = 0; j < output.get_count(); j++){
+		for(uint32 i = 0; i < output[j].link_count(); i++){
+			const uint64 current_tonnes=get_contract_step_amount(j, i, delta_t);
+			if(!current_tonnes || can_cart_contract_to(output[j].link_from_index(i))){
+				continue;
+			}
+			for(auto nearby_halt : nearby_freight_halts){
+				contract_route_t route;
+				route.product=j;
+				route.link=i;
+				route.halt=nearby_halt.halt;
+				ware_t ware(output[j].get_typ(),nearby_halt.halt);
+				ware.menge=current_tonnes;
+				ware.set_zielpos(output[j].link_from_index(i));
+				route.found=nearby_halt.halt->find_route(ware) != UINT32_MAX_VALUE;
+				route.ziel=ware.get_ziel();
+				route.zwischenziel=ware.get_zwischenziel();
+				contract_routes.append(route);
+			}
+		}
+	}
+}
+
 void fabrik_t::distribute_contracts(uint32 delta_t){
-	uint64 current_ticks=welt->get_ticks();
-	uint64 last_ticks=welt->get_ticks()-delta_t;
+	// the next of the routes found by prepare_contract_routes()
+	uint32 next_route=0;
 
 	for(uint32 j = 0; j < output.get_count(); j++){
 		for(uint32 i = 0; i < output[j].link_count(); i++){
-			uint64 monthly_contract=output[j].get_contract(i);
-			uint64 current_tonnes=current_ticks * monthly_contract / (welt->ticks_per_world_month << fabrik_t::precision_bits);
-			current_tonnes-=last_ticks * monthly_contract / (welt->ticks_per_world_month << fabrik_t::precision_bits);
+			const uint64 current_tonnes=get_contract_step_amount(j, i, delta_t);
 			if(current_tonnes && output[j].menge >= (sint32)(current_tonnes << fabrik_t::precision_bits)){
 				koord consumer_pos=output[j].link_from_index(i);
-				if (shortest_distance(consumer_pos, pos.get_2d()) <= welt->get_settings().get_station_coverage_factories()
-						&& get_fab(consumer_pos)
-						&& get_desc()->get_placement() != factory_desc_t::Water)
+				if (can_cart_contract_to(consumer_pos))
 				{
 					//walk toods to destination
 					fabrik_t* consumer=get_fab(consumer_pos);
@@ -2784,12 +3003,26 @@ void fabrik_t::distribute_contracts(uint32 delta_t){
 					sint32 max_freespace_ratio=-1;
 					ware_t best_ware;
 					halthandle_t best_halt;
+					while(next_route < contract_routes.get_count() && (contract_routes[next_route].product < j || (contract_routes[next_route].product == j && contract_routes[next_route].link < i))){
+						next_route++;
+					}
 					for(auto nearby_halt : nearby_freight_halts){
 						ware_t ware(output[j].get_typ(),nearby_halt.halt);
 						ware.menge=current_tonnes;
 						ware.set_zielpos(output[j].link_from_index(i));
 
-						if(nearby_halt.halt->find_route(ware) != UINT32_MAX_VALUE){
+						bool found;
+						if(next_route < contract_routes.get_count() && contract_routes[next_route].product == j && contract_routes[next_route].link == i && contract_routes[next_route].halt == nearby_halt.halt){
+							const contract_route_t &route=contract_routes[next_route++];
+							found=route.found;
+							ware.set_ziel(route.ziel);
+							ware.set_zwischenziel(route.zwischenziel);
+						}
+						else{
+							found=nearby_halt.halt->find_route(ware) != UINT32_MAX_VALUE;
+						}
+
+						if(found){
 							const sint32 halt_capacity = nearby_halt.halt->get_capacity(2);
 							const sint32 halt_left = halt_capacity - (sint32)nearby_halt.halt->get_ware_summe(ware.get_desc());
 							sint32 halt_freespace_ratio = halt_capacity ? (halt_left << fabrik_t::precision_bits) / halt_capacity : 0;
@@ -2814,6 +3047,7 @@ void fabrik_t::distribute_contracts(uint32 delta_t){
 			}
 		}
 	}
+	contract_routes.clear();
 }
 
 class distribute_ware_t
@@ -4005,10 +4239,6 @@ void fabrik_t::info_prod(cbuffer_t& buf) const
  */
 void fabrik_t::recalc_nearby_halts()
 {
-	// Temporary list for accumulation of halts;
-	// avoid duplicating work on freight and passengers
-	vector_tpl<nearby_halt_t> nearby_halts;
-
 	// Clear out the old lists.
 	nearby_freight_halts.clear();
 	nearby_passenger_halts.clear();
@@ -4019,84 +4249,45 @@ void fabrik_t::recalc_nearby_halts()
 	get_tile_list(tile_list);
 
 #ifdef DEBUG
-	bool any_distribution_target = false; // just for debugging
-#endif
+	if(tile_list.empty())
+	{
+		dbg->fatal("fabrik_t::recalc_nearby_halts", "%s has no location on the map!", get_name() );
+	}
+#endif // DEBUG
 
-	FOR(vector_tpl<koord>, const k, tile_list)
+	// The halts reaching any tile of the factory, with the distance to the
+	// closest tile, since goods/passengers can ship from any part of a factory.
+	const uint16 cov_factories = welt->get_settings().get_station_coverage_factories();
+	vector_tpl<nearby_halt_t> nearby_halts;
+	halt_grid_t::get_halts_covering(tile_list, nearby_halts);
+
+	FOR(vector_tpl<nearby_halt_t>, const& nearby_halt, nearby_halts)
 	{
-		const planquadrat_t* plan = welt->access(k);
-		if(plan)
+		const halthandle_t halt = nearby_halt.halt;
+		if(halt->get_pax_enabled())
 		{
-#ifdef DEBUG
-			any_distribution_target=true;
-#endif
-			const uint8 haltlist_count = plan->get_haltlist_count();
-			if(haltlist_count)
+			nearby_passenger_halts.append(nearby_halt);
+		}
+		if(halt->get_mail_enabled())
+		{
+			nearby_mail_halts.append(nearby_halt);
+		}
+		if(halt->get_ware_enabled() && nearby_halt.distance <= cov_factories + 2) // We add 2 here as we do not count the first or last tile in the distance
+		{
+			// Halt is within freight coverage distance (shorter than regular) and handles freight...
+			if(get_desc()->get_placement() == factory_desc_t::Water && (halt->get_station_type() & haltestelle_t::dock) == 0)
 			{
-				const nearby_halt_t *haltlist = plan->get_haltlist();
-				for(int i = 0; i < haltlist_count; i++)
-				{
-					// We've found a halt.
-					const nearby_halt_t new_nearby_halt = haltlist[i];
-					// However, it might be a duplicate.
-					bool duplicate = false;
-					bool duplicate_freight = false;
-					for(uint32 j=0; j < nearby_halts.get_count(); j++)
-					{
-						if(new_nearby_halt.halt == nearby_halts[j].halt)
-						{
-							duplicate = true;
-							// Same halt handle.
-							// We always want the shorter of the two distances,
-							// since goods/passengers can ship from any part of a factory.
-							uint8 new_distance = min(nearby_halts[j].distance, new_nearby_halt.distance);
-							if(nearby_halts[j].distance <= welt->get_settings().get_station_coverage_factories() + 2)
-							{
-								duplicate_freight = true;
-							}
-							nearby_halts[j].distance = new_distance;
-						}
-					}
-					if(!duplicate)
-					{
-						nearby_halts.append(new_nearby_halt);
-						if(new_nearby_halt.halt->get_pax_enabled())
-						{
-							nearby_passenger_halts.append(new_nearby_halt);
-						}
-						if (new_nearby_halt.halt.is_bound() && new_nearby_halt.halt->get_mail_enabled())
-						{
-							nearby_mail_halts.append(new_nearby_halt);
-						}
-					}
-					if(!duplicate_freight)
-					{
-						if(new_nearby_halt.halt.is_bound() && new_nearby_halt.halt->get_ware_enabled() && new_nearby_halt.distance <= welt->get_settings().get_station_coverage_factories() + 2) // We add 2 here as we do not count the first or last tile in the distance
-						{
-							// Halt is within freight coverage distance (shorter than regular) and handles freight...
-							if(get_desc()->get_placement() == factory_desc_t::Water && (new_nearby_halt.halt->get_station_type() & haltestelle_t::dock) == 0)
-							{
-								// But this is a water factory and it's not a dock.
-								// So do nothing.
-							}
-							else
-							{
-								// Add to the list of freight halts.
-								nearby_freight_halts.append(new_nearby_halt);
-								new_nearby_halt.halt->add_factory(this);
-							}
-						}
-					}
-				}
+				// But this is a water factory and it's not a dock.
+				// So do nothing.
+			}
+			else
+			{
+				// Add to the list of freight halts.
+				nearby_freight_halts.append(nearby_halt);
+				halt->add_factory(this);
 			}
 		}
 	}
-#ifdef DEBUG
-	if(!any_distribution_target)
-	{
-		dbg->fatal("fabrik_t::recalc_nearby_halts", "%s has no location on the map!", get_name() );
-	}
-#endif // DEBUG
 }
 
 
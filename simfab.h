@@ -180,7 +180,7 @@ public:
 		assert(!using_contracts || link_aux.get_count()==links.get_count());
 	}
 
-	sint32 get_contract(uint32 idx){ return using_contracts ? link_aux[idx] : 0;}
+	sint32 get_contract(uint32 idx) const { return using_contracts ? link_aux[idx] : 0;}
 	void set_contract(uint32 idx, sint32 contract){
 		link_aux[idx]=contract;
 	}
@@ -755,6 +755,31 @@ private:
 
 	bool has_calculated_intransit_percentages;
 
+	/**
+	 * A route for the contract goods of this step from a nearby halt,
+	 * searched by prepare_contract_routes() in the order in which
+	 * distribute_contracts() needs them. As the routes are searched before
+	 * the factory produces, there may be some for links that get no goods.
+	 */
+	struct contract_route_t
+	{
+		uint32 product;
+		uint32 link;
+		halthandle_t halt;
+		bool found;
+		halthandle_t ziel;
+		halthandle_t zwischenziel;
+	};
+	vector_tpl<contract_route_t> contract_routes;
+
+	void prepare_contract_routes(uint32 delta_t);
+
+	/// The goods due this step under the contract @p link of output @p product
+	uint64 get_contract_step_amount(uint32 product, uint32 link, uint32 delta_t) const;
+
+	/// Whether contract goods for @p consumer_pos are carted there directly
+	bool can_cart_contract_to(koord consumer_pos) const;
+
 	void adjust_production_for_fields(bool is_from_saved_game = false);
 
 protected:
@@ -954,6 +979,27 @@ public:
 	bool out_of_stock_selective();
 
 	void step(uint32 delta_t);                  // factory muss auch arbeiten ("factory must also work")
+
+	/// The first part of step(): production and consumption
+	void step_production(uint32 delta_t);
+
+	/// The second part of step(): handing the goods to halts and consumers
+	void step_distribution(uint32 delta_t);
+
+	/**
+	 * Steps all factories of @p fabs, with the same result as calling step()
+	 * for each of them in order. With factory contracts, the routes from the
+	 * nearby halts are searched for all of them first, in parallel if possible.
+	 */
+	static void step_all(const vector_tpl<fabrik_t *> &fabs, uint32 delta_t);
+
+	/// Helper threads for step_all()
+	static void initialise_workers(uint32 count);
+	static void finalise_workers();
+
+	/// Called by the helper threads and step_all()
+	static void prepare_contract_routes_jobs(uint32 thread_number);
+
 	void step_contracts(uint32 delta_t);
 
 	void distribute_contracts(uint32 delta_t);
@@ -42,6 +42,7 @@
 #include "dataobj/loadsave.h"
 #include "dataobj/translator.h"
 #include "dataobj/environment.h"
+#include "dataobj/halt_grid.h"
 
 #include "obj/gebaeude.h"
 #include "obj/label.h"
@@ -60,6 +61,11 @@
 
 #include "descriptor/goods_desc.h"
 
+#ifdef MULTI_THREAD
+#include "utils/simthread.h"
+#include "utils/work_stealing.h"
+#endif
+
 karte_ptr_t haltestelle_t::welt;
 
 vector_tpl<halthandle_t> haltestelle_t::alle_haltestellen;
@@ -79,6 +85,109 @@ uint8 haltestelle_t::reconnect_counter = 0;
 // controls the halt iterator in step_all():
 static bool restart_halt_iterator = true;
 
+#ifdef MULTI_THREAD
+static vector_tpl<pthread_t> reroute_worker_threads;
+static simthread_barrier_t reroute_worker_barrier;
+static bool reroute_workers_terminating = false;
+static uint32 reroute_worker_count = 0;
+
+// the halts whose rerouting is worked out in parallel, and which thread does which
+static vector_tpl<halthandle_t> reroute_job_halts;
+static work_stealing_ranges_t reroute_jobs;
+
+void *reroute_worker_threaded(void* args)
+{
+	const uint32 thread_number = *(const uint32*)args;
+	delete (const uint32*)args;
+
+	while (true)
+	{
+		simthread_barrier_wait(&reroute_worker_barrier);
+		if (reroute_workers_terminating)
+		{
+			return NULL;
+		}
+		haltestelle_t::prepare_reroute_jobs(thread_number);
+		simthread_barrier_wait(&reroute_worker_barrier);
+	}
+
+	return NULL;
+}
+#endif
+
+
+void haltestelle_t::initialise_workers(uint32 count)
+{
+#ifdef MULTI_THREAD
+	if (count == 0 || reroute_worker_count > 0)
+	{
+		return;
+	}
+
+	reroute_workers_terminating = false;
+	simthread_barrier_init(&reroute_worker_barrier, NULL, count + 1);
+
+	pthread_attr_t thread_attributes;
+	pthread_attr_init(&thread_attributes);
+	pthread_attr_setdetachstate(&thread_attributes, PTHREAD_CREATE_JOINABLE);
+	for (uint32 i = 1; i <= count; i++)
+	{
+		pthread_t thread;
+		uint32* thread_number = new uint32;
+		*thread_number = i;
+		const int rc = pthread_create(&thread, &thread_attributes, &reroute_worker_threaded, (void*)thread_number);
+		if (rc)
+		{
+			dbg->fatal("void haltestelle_t::initialise_workers()", "Failed to create rerouting thread, error %d. See here for a translation of the error numbers: http://epydoc.sourceforge.net/stdlib/errno-module.html", rc);
+		}
+		reroute_worker_threads.append(thread);
+	}
+	pthread_attr_destroy(&thread_attributes);
+
+	reroute_worker_count = count;
+#else
+	(void)count;
+#endif
+}
+
+
+void haltestelle_t::finalise_workers()
+{
+#ifdef MULTI_THREAD
+	if (reroute_worker_count == 0)
+	{
+		return;
+	}
+
+	reroute_worker_count = 0;
+
+	reroute_workers_terminating = true;
+	simthread_barrier_wait(&reroute_worker_barrier);
+	FOR(vector_tpl<pthread_t>, const thread, reroute_worker_threads)
+	{
+		pthread_join(thread, NULL);
+	}
+	reroute_worker_threads.clear();
+	simthread_barrier_destroy(&reroute_worker_barrier);
+	reroute_workers_terminating = false;
+#endif
+}
+
+
+void haltestelle_t::prepare_reroute_jobs(uint32 thread_number)
+{
+#ifdef MULTI_THREAD
+	uint32 i;
+	while (reroute_jobs.get_next(thread_number, i))
+	{
+		reroute_job_halts[i]->prepare_step_reroutes();
+	}
+#else
+	(void)thread_number;
+#endif
+}
+
+
 void haltestelle_t::step_all()
 {
 	const uint32 count = alle_haltestellen.get_count();
@@ -86,6 +195,8 @@ void haltestelle_t::step_all()
 	{
 		const uint32 loops = min(count, 256u);
 		static vector_tpl<halthandle_t>::iterator iter;
+		static vector_tpl<halthandle_t> halts_to_step;
+		halts_to_step.clear();
 		for (uint32 i = 0; i < loops; ++i)
 		{
 			if (restart_halt_iterator || iter == alle_haltestellen.end())
@@ -93,7 +204,38 @@ void haltestelle_t::step_all()
 				restart_halt_iterator = false;
 				iter = alle_haltestellen.begin();
 			}
-			(*iter++)->step();
+			halts_to_step.append(*iter++);
+		}
+
+#ifdef MULTI_THREAD
+		// Rerouting only reads the paths and other halts, so the rerouting of all
+		// these halts is worked out in parallel first. Anything that affects other
+		// halts, factories or the map is only done in step(), in the order of the halts,
+		// so the result does not depend on the number of threads.
+		reroute_job_halts.clear();
+		FOR(vector_tpl<halthandle_t>, const halt, halts_to_step)
+		{
+			if (!halt->categories_to_refresh_next_step.empty() && halt->prepared_reroutes.empty() && !reroute_job_halts.is_contained(halt))
+			{
+				reroute_job_halts.append(halt);
+			}
+		}
+		if (reroute_worker_count > 0 && reroute_job_halts.get_count() > 1)
+		{
+			reroute_jobs.init(reroute_job_halts.get_count(), reroute_worker_count + 1);
+			simthread_barrier_wait(&reroute_worker_barrier);
+			prepare_reroute_jobs(0);
+			simthread_barrier_wait(&reroute_worker_barrier);
+		}
+#endif
+
+		FOR(vector_tpl<halthandle_t>, const halt, halts_to_step)
+		{
+			// a halt may have been removed by an earlier one
+			if (halt.is_bound())
+			{
+				halt->step();
+			}
 		}
 	}
 }
@@ -391,6 +533,8 @@ haltestelle_t::haltestelle_t(loadsave_t* file)
 	const uint8 max_classes = max(goods_manager_t::passengers->get_number_of_classes(), goods_manager_t::mail->get_number_of_classes());
 
 	cargo = (vector_tpl<ware_t> **)calloc( max_categories, sizeof(vector_tpl<ware_t> *) );
+	cargo_index = (cargo_index_t **)calloc( max_categories, sizeof(cargo_index_t *) );
+	cargo_changes = (uint32 *)calloc( max_categories, sizeof(uint32) );
 
 	non_identical_schedules.set_count(max_categories * max_classes);
 	// CHECK: Do we need the below in light of the above? Does the above auto-initialise the values to zero?
@@ -468,6 +612,8 @@ haltestelle_t::haltestelle_t(koord k, player_t* player)
 	const uint8 max_classes = max(goods_manager_t::passengers->get_number_of_classes(), goods_manager_t::mail->get_number_of_classes());
 
 	cargo = (vector_tpl<ware_t> **)calloc( max_categories, sizeof(vector_tpl<ware_t> *) );
+	cargo_index = (cargo_index_t **)calloc( max_categories, sizeof(cargo_index_t *) );
+	cargo_changes = (uint32 *)calloc( max_categories, sizeof(uint32) );
 
 	non_identical_schedules.set_count(max_categories * max_classes);
 	// CHECK: Do we need the below in light of the above? Does the above auto-initialise the values to zero?
@@ -586,6 +732,7 @@ haltestelle_t::~haltestelle_t()
 		koord lr(0,0);
 		while(  !tiles.empty()  ) {
 			koord pos = tiles.remove_first().grund->get_pos().get_2d();
+			halt_grid_t::remove_tile(self, pos);
 			planquadrat_t *pl = welt->access_nocheck(pos);
 			assert(pl);
 			for( uint8 i=0;  i<pl->get_boden_count();  i++  ) {
@@ -647,8 +794,20 @@ haltestelle_t::~haltestelle_t()
 			delete cargo[i];
 			cargo[i] = NULL;
 		}
+		invalidate_cargo_index(i);
 	}
 	free(cargo);
+	free(cargo_index);
+	free(cargo_changes);
+
+	FOR(vector_tpl<reroute_t *>, const reroute, prepared_reroutes)
+	{
+		if (reroute)
+		{
+			delete reroute->warray;
+			delete reroute;
+		}
+	}
 
 #ifdef MULTI_THREAD
 	welt->await_path_explorer();
@@ -701,6 +860,8 @@ void haltestelle_t::rotate90( const sint16 y_size )
 					warray.remove_at(j);
 				}
 			}
+			cargo_changes[i]++;
+			invalidate_cargo_index(i);
 		}
 	}
 
@@ -1272,10 +1433,18 @@ void haltestelle_t::step()
 
 	PIXVAL old_status_color = status_color;
 
-	FOR(vector_tpl<uint8>, catg, categories_to_refresh_next_step)
+	for (uint32 i = 0; i < categories_to_refresh_next_step.get_count(); i++)
 	{
-		reroute_goods(catg);
+		if (i < prepared_reroutes.get_count())
+		{
+			apply_reroute(prepared_reroutes[i]);
+		}
+		else
+		{
+			reroute_goods(categories_to_refresh_next_step[i]);
+		}
 	}
+	prepared_reroutes.clear();
 	categories_to_refresh_next_step.clear();
 
 	check_transferring_cargoes();
@@ -1319,6 +1488,7 @@ void haltestelle_t::step()
 					// The goods/passengers leave.  We must record the lower "in transit" count on factories.
 					fabrik_t::update_transit(tmp, false);
 					tmp.menge = 0;
+					release_cargo(j, &tmp);
 
 					// No need to record waiting times if the goods are discarded because their destination
 					// does not exist.
@@ -1435,6 +1605,7 @@ void haltestelle_t::step()
 						// The goods/passengers leave.  We must record the lower "in transit" count on factories.
 						fabrik_t::update_transit(tmp, false);
 						tmp.menge = 0;
+						release_cargo(j, &tmp);
 
 						// Normally we record long waits below, but we just did, so don't do it twice.
 						continue;
@@ -1538,110 +1709,183 @@ void haltestelle_t::new_month()
  */
 uint32 haltestelle_t::reroute_goods(const uint8 catg)
 {
-	if(cargo[catg])
-	{
-		vector_tpl<ware_t> * warray = cargo[catg];
-		const uint32 packet_count = warray->get_count();
-		vector_tpl<ware_t> * new_warray = new vector_tpl<ware_t>(packet_count);
+	return apply_reroute(prepare_reroute(catg));
+}
 
-		// Hajo:
-		// Step 1: re-route goods now and then to adapt to changes in
-		// world layout, remove all goods which destination was removed from the map
-		// prissi;
-		// also the empty entries of the array are cleared
-		for(int j = packet_count - 1; j  >= 0; j--)
-		{
-			ware_t & ware = (*warray)[j];
 
-			if(ware.menge == 0)
+void haltestelle_t::prepare_step_reroutes()
+{
+	for (uint32 i = 0; i < categories_to_refresh_next_step.get_count(); i++)
+	{
+		const uint8 catg = categories_to_refresh_next_step[i];
+		for (uint32 j = 0; j < i; j++)
+		{
+			if (categories_to_refresh_next_step[j] == catg)
 			{
-				continue;
+				// Rerouting again must start from the result of the first time.
+				return;
 			}
+		}
+		prepared_reroutes.append(prepare_reroute(catg));
+	}
+}
 
-			// If we are within delivery distance of our target factory, go there.
-			if(fabrik_t* fab = fabrik_t::get_fab(ware.get_zielpos()))
-			{
-				// If there's no factory there, wait.
-				if ( fab_list.is_contained(fab) )	{
-					// If this factory is on our list of connected factories... we're there!
 
-					add_to_waiting_list(ware, calc_ready_time(ware, true));
-					continue;
-				}
-			}
+haltestelle_t::reroute_t *haltestelle_t::prepare_reroute(const uint8 catg) const
+{
+	const vector_tpl<ware_t> *const warray = cargo[catg];
+	if(warray == NULL)
+	{
+		return NULL;
+	}
+
+	const uint32 packet_count = warray->get_count();
+	reroute_t *const reroute = new reroute_t();
+	reroute->catg = catg;
+	reroute->source = warray;
+	reroute->packet_count = packet_count;
+	reroute->changes = cargo_changes[catg];
+	reroute->warray = new vector_tpl<ware_t>(packet_count);
+
+	// Hajo:
+	// Step 1: re-route goods now and then to adapt to changes in
+	// world layout, remove all goods which destination was removed from the map
+	// prissi;
+	// also the empty entries of the array are cleared
+	for(int j = packet_count - 1; j  >= 0; j--)
+	{
+		reroute_t::leaving_t leaving;
+		leaving.ware = (*warray)[j];
+		ware_t &ware = leaving.ware;
 
-			// check if this good can still reach its destination
+		if(ware.menge == 0)
+		{
+			continue;
+		}
 
-			if(find_route(ware) == UINT32_MAX_VALUE)
-			{
-				// remove invalid destinations
+		// If we are within delivery distance of our target factory, go there.
+		if(fabrik_t* fab = fabrik_t::get_fab(ware.get_zielpos()))
+		{
+			// If there's no factory there, wait.
+			if ( fab_list.is_contained(fab) )	{
+				// If this factory is on our list of connected factories... we're there!
+				leaving.walking = false;
+				reroute->leaving.append(leaving);
 				continue;
 			}
+		}
 
-			// If the passengers have re-routed so that they now
-			// walk to the next transfer, go there immediately.
-			if(ware.is_passenger()
-			   && is_within_walking_distance_of(ware.get_zwischenziel())
-			   && !get_preferred_convoy(ware.get_zwischenziel(), 0, ware.get_class()).is_bound()
-			   && !get_preferred_line(ware.get_zwischenziel(), 0, ware.get_class()).is_bound())
-			{
-				pedestrian_t::generate_pedestrians_at(get_basis_pos3d(), ware.menge, 12000);
-				ware.get_zwischenziel()->liefere_an(ware, 1); // start counting walking steps at 1 again
-				continue;
-			}
+		// check if this good can still reach its destination
+
+		if(find_route(ware) == UINT32_MAX_VALUE)
+		{
+			// remove invalid destinations
+			continue;
+		}
+
+		// If the passengers have re-routed so that they now
+		// walk to the next transfer, go there immediately.
+		if(ware.is_passenger()
+		   && is_within_walking_distance_of(ware.get_zwischenziel())
+		   && !get_preferred_convoy(ware.get_zwischenziel(), 0, ware.get_class()).is_bound()
+		   && !get_preferred_line(ware.get_zwischenziel(), 0, ware.get_class()).is_bound())
+		{
+			leaving.walking = true;
+			reroute->leaving.append(leaving);
+			continue;
+		}
+
+		// add to new array
+		reroute->warray->append( ware );
+	}
+
+	return reroute;
+}
+
+
+uint32 haltestelle_t::apply_reroute(reroute_t *reroute)
+{
+	if(reroute == NULL)
+	{
+		return 0;
+	}
 
-			// add to new array
-			new_warray->append( ware );
+	const uint8 catg = reroute->catg;
+	vector_tpl<ware_t> * warray = cargo[catg];
+	if(warray != reroute->source  ||  cargo_changes[catg] != reroute->changes)
+	{
+		// The goods changed since the rerouting was worked out.
+		delete reroute->warray;
+		delete reroute;
+		reroute = prepare_reroute(catg);
+		if(reroute == NULL)
+		{
+			return 0;
 		}
+	}
 
-		// delete, if nothing connects here
-		if (new_warray->empty())
+	FOR(vector_tpl<reroute_t::leaving_t>, const& leaving, reroute->leaving)
+	{
+		const ware_t &ware = leaving.ware;
+		if(leaving.walking)
 		{
-			uint32 iterations = goods_manager_t::get_classes_catg_index(catg);
+			pedestrian_t::generate_pedestrians_at(get_basis_pos3d(), ware.menge, 12000);
+			ware.get_zwischenziel()->liefere_an(ware, 1); // start counting walking steps at 1 again
+		}
+		else
+		{
+			add_to_waiting_list(ware, calc_ready_time(ware, true));
+		}
+	}
+
+	const uint32 packet_count = reroute->packet_count;
+	vector_tpl<ware_t> * new_warray = reroute->warray;
+	delete reroute;
+
+	// delete, if nothing connects here
+	if (new_warray->empty())
+	{
+		uint32 iterations = goods_manager_t::get_classes_catg_index(catg);
 
-			for (uint32 n = 0; n < iterations; n++)
+		for (uint32 n = 0; n < iterations; n++)
+		{
+			if (get_connexions(catg, n)->empty())
 			{
-				if (get_connexions(catg, n)->empty())
-				{
-					// no connections from here => delete
-					delete new_warray;
-					new_warray = NULL;
-					ware_t ware;
+				// no connections from here => delete
+				delete new_warray;
+				new_warray = NULL;
+				ware_t ware;
 
-					for (uint32 i = 0; i < packet_count; i++)
+				for (uint32 i = 0; i < packet_count; i++)
+				{
+					ware = warray->get_element(i);
+					if (ware.is_freight())
 					{
-						ware = warray->get_element(i);
-						if (ware.is_freight())
+						const grund_t* gr = welt->lookup_kartenboden(ware.get_zielpos());
+						if (gr)
 						{
-							const grund_t* gr = welt->lookup_kartenboden(ware.get_zielpos());
-							if (gr)
+							const gebaeude_t* building = gr->get_building();
+							const fabrik_t* fab = building ? building->get_fabrik() : NULL;
+							if (fab)
 							{
-								const gebaeude_t* building = gr->get_building();
-								const fabrik_t* fab = building ? building->get_fabrik() : NULL;
-								if (fab)
-								{
-									fab->update_transit(ware, false);
-								}
+								fab->update_transit(ware, false);
 							}
 						}
 					}
 				}
 			}
 		}
+	}
 
-		// replace the array
-		delete cargo[catg];
-		cargo[catg] = new_warray;
+	// replace the array
+	delete cargo[catg];
+	cargo[catg] = new_warray;
+	invalidate_cargo_index(catg);
 
-		// likely the display must be updated after this
-		resort_freight_info = true;
+	// likely the display must be updated after this
+	resort_freight_info = true;
 
-		return packet_count;
-	}
-	else
-	{
-		return 0;
-	}
+	return packet_count;
 }
 
 void haltestelle_t::add_factory(fabrik_t* fab)
@@ -2039,7 +2283,8 @@ void haltestelle_t::refresh_routing(const schedule_t *const sched, const minivec
 
 		for (uint8 i = 0; i < catg_count; i++)
 		{
-			path_explorer_t::refresh_category(categories[i]);
+			// schedule changes only affect some connexions, so the paths can be repaired incrementally where possible
+			path_explorer_t::refresh_category(categories[i], true);
 		}
 
 		if ((passenger_classes != NULL) && categories.is_contained(goods_manager_t::INDEX_PAS))
@@ -2047,7 +2292,7 @@ void haltestelle_t::refresh_routing(const schedule_t *const sched, const minivec
 			// These minivecs should only have anything in them if their respective categories have not been refreshed entirely.
 			FOR(minivec_tpl<uint8>, const & g_class, *passenger_classes)
 			{
-				path_explorer_t::refresh_class_category(goods_manager_t::INDEX_PAS, g_class);
+				path_explorer_t::refresh_class_category(goods_manager_t::INDEX_PAS, g_class, true);
 			}
 		}
 
@@ -2056,7 +2301,7 @@ void haltestelle_t::refresh_routing(const schedule_t *const sched, const minivec
 			// These minivecs should only have anything in them if their respective categories have not been refreshed entirely.
 			FOR(minivec_tpl<uint8>, const & g_class, *mail_classes)
 			{
-				path_explorer_t::refresh_class_category(goods_manager_t::INDEX_MAIL, g_class);
+				path_explorer_t::refresh_class_category(goods_manager_t::INDEX_MAIL, g_class, true);
 			}
 		}
 	}
@@ -2400,11 +2645,13 @@ bool haltestelle_t::recall_ware( ware_t& w, uint32 menge )
 				// not all can be loaded
 				tmp.menge -= menge;
 				w.menge = menge;
+				cargo_changes[w.get_desc()->get_catg_index()]++;
 			}
 			else {
 				// leave an empty entry => joining will more often work
 				w.menge = tmp.menge;
 				tmp.menge = 0;
+				release_cargo(w.get_desc()->get_catg_index(), &tmp);
 			}
 			assert( (!w.is_passenger() && !w.is_mail()) );
 			book(w.menge*w.get_desc()->get_weight_per_unit()/10, HALT_GOODS_HANDLING_VOLUME);
@@ -2426,35 +2673,50 @@ bool haltestelle_t::fetch_goods(slist_tpl<ware_t> &load, const goods_desc_t *goo
 	vector_tpl<ware_t> *warray = cargo[catg_index];
 	if(warray && warray->get_count() > 0)
 	{
-		binary_heap_tpl<ware_t*> goods_to_check;
-		for(uint32 i = 0;  i < warray->get_count();  )
+		cargo_index_t *const catg_cargo_index = get_cargo_index(catg_index);
+		halthandle_t cached_halts[256];
+
+		// Only packets whose next transfer or destination is a stop of this
+		// schedule can board, so look only at those.
+		vector_tpl<uint32> positions;
+		vector_tpl<uint32> lower_class_positions;
+		vector_tpl<halthandle_t> schedule_halts(schedule->get_count());
+		const uint8 number_of_classes = max(goods_manager_t::get_classes_catg_index(catg_index), (uint8)(g_class + 1));
+		for(uint8 i = 0; i < schedule->get_count(); i++)
 		{
-			// Load first the goods/passengers/mail that have been waiting the longest.
-			// Do this by adding them all to a binary heap sorted by arrival time.
-			ware_t* const ware = &(*warray)[i];
-			if(ware->menge > 0)
+			const halthandle_t schedule_halt = haltestelle_t::get_halt(schedule->entries[i].pos, player);
+			cached_halts[i] = schedule_halt;
+			if(!schedule_halt.is_bound() || schedule_halt == self || !schedule_halt->is_enabled(catg_index) || !schedule_halts.append_unique(schedule_halt))
 			{
-				i++;
-				if (ware->get_class() >= g_class)
-				{
-					// We know at this stage that we cannot load passengers of a *lower* class into higher class accommodation,
-					// but we cannot yet know whether or not to load passengers of a higher class into lower class accommodation.
-					// Note that this method is called for each class of accommodation in each vehicle in each convoy.
-					goods_to_check.insert(ware);
-				}
-				else
-				{
-					other_classes_available = true;
-				}
+				continue;
 			}
-			else
+			for(uint8 c = 0; c < number_of_classes; c++)
 			{
-				// There is no need any longer to have empty ware packets hanging around.
-				warray->remove_at(i, false);
+				// We know at this stage that we cannot load passengers of a *lower* class into higher class accommodation,
+				// but we cannot yet know whether or not to load passengers of a higher class into lower class accommodation.
+				// Note that this method is called for each class of accommodation in each vehicle in each convoy.
+				vector_tpl<uint32> &class_positions = c >= g_class ? positions : lower_class_positions;
+				collect_indexed_cargo(*warray, catg_cargo_index, false, cargo_index_key(schedule_halt, c), class_positions);
+				collect_indexed_cargo(*warray, catg_cargo_index, true, cargo_index_key(schedule_halt, c), class_positions);
 			}
 		}
+		if(!lower_class_positions.empty())
+		{
+			other_classes_available = true;
+		}
 
-		halthandle_t cached_halts[256];
+		// Load first the goods/passengers/mail that have been waiting the longest.
+		// Do this by adding them all to a binary heap sorted by arrival time,
+		// in the order in which they are stored.
+		std::sort(positions.begin(), positions.end());
+		binary_heap_tpl<ware_t*> goods_to_check;
+		for(uint32 i = 0; i < positions.get_count(); i++)
+		{
+			if(i == 0 || positions[i] != positions[i - 1])
+			{
+				goods_to_check.insert(&(*warray)[positions[i]]);
+			}
+		}
 
 
 		while(!goods_to_check.empty())
@@ -2682,6 +2944,8 @@ bool haltestelle_t::fetch_goods(slist_tpl<ware_t> &load, const goods_desc_t *goo
 						// The direct route is faster than the planned route:
 						// update the next transfer to reflect this.
 						next_to_load->set_zwischenziel(destination);
+						index_cargo(catg_cargo_index, *warray, (uint32)(next_to_load - warray->begin()), true);
+						cargo_changes[catg_index]++;
 					}
 
 					if (next_to_load->is_passenger() && next_to_load->g_class > 0 && cnv->get_classes_carried(goods_manager_t::INDEX_PAS)->get_count() > 1)
@@ -2754,11 +3018,13 @@ bool haltestelle_t::fetch_goods(slist_tpl<ware_t> &load, const goods_desc_t *goo
 						neu.menge = requested_amount;
 						next_to_load->menge -= requested_amount;
 						requested_amount = 0;
+						cargo_changes[catg_index]++;
 					}
 					else
 					{
 						requested_amount -= next_to_load->menge;
-						next_to_load->menge = 0; // leave an empty entry => will be deleted next time for performance
+						next_to_load->menge = 0; // leave an empty entry => will be reused or deleted later for performance
+						release_cargo(catg_index, next_to_load);
 					}
 					load.insert(neu);
 
@@ -3043,6 +3309,7 @@ bool haltestelle_t::vereinige_waren(const ware_t &ware) //"unite were" (Google)
 				}
 
 				tmp.menge += ware.menge;
+				cargo_changes[ware.get_desc()->get_catg_index()]++;
 				resort_freight_info = true;
 				return true;
 			}
@@ -3066,26 +3333,158 @@ void haltestelle_t::add_ware_to_halt(ware_t ware, bool from_saved)
 	ware.set_last_transfer(self);
 
 	// now we have to add the ware to the stop
-	vector_tpl<ware_t> * warray = cargo[ware.get_desc()->get_catg_index()];
+	const uint8 catg = ware.get_desc()->get_catg_index();
+	vector_tpl<ware_t> * warray = cargo[catg];
 	if(warray==NULL)
 	{
 		// this type was not stored here before ...
 		warray = new vector_tpl<ware_t>(4);
-		cargo[ware.get_desc()->get_catg_index()] = warray;
+		cargo[catg] = warray;
 	}
+	cargo_changes[catg]++;
 	resort_freight_info = true;
-	if(!from_saved)
+	if(from_saved)
 	{
-		// the ware will be put into the first entry with menge==0
-		FOR(vector_tpl<ware_t>, & i, *warray) {
-			if (i.menge == 0) {
-				i = ware;
-				return;
-			}
+		// the destinations are not known before finish_rd(), so do not index yet
+		invalidate_cargo_index(catg);
+		warray->append(ware);
+		return;
+	}
+
+	// the ware will be put into an emptied entry, if there is one
+	cargo_index_t *const index = get_cargo_index(catg);
+	while(!index->empty_slots.empty())
+	{
+		const uint32 pos = index->empty_slots.pop_back();
+		if(pos < warray->get_count() && (*warray)[pos].menge == 0)
+		{
+			(*warray)[pos] = ware;
+			index_cargo(index, *warray, pos);
+			return;
 		}
-		// here, if no free entries found
 	}
+	// here, if no free entries found
 	warray->append(ware);
+	index_cargo(index, *warray, warray->get_count() - 1);
+}
+
+
+haltestelle_t::cargo_index_t *haltestelle_t::get_cargo_index(uint8 catg)
+{
+	vector_tpl<ware_t> &warray = *cargo[catg];
+	cargo_index_t *index = cargo_index[catg];
+	if(index && index->entries <= 4 * warray.get_count() + 64)
+	{
+		return index;
+	}
+
+	// Too many stale positions (or no index at all): start again.
+	invalidate_cargo_index(catg);
+	index = new cargo_index_t();
+	cargo_index[catg] = index;
+
+	// There is no need any longer to have empty packets hanging around.
+	uint32 count = 0;
+	for(uint32 i = 0; i < warray.get_count(); i++)
+	{
+		if(warray[i].menge > 0)
+		{
+			if(count != i)
+			{
+				warray[count] = warray[i];
+			}
+			count++;
+		}
+	}
+	warray.set_count(count);
+
+	for(uint32 i = 0; i < count; i++)
+	{
+		index_cargo(index, warray, i);
+	}
+	return index;
+}
+
+
+void haltestelle_t::invalidate_cargo_index(uint8 catg)
+{
+	delete cargo_index[catg];
+	cargo_index[catg] = NULL;
+}
+
+
+void haltestelle_t::index_cargo(cargo_index_t *index, const vector_tpl<ware_t> &warray, uint32 pos, bool transfer_only)
+{
+	const ware_t &ware = warray[pos];
+	const uint32 transfer_key = cargo_index_key(ware.get_zwischenziel(), ware.get_class());
+	vector_tpl<uint32> *bucket = index->by_transfer.access(transfer_key);
+	if(bucket == NULL)
+	{
+		index->by_transfer.put(transfer_key, vector_tpl<uint32>());
+		bucket = index->by_transfer.access(transfer_key);
+	}
+	bucket->append(pos);
+	index->entries++;
+	if(transfer_only)
+	{
+		return;
+	}
+
+	const uint32 destination_key = cargo_index_key(ware.get_ziel(), ware.get_class());
+	bucket = index->by_destination.access(destination_key);
+	if(bucket == NULL)
+	{
+		index->by_destination.put(destination_key, vector_tpl<uint32>());
+		bucket = index->by_destination.access(destination_key);
+	}
+	bucket->append(pos);
+	index->entries++;
+}
+
+
+void haltestelle_t::release_cargo(uint8 catg, const ware_t *ware)
+{
+	cargo_changes[catg]++;
+	if(cargo_index[catg])
+	{
+		cargo_index[catg]->empty_slots.append((uint32)(ware - cargo[catg]->begin()));
+	}
+}
+
+
+void haltestelle_t::collect_indexed_cargo(const vector_tpl<ware_t> &warray, cargo_index_t *index, bool by_destination, uint32 key, vector_tpl<uint32> &positions)
+{
+	inthashtable_tpl<uint32, vector_tpl<uint32>, N_BAGS_MEDIUM> &table = by_destination ? index->by_destination : index->by_transfer;
+	vector_tpl<uint32> *bucket = table.access(key);
+	if(bucket == NULL)
+	{
+		return;
+	}
+
+	uint32 kept = 0;
+	for(uint32 i = 0; i < bucket->get_count(); i++)
+	{
+		const uint32 pos = (*bucket)[i];
+		if(pos < warray.get_count())
+		{
+			const ware_t &ware = warray[pos];
+			if(ware.menge > 0 && cargo_index_key(by_destination ? ware.get_ziel() : ware.get_zwischenziel(), ware.get_class()) == key)
+			{
+				(*bucket)[kept++] = pos;
+				positions.append(pos);
+			}
+		}
+	}
+
+	index->entries -= bucket->get_count() - kept;
+	if(kept == 0)
+	{
+		table.remove(key);
+	}
+	else
+	{
+		bucket->set_count(kept);
+	}
 }
 
 void haltestelle_t::add_to_waiting_list(ware_t ware, sint64 ready_time)
@@ -3716,6 +4115,7 @@ void haltestelle_t::transfer_goods(halthandle_t halt)
 			}
 			delete cargo[i];
 			cargo[i] = NULL;
+			invalidate_cargo_index(i);
 		}
 	}
 }
@@ -4783,6 +5183,8 @@ void haltestelle_t::finish_rd(bool need_recheck_for_walking_distance)
 					}
 				}
 			}
+			// the destinations are only known now
+			invalidate_cargo_index(i);
 		}
 	}
 
@@ -5343,6 +5745,7 @@ bool haltestelle_t::add_grund(grund_t *gr, bool relink_factories, bool recalc_ne
 	add_to_station_type( gr );
 	gr->set_halt( self );
 	tiles.append( gr );
+	halt_grid_t::add_tile(self, pos);
 
 	// add to hashtable
 	if (all_koords) {
@@ -5506,6 +5909,7 @@ bool haltestelle_t::rem_grund(grund_t *gr)
 
 	// now remove tile from list
 	tiles.erase(i);
+	halt_grid_t::remove_tile(self, gr->get_pos().get_2d());
 #ifdef MULTI_THREAD
 	world()->await_path_explorer();
 #endif
@@ -6236,28 +6640,46 @@ void haltestelle_t::remove_halt_within_walking_distance(halthandle_t halt)
 
 void haltestelle_t::check_nearby_halts()
 {
-	halts_within_walking_distance.clear();
+	vector_tpl<halthandle_t> old_halts;
+	swap(old_halts, halts_within_walking_distance);
+
+	// The passenger halts whose coverage includes one of our tiles
+	vector_tpl<koord> tile_list(tiles.get_count());
 	FOR(slist_tpl<tile_t>, const& iter, tiles)
 	{
-		planquadrat_t *plan = welt->access(iter.grund->get_pos().get_2d());
-		if(plan)
-		{
-			const nearby_halt_t *const halt_list = plan->get_haltlist();
+		tile_list.append(iter.grund->get_pos().get_2d());
+	}
+	vector_tpl<nearby_halt_t> nearby_halts;
+	halt_grid_t::get_halts_covering(tile_list, nearby_halts);
 
-			for (int h = plan->get_haltlist_count() - 1; h >= 0; h--)
+	bool changed = false;
+	FOR(vector_tpl<nearby_halt_t>, const& nearby, nearby_halts)
+	{
+		const halthandle_t halt = nearby.halt;
+		if (halt->is_enabled(goods_manager_t::passengers))
+		{
+			add_halt_within_walking_distance(halt);
+			halt->add_halt_within_walking_distance(self);
+			changed |= halt != self && !old_halts.is_contained(halt);
+		}
+	}
+	FOR(vector_tpl<halthandle_t>, const halt, old_halts)
+	{
+		if (!halts_within_walking_distance.is_contained(halt))
+		{
+			if (halt.is_bound())
 			{
-				halthandle_t halt = halt_list[h].halt;
-				if (halt->is_enabled(goods_manager_t::passengers))
-				{
-					add_halt_within_walking_distance(halt);
-					halt->add_halt_within_walking_distance(self);
-				}
+				halt->remove_halt_within_walking_distance(self);
 			}
+			changed = true;
 		}
 	}
 
-	// Must refresh here, but only passengers can walk, so only refresh passengers.
-	path_explorer_t::refresh_category(0);
+	if (changed)
+	{
+		// Must refresh here, but only passengers can walk, so only refresh passengers.
+		path_explorer_t::refresh_category(0);
+	}
 }
 
 bool haltestelle_t::is_within_walking_distance_of(halthandle_t halt) const
@@ -196,6 +196,46 @@ private:
 	 */
 	vector_tpl<uint8> categories_to_refresh_next_step;
 
+	/**
+	 * The rerouting of the goods of one category, worked out by
+	 * prepare_reroute() without changing anything, and carried out by
+	 * apply_reroute().
+	 */
+	struct reroute_t
+	{
+		struct leaving_t
+		{
+			ware_t ware;
+			/// walking to the next transfer, else arrived at a connected factory
+			bool walking;
+		};
+
+		uint8 catg;
+
+		/// The goods list this was worked out from, its length and its cargo_changes then
+		const vector_tpl<ware_t> *source;
+		uint32 packet_count;
+		uint32 changes;
+
+		/// The goods which stay here, with their new routes
+		vector_tpl<ware_t> *warray;
+
+		/// The goods which leave, in the order of the goods list
+		vector_tpl<leaving_t> leaving;
+	};
+
+	/**
+	 * Rerouting of the first categories_to_refresh_next_step, worked out by
+	 * step_all() in parallel before this halt steps.
+	 */
+	vector_tpl<reroute_t *> prepared_reroutes;
+
+	reroute_t *prepare_reroute(uint8 catg) const;
+	uint32 apply_reroute(reroute_t *reroute);
+
+	/// Work out the rerouting of the next step() (only reads other halts)
+	void prepare_step_reroutes();
+
 	/**
 	* This is the list of passengers/mail/goods that
 	* have arrived at this stop but are in the process
@@ -222,6 +262,16 @@ public:
 	 */
 	static void step_all();
 
+	/**
+	 * Helper threads to work out the rerouting of the halts stepped
+	 * in step_all() in parallel.
+	 */
+	static void initialise_workers(uint32 count);
+	static void finalise_workers();
+
+	/// Called by the helper threads and step_all()
+	static void prepare_reroute_jobs(uint32 thread_number);
+
 	/**
 	 * Resets reconnect_counter.
 	 * The next call to step_all() will start complete reconnecting.
@@ -393,6 +443,56 @@ private:
 	// Array with different categories that contains all waiting goods at this stop
 	vector_tpl<ware_t> **cargo;
 
+	/**
+	 * Where the packets of one category in cargo are, by their next transfer
+	 * and class and by their destination and class, so that loading a convoy
+	 * only looks at the packets bound for one of its stops.
+	 * The positions are not removed when a packet is emptied or rerouted;
+	 * such stale positions are skipped (and dropped) when the index is used.
+	 */
+	struct cargo_index_t
+	{
+		inthashtable_tpl<uint32, vector_tpl<uint32>, N_BAGS_MEDIUM> by_transfer;
+		inthashtable_tpl<uint32, vector_tpl<uint32>, N_BAGS_MEDIUM> by_destination;
+
+		/// Positions of emptied packets, to be reused first
+		vector_tpl<uint32> empty_slots;
+
+		/// Number of positions in both tables, including stale ones
+		uint32 entries;
+
+		cargo_index_t() : entries(0) {}
+	};
+
+	// Built on demand for each category in cargo; NULL when not built (yet)
+	cargo_index_t **cargo_index;
+
+	/**
+	 * Counts the packets added to, changed in or removed from each category
+	 * in cargo, so that a prepared rerouting can tell whether it is stale.
+	 */
+	uint32 *cargo_changes;
+
+	static uint32 cargo_index_key(halthandle_t halt, uint8 g_class) { return ((uint32)halt.get_id() << 8) | g_class; }
+
+	/// Returns the index of category @p catg, (re)building it if necessary.
+	cargo_index_t *get_cargo_index(uint8 catg);
+
+	/// Drops the index of category @p catg, after the packets were moved around.
+	void invalidate_cargo_index(uint8 catg);
+
+	/// Files the packet at @p pos of @p warray in @p index (only by its next transfer if @p transfer_only).
+	static void index_cargo(cargo_index_t *index, const vector_tpl<ware_t> &warray, uint32 pos, bool transfer_only = false);
+
+	/// Records that the packet @p ware of category @p catg was emptied.
+	void release_cargo(uint8 catg, const ware_t *ware);
+
+	/**
+	 * Appends the positions filed under @p key which still match it to
+	 * @p positions and drops the stale ones.
+	 */
+	static void collect_indexed_cargo(const vector_tpl<ware_t> &warray, cargo_index_t *index, bool by_destination, uint32 key, vector_tpl<uint32> &positions);
+
 	/**
 	 * Liste der angeschlossenen Fabriken
 	 */
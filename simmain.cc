@@ -13,6 +13,7 @@
 #include "simworld.h"
 #include "simware.h"
 #include "display/simview.h"
+#include "display/render_benchmark.h"
 #include "gui/simwin.h"
 #include "gui/gui_theme.h"
 #include "gui/messagebox.h"
@@ -473,6 +474,10 @@ void print_help()
 		" -objects DIR_NAME/  load the pakset in specified directory\n"
 		" -pause              starts game with paused after loading\n"
 		"                     a server will pause if there are no clients, even if this be not specified in simuconf.tab\n"
+		" -render_benchmark F renders the loaded game at the viewport positions in file F,\n"
+		"                     times the drawing and quits (use with -load)\n"
+		" -benchmark_frames N frames per position for -render_benchmark (default 100)\n"
+		" -benchmark_json F   writes the -render_benchmark results to F instead of stdout\n"
 		" -res N              starts in specified resolution: \n"
 		"                      1=640x480, 2=800x600, 3=1024x768, 4=1280x1024\n"
 		" -screensize WxH     set screensize to width W and height H\n"
@@ -1626,6 +1631,19 @@ int simu_main(int argc, char** argv)
 	}
 #endif
 
+	// render benchmark: draw the loaded game at the given positions and quit
+	int exit_code = EXIT_SUCCESS;
+	if(  const char *positions_filename = args.gimme_arg("-render_benchmark", 1)  ) {
+		const char *frames_str = args.gimme_arg("-benchmark_frames", 1);
+		const uint32 frames = frames_str ? max(1, atoi(frames_str)) : 100;
+
+		intr_disable();
+		if(  !render_benchmark(welt, view, positions_filename, frames, args.gimme_arg("-benchmark_json", 1))  ) {
+			exit_code = EXIT_FAILURE;
+		}
+		env_t::quit_simutrans = true;
+	}
+
 	welt->reset_timer();
 	if(  !env_t::networkmode  &&  !env_t::server  &&  new_world  ) {
 #ifdef display_in_main
@@ -1752,5 +1770,5 @@ int simu_main(int argc, char** argv)
 	freelist_t::free_all_nodes();
 #endif
 
-	return EXIT_SUCCESS;
+	return exit_code;
 }
@@ -4187,6 +4187,7 @@ private:
 	virtual ribi_t::ribi get_ribi(const grund_t* gr) const { return other->get_ribi(gr); }
 	virtual waytype_t get_waytype() const { return other->get_waytype(); }
 	virtual int get_cost(const grund_t *gr, const sint32 c, koord p) { return other->get_cost(gr,c,p); }
+	virtual uint32 get_min_cost() const { return other->get_min_cost(); }
 	virtual bool  is_target(const grund_t *gr,const grund_t *gr2) { return other-> is_target(gr,gr2); }
 };
 
@@ -10630,6 +10631,8 @@ bool tool_change_traffic_light_t::init( player_t *player )
 				else if(  ns == 3  ) {
 					rs->set_ticks_amber_ow( (uint8)ticks );
 				}
+				// the ticks of private way signs are the players allowed to pass
+				weg_t::invalidate_all_routes();
 				// update the window
 				if(  rs->get_desc()->is_traffic_light()  ) {
 					trafficlight_info_t* trafficlight_win = (trafficlight_info_t*)win_get_magic((ptrdiff_t)rs);
@@ -10949,6 +10952,7 @@ bool tool_access_t::init(player_t *)
 	}
 
 	setting_player->set_allow_access_to(id_receiving_player, allow_access);
+	weg_t::invalidate_all_routes();
 	if(allow_access == false)
 	{
 		// If access is withdrawn, the routing/scheduling must be updated to take account of the fact
@@ -35,7 +35,7 @@ extern "C" FILE * __cdecl __iob_func(void) { return _iob; }
 
 #define EX_VERSION_MAJOR	14
 #define EX_VERSION_MINOR	21
-#define EX_SAVE_MINOR		63
+#define EX_SAVE_MINOR		67
 
 // Do not forget to increment the save game versions in settings_stats.cc when changing this
 
@@ -4,6 +4,7 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <limits>
 #include <functional>
 
@@ -56,6 +57,7 @@
 #include "vehicle/vehicle.h"
 #include "vehicle/simroadtraffic.h"
 #include "vehicle/movingobj.h"
+#include "vehicle/road_user_flow.h"
 #include "boden/wege/schiene.h"
 
 #include "obj/zeiger.h"
@@ -89,6 +91,10 @@
 #include "dataobj/environment.h"
 #include "dataobj/powernet.h"
 #include "dataobj/marker.h"
+#include "dataobj/halt_grid.h"
+#include "dataobj/route_landmarks.h"
+#include "dataobj/route_cache.h"
+#include "dataobj/private_car_routes.h"
 
 #include "utils/cbuffer_t.h"
 #include "utils/simrandom.h"
@@ -125,9 +131,17 @@
 
 #include "pathes.h"
 
+#ifdef __linux__
+// for saving in the background
+#include <errno.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 
 #ifdef MULTI_THREAD
 #include "utils/simthread.h"
+#include "utils/work_stealing.h"
 
 static vector_tpl<pthread_t> private_car_route_threads;
 static vector_tpl<pthread_t> unreserve_route_threads;
@@ -165,8 +179,18 @@ thread_local uint32 karte_t::marker_index = UINT32_MAX_VALUE;
 
 vector_tpl<convoihandle_t> convoys_next_step;
 
+#ifdef MULTI_THREAD_CONVOYS
+// which thread steps which of convoys_next_step
+static work_stealing_ranges_t convoy_step_jobs;
+
+// when the convoy threads started and each of them ran out of work in the last step
+static std::chrono::steady_clock::time_point convoy_step_start_time;
+static vector_tpl<std::chrono::steady_clock::time_point> convoy_step_finish_times;
+#endif
+
 vector_tpl<pedestrian_t*> *karte_t::pedestrians_added_threaded;
 vector_tpl<private_car_t*> *karte_t::private_cars_added_threaded;
+vector_tpl<stadt_t*> karte_t::private_car_route_cities;
 #endif
 sint32 karte_t::cities_to_process = 0;
 #ifdef MULTI_THREAD
@@ -544,6 +568,7 @@ void karte_t::destroy()
 	sync.clear();
 	sync_eyecandy.clear();
 	sync_way_eyecandy.clear();
+	road_user_flow_t::clear();
 	old_progress += cached_size.x*cached_size.y;
 	ls.set_progress( old_progress );
 	DBG_MESSAGE("karte_t::destroy()", "sync list cleared");
@@ -623,6 +648,10 @@ void karte_t::destroy()
 
 	weg_t::clear_travel_time_updates();
 	weg_t::clear_list_of__ways();
+	route_landmarks_t::clear_all();
+	route_cache_t::clear();
+	private_car_routes_t::clear_all();
+	halt_grid_t::clear();
 	DBG_MESSAGE("karte_t::destroy()", "way list destroyed");
 
 	delete scenario;
@@ -630,6 +659,7 @@ void karte_t::destroy()
 
 	senke_t::new_world();
 	pumpe_t::new_world();
+	leitung_t::new_world();
 
 	bool empty_depot_list = depot_t::get_depot_list().empty();
 	assert( empty_depot_list );
@@ -854,6 +884,13 @@ void karte_t::create_rivers( sint16 number )
 void karte_t::remove_queued_city(stadt_t* city)
 {
 	cities_awaiting_private_car_route_check.remove(city);
+#ifdef MULTI_THREAD
+	if (private_car_route_cities.is_contained(city))
+	{
+		// Let the thread finish with this city first.
+		suspend_private_car_threads();
+	}
+#endif
 }
 
 void karte_t::add_queued_city(stadt_t* city)
@@ -1582,54 +1619,30 @@ void *check_road_connexions_threaded(void *args)
 	delete thread_number_ptr;
 
 	karte_t::marker_index = thread_number + world()->get_parallel_operations();
+	private_car_routes_t::set_thread_buffer(thread_number);
 
-	do
+	// Each pass matches one start_private_car_threads() and await_private_car_threads() of the main thread.
+	// Finding the routes of a city may take several passes (see route_t::find_route).
+	while (true)
 	{
+		simthread_barrier_wait(&karte_t::private_car_barrier);
 		if (world()->is_terminating_threads())
 		{
 			break;
 		}
-		int error = pthread_mutex_lock(&karte_t::private_car_route_mutex);
-		assert(error == 0);
-		(void)error;
 
-		if (karte_t::cities_to_process > 0 && karte_t::cities_to_process >= thread_number + 1 && route_t::suspend_private_car_routing == false && !world()->cities_awaiting_private_car_route_check.empty())
+		stadt_t* city = karte_t::private_car_route_cities[thread_number];
+		if (city)
 		{
-			stadt_t* city;
-			city = world()->cities_awaiting_private_car_route_check.remove_first();
-
-			int error = pthread_mutex_unlock(&karte_t::private_car_route_mutex);
-			assert(error == 0);
-			(void)error;
-
-			if (!city || world()->get_settings().get_assume_everywhere_connected_by_road())
+			if (!world()->get_settings().get_assume_everywhere_connected_by_road())
 			{
-				continue;
+				city->check_all_private_car_routes();
 			}
-
-			city->check_all_private_car_routes();
-
-			error = pthread_mutex_lock(&karte_t::private_car_route_mutex);
-			karte_t::cities_to_process--;
-			error = pthread_mutex_unlock(&karte_t::private_car_route_mutex);
-
-			simthread_barrier_wait(&karte_t::private_car_barrier);
+			karte_t::private_car_route_cities[thread_number] = NULL;
 		}
-		else
-		{
-			int error = pthread_mutex_unlock(&karte_t::private_car_route_mutex);
-			assert(error == 0);
-			(void)error;
 
-			if (!world()->is_terminating_threads() && route_t::suspend_private_car_routing)
-			{
-				simthread_barrier_wait(&karte_t::private_car_barrier);
-			}
-		}
-
-		// Having two barrier waits here is intentional.
 		simthread_barrier_wait(&karte_t::private_car_barrier);
-	} while (!world()->is_terminating_threads());
+	}
 
 	// New thread local nodes are created on the heap automatically when this is used,
 	// so this must be released explicitly when this thread is terminated.
@@ -1852,6 +1865,8 @@ void *step_convoys_threaded(void* args)
 			convoihandle_t cnv = world->convoi_array[i];
 			convoys_next_step.append(cnv);
 		}
+		convoy_step_jobs.init(convoys_next_step.get_count(), world->get_parallel_operations());
+		convoy_step_start_time = std::chrono::steady_clock::now();
 
 		simthread_barrier_wait(&step_convoys_barrier_internal);
 		simthread_barrier_wait(&step_convoys_barrier_internal); // The multiples of these is intentional: we must wait for the individual threads to finish before the clear() command is executed.
@@ -1879,8 +1894,10 @@ void* step_individual_convoy_threaded(void* args)
 			return NULL;
 		}
 
-		const uint32 convoys_next_step_count = convoys_next_step.get_count();
-		for (uint32 i = thread_number; i < convoys_next_step_count; i += karte_t::world->get_parallel_operations())
+		// The convoys only change their own state here, which they use in their next step()
+		// in the order of convoi_array, so it does not matter which thread steps which convoy.
+		uint32 i;
+		while (convoy_step_jobs.get_next(thread_number, i))
 		{
 			convoihandle_t cnv = convoys_next_step[i];
 			if (cnv.is_bound())
@@ -1888,6 +1905,7 @@ void* step_individual_convoy_threaded(void* args)
 				cnv->threaded_step();
 			}
 		}
+		convoy_step_finish_times[thread_number] = std::chrono::steady_clock::now();
 
 		simthread_barrier_wait(&step_convoys_barrier_internal);
 	}
@@ -1909,10 +1927,38 @@ void karte_t::await_convoy_threads()
 	{
 		simthread_barrier_wait(&step_convoys_barrier_external);
 		convoy_threads_working = false;
+		update_convoy_thread_times();
 	}
 #endif
 }
 
+#ifdef MULTI_THREAD_CONVOYS
+void karte_t::update_convoy_thread_times()
+{
+	const uint32 count = convoy_step_finish_times.get_count();
+	while (convoy_thread_busy_time.get_count() < count)
+	{
+		convoy_thread_busy_time.append(0);
+		convoy_thread_idle_time.append(0);
+	}
+
+	std::chrono::steady_clock::time_point last_finish = convoy_step_start_time;
+	FOR(vector_tpl<std::chrono::steady_clock::time_point>, const finish, convoy_step_finish_times)
+	{
+		last_finish = max(last_finish, finish);
+	}
+
+	// Averaged over about the last 16 steps
+	for (uint32 i = 0; i < count; i++)
+	{
+		const uint32 busy = (uint32)std::chrono::duration_cast<std::chrono::microseconds>(convoy_step_finish_times[i] - convoy_step_start_time).count();
+		const uint32 idle = (uint32)std::chrono::duration_cast<std::chrono::microseconds>(last_finish - convoy_step_finish_times[i]).count();
+		convoy_thread_busy_time[i] = convoy_thread_busy_time[i] - (convoy_thread_busy_time[i] >> 4) + (busy >> 4);
+		convoy_thread_idle_time[i] = convoy_thread_idle_time[i] - (convoy_thread_idle_time[i] >> 4) + (idle >> 4);
+	}
+}
+#endif
+
 #ifdef MULTI_THREAD
 
 void karte_t::start_private_car_threads(bool override_suspend)
@@ -1930,6 +1976,35 @@ void karte_t::await_private_car_threads(bool override_suspend)
 	{
 		simthread_barrier_wait(&private_car_barrier);
 		private_car_threads_working = false;
+
+		// The threads are halted at the same points on all clients, so this is deterministic.
+		private_car_routes_t::flush_thread_buffers();
+		cities_to_process = 0;
+		FOR(vector_tpl<stadt_t*>, const city, private_car_route_cities)
+		{
+			if (city)
+			{
+				cities_to_process++;
+			}
+		}
+	}
+}
+
+void karte_t::assign_private_car_route_cities()
+{
+	// Leave one core to the main thread.
+	const uint32 max_threads = (uint32)max(get_parallel_operations() - 1, 1);
+	cities_to_process = 0;
+	for (uint32 i = 0; i < private_car_route_cities.get_count(); i++)
+	{
+		if (!private_car_route_cities[i] && i < max_threads && !cities_awaiting_private_car_route_check.empty())
+		{
+			private_car_route_cities[i] = cities_awaiting_private_car_route_check.remove_first();
+		}
+		if (private_car_route_cities[i])
+		{
+			cities_to_process++;
+		}
 	}
 }
 
@@ -2057,13 +2132,20 @@ void* unreserve_route_threaded(void* args)
 }
 #endif
 
-void karte_t::await_all_threads()
+void karte_t::await_all_threads(bool finish_private_car_routes)
 {
 #ifdef MULTI_THREAD
 	// Call this when saving or doing disruptive stuff like map rotation.
 	await_convoy_threads();
 	await_path_explorer();
-	suspend_private_car_threads();
+	if (finish_private_car_routes)
+	{
+		suspend_private_car_threads();
+	}
+	else
+	{
+		await_private_car_threads();
+	}
 	await_passengers_and_mail_threads();
 #endif
 }
@@ -2096,6 +2178,16 @@ void karte_t::init_threads()
 	simthread_barrier_init(&step_passengers_and_mail_barrier, NULL, parallel_operations + 2);
 	simthread_barrier_init(&step_convoys_barrier_external, NULL, 2);
 	simthread_barrier_init(&step_convoys_barrier_internal, NULL, parallel_operations + 1);
+#ifdef MULTI_THREAD_CONVOYS
+	convoy_step_finish_times.clear();
+	convoy_step_finish_times.resize(parallel_operations);
+	for (sint32 i = 0; i < parallel_operations; i++)
+	{
+		convoy_step_finish_times.append(std::chrono::steady_clock::now());
+	}
+	convoy_thread_busy_time.clear();
+	convoy_thread_idle_time.clear();
+#endif
 	simthread_barrier_init(&path_explorer_barrier, NULL, 2);
 
 	// Initialise mutexes
@@ -2111,10 +2203,14 @@ void karte_t::init_threads()
 
 	pthread_t thread;
 
+	private_car_route_cities.clear();
+	private_car_routes_t::init_thread_buffers(one_private_car_thread ? 1 : max(parallel_operations, 1));
+
 	for (uint32 i = 0; i < parallel_operations + 1; i++)
 	{
 		if ((i < parallel_operations && !one_private_car_thread) || i < 1)
 		{
+			private_car_route_cities.append(NULL);
 			uint32* thread_number_checker = new uint32;
 			*thread_number_checker = i;
 			rc = pthread_create(&thread, &thread_attributes, &check_road_connexions_threaded, (void*)thread_number_checker);
@@ -2196,6 +2292,15 @@ void karte_t::init_threads()
 	path_explorer_working = false;
 #endif
 
+	// helper threads for exploring the paths of large transfer halts
+	path_explorer_t::initialise_workers(parallel_operations);
+
+	// helper threads for rerouting the goods at the halts
+	haltestelle_t::initialise_workers(parallel_operations);
+
+	// helper threads for the contract routes of the factories
+	fabrik_t::initialise_workers(parallel_operations);
+
 	threads_initialised = true;
 }
 
@@ -2214,6 +2319,8 @@ void karte_t::destroy_threads()
 #ifdef MULTI_THREAD_PASSENGER_GENERATION
 		await_passengers_and_mail_threads();
 #endif
+		// The private car threads must be between two passes when they see this.
+		await_private_car_threads(true);
 
 		terminating_threads = true;
 #ifdef MULTI_THREAD_CONVOYS
@@ -2223,7 +2330,6 @@ void karte_t::destroy_threads()
 #ifdef MULTI_THREAD_PASSENGER_GENERATION
 		simthread_barrier_wait(&step_passengers_and_mail_barrier);
 #endif
-		await_private_car_threads();
 		simthread_barrier_wait(&private_car_barrier);
 
 		simthread_barrier_wait(&unreserve_route_barrier);
@@ -2231,6 +2337,9 @@ void karte_t::destroy_threads()
 		simthread_barrier_wait(&path_explorer_barrier);
 		pthread_join(path_explorer_thread, 0);
 #endif
+		path_explorer_t::finalise_workers();
+		haltestelle_t::finalise_workers();
+		fabrik_t::finalise_workers();
 #ifdef MULTI_THREAD_CONVOYS
 		pthread_join(convoy_step_master_thread, 0);
 		clean_threads(&individual_convoy_step_threads);
@@ -2238,6 +2347,7 @@ void karte_t::destroy_threads()
 #endif
 		clean_threads(&private_car_route_threads);
 		private_car_route_threads.clear();
+		private_car_route_cities.clear();
 #ifdef MULTI_THREAD_PASSENGER_GENERATION
 		clean_threads(&step_passengers_and_mail_threads);
 		step_passengers_and_mail_threads.clear();
@@ -2913,18 +3023,18 @@ void karte_t::enlarge_map(settings_t const* sets, sint8 const* const h_field)
 
 	for (uint8 i = 0; i < goods_manager_t::passengers->get_number_of_classes(); i++)
 	{
-		FOR(weighted_vector_tpl<gebaeude_t*>, const target, commuter_targets[i])
+		FOR(indexed_weighted_vector_tpl<gebaeude_t*>, const target, commuter_targets[i])
 		{
 			target->set_building_tiles();
 		}
 
-		FOR(weighted_vector_tpl<gebaeude_t*>, const target, visitor_targets[i])
+		FOR(indexed_weighted_vector_tpl<gebaeude_t*>, const target, visitor_targets[i])
 		{
 			target->set_building_tiles();
 		}
 	}
 
-	FOR(weighted_vector_tpl<gebaeude_t*>, const target, mail_origins_and_targets)
+	FOR(indexed_weighted_vector_tpl<gebaeude_t*>, const target, mail_origins_and_targets)
 	{
 		target->set_building_tiles();
 	}
@@ -3132,8 +3242,8 @@ karte_t::karte_t() :
 	parallel_operations = -1;
 
 	const uint8 number_of_passenger_classes = goods_manager_t::passengers->get_number_of_classes();
-	commuter_targets = new weighted_vector_tpl<gebaeude_t*>[number_of_passenger_classes];
-	visitor_targets = new weighted_vector_tpl<gebaeude_t*>[number_of_passenger_classes];
+	commuter_targets = new indexed_weighted_vector_tpl<gebaeude_t*>[number_of_passenger_classes];
+	visitor_targets = new indexed_weighted_vector_tpl<gebaeude_t*>[number_of_passenger_classes];
 
 #ifdef MULTI_THREAD
 	passengers_and_mail_threads_working = false;
@@ -3812,6 +3922,14 @@ DBG_MESSAGE( "karte_t::rotate90()", "called" );
 	// Wait for any threaded work
 	await_all_threads();
 
+	// the road users kept as flows are kept by position
+	road_user_flow_t::release_all();
+
+	// so are the landmark distances of the route search; recalculated below
+	route_landmarks_t::clear_all();
+	// and the routes found by convoys
+	route_cache_t::clear();
+
 	// assume we can save this rotation
 	nosave_warning = nosave = false;
 
@@ -3831,6 +3949,12 @@ DBG_MESSAGE( "karte_t::rotate90()", "called" );
 		i->rotate90(cached_size.y);
 	}
 
+	// The routes are stored by position and direction: find them again.
+	private_car_routes_t::clear_all();
+	FOR(weighted_vector_tpl<stadt_t*>, const i, stadt) {
+		cities_awaiting_private_car_route_check.append_unique(i);
+	}
+
 	//rotate plans in parallel posix thread ...
 	rotate90_new_plan = new planquadrat_t[cached_grid_size.y * cached_grid_size.x];
 	rotate90_new_water = new sint8[cached_grid_size.y * cached_grid_size.x];
@@ -3878,6 +4002,7 @@ DBG_MESSAGE( "karte_t::rotate90()", "called" );
 	FOR(vector_tpl<halthandle_t>, const s, haltestelle_t::get_alle_haltestellen()) {
 		s->rotate90(cached_size.x);
 	}
+	halt_grid_t::rebuild();
 
 #ifdef MULTI_THREAD
 	const sint32 po = get_parallel_operations() + 2;
@@ -3909,20 +4034,20 @@ DBG_MESSAGE( "karte_t::rotate90()", "called" );
 
 	for (uint8 i = 0; i < goods_manager_t::passengers->get_number_of_classes(); i++)
 	{
-		FOR(weighted_vector_tpl<gebaeude_t*>, const building, visitor_targets[i])
+		FOR(indexed_weighted_vector_tpl<gebaeude_t*>, const building, visitor_targets[i])
 		{
 			building->set_building_tiles();
 		}
-		FOR(weighted_vector_tpl<gebaeude_t*>, const building, commuter_targets[i])
+		FOR(indexed_weighted_vector_tpl<gebaeude_t*>, const building, commuter_targets[i])
 		{
 			building->set_building_tiles();
 		}
 	}
-	FOR(weighted_vector_tpl<gebaeude_t*>, const building, passenger_origins)
+	FOR(indexed_weighted_vector_tpl<gebaeude_t*>, const building, passenger_origins)
 	{
 		building->set_building_tiles();
 	}
-	FOR(weighted_vector_tpl<gebaeude_t*>, const building, mail_origins_and_targets)
+	FOR(indexed_weighted_vector_tpl<gebaeude_t*>, const building, mail_origins_and_targets)
 	{
 		building->set_building_tiles();
 	}
@@ -3973,6 +4098,8 @@ DBG_MESSAGE( "karte_t::rotate90()", "called" );
 
 	get_scenario()->rotate90( cached_size.x );
 
+	route_landmarks_t::update_all(this);
+
 	// finally recalculate schedules for goods in transit ...
 	// Modified by : Knightly
 	path_explorer_t::refresh_all_categories(false);
@@ -4193,14 +4320,35 @@ void karte_t::sync_list_t::remove(sync_steppable *obj)
 		}
 		assert(false);
 	}
+	else if(  !idle_objects.empty()  &&  idle_objects.is_contained(obj)  ) {
+		idle_wheel.remove(obj, idle_objects.remove(obj).due);
+	}
 	else {
 		list.remove(obj);
 	}
 }
 
+void karte_t::sync_list_t::wake(sync_steppable *obj)
+{
+	if(  !idle_objects.empty()  &&  idle_objects.is_contained(obj)  ) {
+		idle_wheel.remove(obj, idle_objects.remove(obj).due);
+		list.append(obj);
+	}
+}
+
+uint32 karte_t::sync_list_t::get_idle_time(const sync_steppable *obj) const
+{
+	if(  idle_objects.empty()  ||  !idle_objects.is_contained(obj)  ) {
+		return 0;
+	}
+	return (uint32)(idle_wheel.get_time() - idle_objects.get(obj).since);
+}
+
 void karte_t::sync_list_t::clear()
 {
 	list.clear();
+	idle_wheel.clear();
+	idle_objects.clear();
 	currently_deleting = NULL;
 	sync_step_running = false;
 }
@@ -4210,10 +4358,41 @@ void karte_t::sync_list_t::sync_step(uint32 delta_t)
 	sync_step_running = true;
 	currently_deleting = NULL;
 
+	// the idle objects due again catch up on the time they were left out and join the others
+	const uint64 now = idle_wheel.get_time() + delta_t;
+	due_objects.clear();
+	idle_wheel.advance(now, due_objects);
+	FOR(vector_tpl<sync_steppable *>, const ss, due_objects) {
+		const uint32 idle_time = (uint32)(now - delta_t - idle_objects.remove(ss).since);
+		switch(idle_time > 0 ? ss->sync_step(idle_time) : SYNC_OK) {
+			case SYNC_OK:
+				list.append(ss);
+				break;
+			case SYNC_DELETE:
+				currently_deleting = ss;
+				delete ss;
+				currently_deleting = NULL;
+				break;
+			case SYNC_REMOVE:
+				break;
+		}
+	}
+
 	for(uint32 i=0; i<list.get_count();i++) {
 		sync_steppable *ss = list[i];
 		switch(ss->sync_step(delta_t)) {
 			case SYNC_OK:
+				if(  const uint32 idle_ticks = ss->get_sync_idle_ticks()  ) {
+					// nothing to do for a while: leave it out until then
+					idle_t idle;
+					idle.since = now;
+					idle.due = now + idle_ticks;
+					idle_objects.set(ss, idle);
+					idle_wheel.insert(ss, idle.due);
+					list[i] = list.back();
+					list.pop_back();
+					i--;
+				}
 				break;
 			case SYNC_DELETE:
 				currently_deleting = ss;
@@ -4483,6 +4662,10 @@ inline sint32 get_population(stadt_t const* const c)
 }
 
 
+/// the autosave due at the new month, written by karte_t::step when no other thread is working
+static std::string pending_autosave_name;
+
+
 void karte_t::new_month()
 {
 	update_history();
@@ -4719,11 +4902,12 @@ void karte_t::new_month()
 	tool_t::update_toolbars();
 
 
-	// no autosave in networkmode or when the new world dialogue is shown
-	if( !env_t::networkmode && env_t::autosave>0 && last_month%env_t::autosave==0 && !win_get_magic(magic_welt_gui_t) ) {
+	// no autosave in networkmode or when the new world dialogue is shown;
+	// only a server saving in the background does not hold up its clients
+	if( (!env_t::networkmode || (env_t::server && can_save_in_background())) && env_t::autosave>0 && last_month%env_t::autosave==0 && !win_get_magic(magic_welt_gui_t) ) {
 		char buf[128];
 		sprintf( buf, "save/autosave%02i.sve", last_month+1 );
-		save( buf, true, env_t::savegame_version_str, env_t::savegame_ex_version_str, env_t::savegame_ex_revision_str, true );
+		pending_autosave_name = buf;
 	}
 
 	recalc_passenger_destination_weights();
@@ -4927,8 +5111,6 @@ void karte_t::pause_step()
 {
 	// Check the private car routes. In multi-threaded mode, this can be running in the background whilst a number of other steps are processed.
 	// This is computationally intensive, but intermittently. The computational intensity increases exponentially with the size of the map.
-	const sint32 parallel_operations = get_parallel_operations();
-
 	if (!private_car_route_check_complete && cities_awaiting_private_car_route_check.empty())
 	{
 		refresh_private_car_routes();
@@ -4940,15 +5122,10 @@ void karte_t::pause_step()
 	{
 #ifdef MULTI_THREAD
 		// This cannot be started at the end of the step, as we will not know at that point whether we need to call this at all.
-		// There can be many mutex clashes with this; however, processing only one city at a time can make it take an unfeasible amount of time to refresh all routes.
-		//cities_to_process = stadt.get_count() > 64 ? 1 : min(cities_awaiting_private_car_route_check.get_count(), parallel_operations - 1);
-		//cities_to_process = 1;
-		if (cities_to_process <= 0 || cities_awaiting_private_car_route_check.get_count() > parallel_operations - 1)
-		{
-			cities_to_process = min(cities_awaiting_private_car_route_check.get_count(), parallel_operations - 1);
-		}
+		assign_private_car_route_cities();
 		start_private_car_threads();
 #else
+		const sint32 parallel_operations = get_parallel_operations();
 		const sint32 cities_to_process = env_t::networkmode ? 1 : min(cities_awaiting_private_car_route_check.get_count(), parallel_operations - 1);
 		for (sint32 j = 0; j < cities_to_process; j++)
 		{
@@ -5073,8 +5250,6 @@ void karte_t::step()
 	const bool check_city_routes = true;
 	if (check_city_routes)
 	{
-		const sint32 parallel_operations = get_parallel_operations();
-
 		if (cities_awaiting_private_car_route_check.empty() && cities_to_process <= 0)
 		{
 			refresh_private_car_routes();
@@ -5083,20 +5258,16 @@ void karte_t::step()
 
 #ifdef MULTI_THREAD
 		// This cannot be started at the end of the step, as we will not know at that point whether we need to call this at all.
-		// There can be many mutex clashes with this; however, processing only one city at a time can make it take an unfeasible amount of time to refresh all routes.
 
-		// Also, processing multiple cities when mutli-threaded is not network safe. The reasons for this are unclear, but this remains so even after
-		// the implementation of rwlocks for the private car routing data in January 2021. It is suspected that hte route finding algorithm is not
-		// deterministic for any given starting point, but investigations have so far not revealed whether this is the real problem or how or in what way(s) that
-		// this is not deterministic.
-
-		// For this reason, multi-threading is disabled when using network mode with clients connected until the problem can be solved.
-		if (cities_to_process <= 0 || cities_awaiting_private_car_route_check.get_count() > parallel_operations - 1)
-		{
-			cities_to_process = env_t::networkmode ? min(1, cities_awaiting_private_car_route_check.get_count()) : min(cities_awaiting_private_car_route_check.get_count(), parallel_operations - 1);
-		}
+		// The cities are handed to the threads in the order in which they were queued, the routes found are added to the table
+		// in the order of the threads, and the threads only run until they are awaited below, when the ways do not change.
+		// The threads halt after a number of tiles which does not depend on the machine (see route_t::find_route), and they are
+		// only made to finish their cities early where all clients do so (see await_all_threads), so the results are the same
+		// on all clients of a network game.
+		assign_private_car_route_cities();
 		start_private_car_threads();
 #else
+		const sint32 parallel_operations = get_parallel_operations();
 		const sint32 cities_to_process = min(cities_awaiting_private_car_route_check.get_count(), env_t::networkmode ? 1 : parallel_operations - 1);
 
 		for (sint32 j = 0; j < cities_to_process; j++)
@@ -5163,6 +5334,22 @@ void karte_t::step()
 	}
 #endif
 
+#ifdef MULTI_THREAD
+	// The private car routes must be found before the convoys and cities step, as these change the ways they depend on.
+	// This must also be before any code that in any way relies on the private car routes between cities, most especially
+	// the mail and passenger generation (step_passengers_and_mail(delta_t)).
+	if (check_city_routes)
+	{
+		await_private_car_threads();
+	}
+#endif
+
+	if(  (steps % route_landmarks_t::update_interval) == 0  ) {
+		// No routes are searched now, so the landmarks of changed way networks can be recalculated.
+		route_landmarks_t::update_all(this);
+		route_cache_t::expire();
+	}
+
 	rands[13] = get_random_seed();
 
 	// The more computationally intensive parts of this have been extracted and made multi-threaded.
@@ -5201,14 +5388,6 @@ void karte_t::step()
 
 	INT_CHECK("karte_t::step 3b");
 
-#ifdef MULTI_THREAD
-	// The placement of this method call must be before any code that in any way relies on the private car routes between cities, most especially the mail and passenger generation (step_passengers_and_mail(delta_t)).
-	if (check_city_routes)
-	{
-		await_private_car_threads();
-	}
-#endif
-
 	weg_t::apply_travel_time_updates();
 
 	rands[16] = get_random_seed();
@@ -5304,6 +5483,20 @@ void karte_t::step()
 	// This does nothing if the threading is disabled.
 	await_passengers_and_mail_threads();
 
+	if(  !pending_autosave_name.empty()  ) {
+		// No other thread is working until the path explorer and the convoys are started again below, on all
+		// clients of a network game: so the server can copy the game here without waiting for anything.
+		if(  !save_in_background( pending_autosave_name.c_str(), true, env_t::savegame_version_str, env_t::savegame_ex_version_str, env_t::savegame_ex_revision_str )  ) {
+			if(  env_t::networkmode  ) {
+				dbg->warning("karte_t::step()", "skipping autosave, cannot save in the background now");
+			}
+			else {
+				save( pending_autosave_name.c_str(), true, env_t::savegame_version_str, env_t::savegame_ex_version_str, env_t::savegame_ex_revision_str, true );
+			}
+		}
+		pending_autosave_name.clear();
+	}
+
 	rands[19] = get_random_seed();
 
 	for (uint32 i = 0; i < po; i++)
@@ -5370,12 +5563,14 @@ void karte_t::step()
 	}
 #endif
 #endif
+
+	// private cars and pedestrians far from the viewport
+	road_user_flow_t::step(delta_t);
+
 	INT_CHECK("karte_t::step 5");
 
 	DBG_DEBUG4("karte_t::step", "step factories");
-	FOR(vector_tpl<fabrik_t*>, const f, fab_list) {
-		f->step(delta_t);
-	}
+	fabrik_t::step_all(fab_list, delta_t);
 	rands[20] = get_random_seed();
 
 	finance_history_year[0][WORLD_FACTORIES] = finance_history_month[0][WORLD_FACTORIES] = fab_list.get_count();
@@ -5383,6 +5578,7 @@ void karte_t::step()
 	// step powerlines - required order: pumpe, senke, then powernet
 	// This is not computationally intensive.
 	DBG_DEBUG4("karte_t::step", "step poweline stuff");
+	leitung_t::split_nets();
 	pumpe_t::step_all( delta_t );
 	senke_t::step_all( delta_t );
 	powernet_t::step_all( delta_t );
@@ -5433,6 +5629,9 @@ void karte_t::step()
 	start_path_explorer();
 #endif
 
+	// The convoy threads run while the steps are advanced, so they use this stamp for the age of the routes they find.
+	route_cache_t::set_step(steps);
+
 #ifdef MULTI_THREAD_CONVOYS
 	// Start the convoys' route finding as soon as possible after the convoys have been stepped: this maximises efficiency and concurrency.
 	// Since it is mostly route finding in the multi-threaded convoy step, it is safe to have this concurrent with everything but the single-
@@ -5498,7 +5697,7 @@ void karte_t::refresh_private_car_routes() {
 #ifdef MULTI_THREAD
 	suspend_private_car_threads();
 #endif
-	weg_t::swap_private_car_routes_currently_reading_element();
+	private_car_routes_t::swap_tables();
 	clear_private_car_routes();
 	for(auto & city : stadt) {
 		cities_awaiting_private_car_route_check.insert(city);
@@ -5506,16 +5705,7 @@ void karte_t::refresh_private_car_routes() {
 }
 
 void karte_t::clear_private_car_routes() {
-	weg_t::private_car_route_map::route_map_lock();
-	for(auto & w : weg_t::get_alle_wege()) {
-		for(auto & l : w->private_car_routes[weg_t::get_private_car_routes_currently_writing_element()]) {
-			l.pre_reset();
-		}
-	}
-	weg_t::private_car_route_map::reset(weg_t::get_private_car_routes_currently_writing_element());
-
-	weg_t::private_car_route_map::route_map_unlock();
-
+	private_car_routes_t::clear_writing_table();
 }
 
 void karte_t::step_time_interval_signals()
@@ -7896,6 +8086,114 @@ DBG_MESSAGE("karte_t::save()", "saving game to '%s'", filename);
 }
 
 
+#ifdef __linux__
+/// the forked copy of the game which writes a save, if any
+static pid_t background_save_pid = -1;
+static std::string background_save_name;
+#endif
+
+/// true in the forked copy of the game which writes a save
+static bool in_background_save = false;
+
+
+bool karte_t::can_save_in_background()
+{
+#ifdef __linux__
+	return env_t::background_save;
+#else
+	return false;
+#endif
+}
+
+
+bool karte_t::save_in_background(const char *filename, bool autosave, const char *version_str, const char *ex_version_str, const char* ex_revision_str)
+{
+#ifdef __linux__
+	if(  !can_save_in_background()  ||  background_save_pid > 0  ) {
+		return false;
+	}
+	if(  nosave_warning  ) {
+		// save() would rotate the map first, which needs the world threads the copy does not have
+		return false;
+	}
+
+#ifdef MULTI_THREAD
+	// Only this thread is copied, so the others must not be in the middle of changing anything.
+	// This only waits for them: the clients of a network game do not save, so nothing may be advanced.
+	await_all_threads(false);
+#endif
+	// otherwise anything waiting in the buffers would be written by both
+	fflush(NULL);
+
+	const pid_t pid = fork();
+	if(  pid < 0  ) {
+		dbg->warning("karte_t::save_in_background()", "cannot fork: %s", strerror(errno));
+		return false;
+	}
+
+	if(  pid == 0  ) {
+		// the copy: save without any windows and leave without cleaning up, since the game owns all of it
+		in_background_save = true;
+
+		std::string savename = filename;
+		savename[savename.length() - 1] = '_';
+
+		const loadsave_t::mode_t mode = autosave ? loadsave_t::autosave_mode : loadsave_t::save_mode;
+		const int level = autosave ? loadsave_t::autosave_level : loadsave_t::save_level;
+
+		loadsave_t file;
+		bool ok = file.wr_open( savename.c_str(), mode, level, env_t::objfilename.c_str(), version_str, ex_version_str, ex_revision_str ) == loadsave_t::FILE_STATUS_OK;
+		if(  ok  ) {
+			save(&file, true);
+			ok = file.close() == NULL  &&  dr_rename(savename.c_str(), filename) == 0;
+		}
+		_exit( ok ? 0 : 1 );
+	}
+
+	background_save_pid = pid;
+	background_save_name = filename;
+	DBG_MESSAGE("karte_t::save_in_background()", "saving game to '%s' in process %d", filename, (int)pid);
+	return true;
+#else
+	(void)filename;
+	(void)autosave;
+	(void)version_str;
+	(void)ex_version_str;
+	(void)ex_revision_str;
+	return false;
+#endif
+}
+
+
+void karte_t::check_background_save(bool wait)
+{
+#ifdef __linux__
+	if(  background_save_pid <= 0  ) {
+		return;
+	}
+
+	int status = 0;
+	const pid_t ret = waitpid(background_save_pid, &status, wait ? 0 : WNOHANG);
+	if(  ret == 0  ) {
+		return; // still saving
+	}
+	background_save_pid = -1;
+
+	if(  ret < 0  ||  !WIFEXITED(status)  ||  WEXITSTATUS(status) != 0  ) {
+		dbg->error("karte_t::check_background_save()", "saving '%s' in the background failed", background_save_name.c_str());
+		if(  !env_t::server  ) {
+			create_win(new news_img("Kann Spielstand\nnicht speichern.\n"), w_info, magic_none);
+		}
+	}
+	else {
+		dbg->message("karte_t::check_background_save()", "saved '%s' in the background", background_save_name.c_str());
+	}
+#else
+	(void)wait;
+#endif
+}
+
+
 void karte_t::save(loadsave_t *file, bool silent)
 {
 	bool needs_redraw = false;
@@ -7906,8 +8204,15 @@ DBG_MESSAGE("karte_t::save(loadsave_t *file)", "start");
 		ls = new loadingscreen_t( translator::translate("Saving map ..."), get_size().y );
 	}
 #ifdef MULTI_THREAD
-	await_all_threads();
+	if(  !in_background_save  ) {
+		// the copy saving in the background has no threads, they were awaited before copying.
+		// Other clients of a network game do not save now, so the private car routes must not advance.
+		await_all_threads(false);
+	}
 #endif
+	// the road users kept as flows are saved as they were on the map
+	road_user_flow_t::release_all();
+
 	// rotate the map until it can be saved completely
 	for( int i=0;  i<4  &&  nosave_warning;  i++  ) {
 		rotate90();
@@ -8195,9 +8500,15 @@ DBG_MESSAGE("karte_t::save(loadsave_t *file)", "motd filename %s", env_t::server
 		}
 	}
 
-	if (file->get_extended_version() >= 15 || (file->get_extended_version() == 14 && file->get_extended_revision() >= 20))
+	if (file->is_version_ex_atleast(14, 67))
 	{
-		file->rdwr_long(weg_t::private_car_routes_currently_reading_element);
+		private_car_routes_t::rdwr(file);
+	}
+	else if (file->get_extended_version() >= 15 || (file->get_extended_version() == 14 && file->get_extended_revision() >= 20))
+	{
+		// The routes of older games are not loaded.
+		uint32 dummy = 0;
+		file->rdwr_long(dummy);
 	}
 
 	if (file->get_extended_version() >= 15 || ((file->get_extended_version() >= 14 && file->get_extended_revision() >= 8) && get_settings().get_save_path_explorer_data()))
@@ -8207,10 +8518,26 @@ DBG_MESSAGE("karte_t::save(loadsave_t *file)", "motd filename %s", env_t::server
 
 	if (file->get_extended_version() >= 15 || (file->get_extended_version() == 14 && file->get_extended_revision() >= 35))
 	{
-		uint32 count = cities_awaiting_private_car_route_check.get_count();
+		// The cities being processed by the private car threads are saved as if they were queued first:
+		// after loading, their routes are found again from the start (this only adds the same routes again).
+		vector_tpl<stadt_t*> cities_to_save;
+#ifdef MULTI_THREAD
+		FOR(vector_tpl<stadt_t*>, const city, private_car_route_cities)
+		{
+			if (city)
+			{
+				cities_to_save.append(city);
+			}
+		}
+#endif
+		for (auto city : cities_awaiting_private_car_route_check)
+		{
+			cities_to_save.append(city);
+		}
+		uint32 count = cities_to_save.get_count();
 		file->rdwr_long(count);
 
-		for (auto city : cities_awaiting_private_car_route_check)
+		FOR(vector_tpl<stadt_t*>, const city, cities_to_save)
 		{
 			koord location = city->get_pos();
 			location.rdwr(file);
@@ -8226,7 +8553,7 @@ DBG_MESSAGE("karte_t::save(loadsave_t *file)", "motd filename %s", env_t::server
 
 	file->set_buffered(false);
 
-	if(needs_redraw) {
+	if(needs_redraw  &&  !in_background_save) {
 		update_map();
 	}
 	if(!silent) {
@@ -8247,6 +8574,7 @@ void karte_t::rdwr_gamestate(loadsave_t *file, loadingscreen_t *ls)
 		powernet_t::new_world();
 		pumpe_t::new_world();
 		senke_t::new_world();
+		leitung_t::new_world();
 
 		// jetzt geht das laden los
 		dbg->warning("karte_t::load", "File version: %u, Extended version: %u, Extended revision: %u", file->get_version_int(), file->get_extended_version(), file->get_extended_revision());
@@ -9600,9 +9928,15 @@ DBG_MESSAGE("karte_t::load()", "%d factories loaded", fab_list.get_count());
 		}
 	}
 
-	if (file->get_extended_version() >= 15 || (file->get_extended_version() == 14 && file->get_extended_revision() >= 20))
+	if (file->is_version_ex_atleast(14, 67))
+	{
+		private_car_routes_t::rdwr(file);
+	}
+	else if (file->get_extended_version() >= 15 || (file->get_extended_version() == 14 && file->get_extended_revision() >= 20))
 	{
-		file->rdwr_long(weg_t::private_car_routes_currently_reading_element);
+		// The routes of older games are not loaded.
+		uint32 dummy = 0;
+		file->rdwr_long(dummy);
 	}
 
 	// Either reload the path explorer data or refresh the routing.
@@ -9637,6 +9971,16 @@ DBG_MESSAGE("karte_t::load()", "%d factories loaded", fab_list.get_count());
 		file->rdwr_long(cities_to_process);
 	}
 
+	private_car_routes_t::finish_loading();
+	if (file->is_version_ex_less(14, 67))
+	{
+		// The private car routes of older games are not loaded, so find them again.
+		FOR(weighted_vector_tpl<stadt_t*>, const city, stadt)
+		{
+			cities_awaiting_private_car_route_check.append_unique(city);
+		}
+	}
+
 	// MUST be at the end of the load/save routine.
 	if(  file->is_version_atleast(102, 4)  ) {
 		file->rdwr_byte( active_player_nr );
@@ -9680,6 +10024,12 @@ DBG_MESSAGE("karte_t::load()", "%d factories loaded", fab_list.get_count());
 
 	calc_max_vehicle_speeds();
 
+	// The landmarks depend on the order of the ways, so they must be recalculated to be the same on all clients.
+	route_landmarks_t::clear_all();
+	route_landmarks_t::update_all(this);
+	route_cache_t::clear();
+	route_cache_t::set_step(steps);
+
 	dbg->warning("karte_t::load()","loaded savegame from %i/%i, next month=%i, ticks=%i (per month=1<<%i)",last_month,last_year,next_month_ticks,ticks,karte_t::ticks_per_world_month_shift);
 }
 
@@ -10811,6 +11161,8 @@ bool karte_t::interactive(uint32 quit_month)
 			break;
 		}
 
+		check_background_save(false);
+
 		if(  env_t::networkmode  ) {
 			process_network_commands(&ms_difference);
 
@@ -11418,7 +11770,7 @@ void karte_t::update_weight_of_building_in_world_list(gebaeude_t *gb)
 
 void karte_t::remove_all_building_references_to_city(stadt_t* city)
 {
-	FOR(weighted_vector_tpl <gebaeude_t *>, building, passenger_origins)
+	FOR(indexed_weighted_vector_tpl <gebaeude_t *>, building, passenger_origins)
 	{
 		if(building->get_stadt() == city)
 		{
@@ -11426,7 +11778,7 @@ void karte_t::remove_all_building_references_to_city(stadt_t* city)
 		}
 	}
 
-	FOR(weighted_vector_tpl <gebaeude_t *>, building, mail_origins_and_targets)
+	FOR(indexed_weighted_vector_tpl <gebaeude_t *>, building, mail_origins_and_targets)
 	{
 		if(building->get_stadt() == city)
 		{
@@ -11436,7 +11788,7 @@ void karte_t::remove_all_building_references_to_city(stadt_t* city)
 
 	for (uint8 i = 0; i < goods_manager_t::passengers->get_number_of_classes(); i++)
 	{
-		FOR(weighted_vector_tpl <gebaeude_t *>, building, commuter_targets[i])
+		FOR(indexed_weighted_vector_tpl <gebaeude_t *>, building, commuter_targets[i])
 		{
 			if (building->get_stadt() == city)
 			{
@@ -11444,7 +11796,7 @@ void karte_t::remove_all_building_references_to_city(stadt_t* city)
 			}
 		}
 
-		FOR(weighted_vector_tpl <gebaeude_t *>, building, visitor_targets[i])
+		FOR(indexed_weighted_vector_tpl <gebaeude_t *>, building, visitor_targets[i])
 		{
 			if (building->get_stadt() == city)
 			{
@@ -15,9 +15,12 @@
 #include "halthandle_t.h"
 
 #include "tpl/weighted_vector_tpl.h"
+#include "tpl/indexed_weighted_vector_tpl.h"
 #include "tpl/vector_tpl.h"
 #include "tpl/slist_tpl.h"
 #include "tpl/koordhashtable_tpl.h"
+#include "tpl/ptrhashtable_tpl.h"
+#include "tpl/timing_wheel_tpl.h"
 
 #include "dataobj/settings.h"
 #include "network/pwd_hash.h"
@@ -780,7 +783,7 @@ private:
 	 * journeys ultimately start, weighted by their level.
 	 * @author: jamespetts
 	 */
-	weighted_vector_tpl <gebaeude_t *> passenger_origins;
+	indexed_weighted_vector_tpl <gebaeude_t *> passenger_origins;
 
 	/**
 	 * This contains all buildings in the world to which passengers make
@@ -788,7 +791,7 @@ private:
 	 * This is an array indexed by class.
 	 * @author: jamespetts
 	 */
-	weighted_vector_tpl <gebaeude_t *> *commuter_targets;
+	indexed_weighted_vector_tpl <gebaeude_t *> *commuter_targets;
 
 	/**
 	 * This contains all buildings in the world to which passengers make
@@ -796,7 +799,7 @@ private:
 	 * This is an array indexed by class.
 	 * @author: jamespetts
 	 */
-	weighted_vector_tpl <gebaeude_t *> *visitor_targets;
+	indexed_weighted_vector_tpl <gebaeude_t *> *visitor_targets;
 
 	/**
 	 * This contains all buildings in the world to and from which mail
@@ -804,7 +807,7 @@ private:
 	 * level.
 	 * @author: jamespetts
 	 */
-	weighted_vector_tpl <gebaeude_t *> mail_origins_and_targets;
+	indexed_weighted_vector_tpl <gebaeude_t *> mail_origins_and_targets;
 
 	/** Stores the value of the next step for passenger/mail generation
 	 * purposes.
@@ -849,6 +852,18 @@ private:
 	/// To prevent pause_step constantly re-checking the private car routes when not necessary.
 	bool private_car_route_check_complete = false;
 
+	/**
+	 * The time (in microseconds, averaged over recent steps) each convoy thread
+	 * spent stepping convoys, and waiting for the others to finish, per step.
+	 */
+	vector_tpl<uint32> convoy_thread_busy_time;
+	vector_tpl<uint32> convoy_thread_idle_time;
+
+#ifdef MULTI_THREAD_CONVOYS
+	/// Add the times of the convoy threads in the last step to the averages.
+	void update_convoy_thread_times();
+#endif
+
 #ifdef MULTI_THREAD
 	bool passengers_and_mail_threads_working;
 	bool convoy_threads_working;
@@ -875,7 +890,14 @@ public:
 	void await_path_explorer();
 	void await_private_car_threads(bool override_suspend = false);
 	void suspend_private_car_threads();
-	void await_all_threads();
+	/**
+	 * Wait until no thread changes the world any more.
+	 * With @p finish_private_car_routes, the cities whose private car routes are being
+	 * found are finished first (see suspend_private_car_threads). This changes the game,
+	 * so it must only be done where all clients of a network game do it.
+	 * Otherwise the search stays where it is and continues in the next step.
+	 */
+	void await_all_threads(bool finish_private_car_routes = true);
 
 	enum building_type { passenger_origin, commuter_target, visitor_target, mail_origin_or_target, none };
 	enum trip_type { commuting_trip, visiting_trip, mail_trip };
@@ -905,6 +927,16 @@ private:
 
 	static sint32 cities_to_process;
 #ifdef MULTI_THREAD
+	/**
+	 * The city whose private car routes each private car thread finds, or NULL.
+	 * They are handed out in the order of cities_awaiting_private_car_route_check
+	 * by assign_private_car_route_cities, so they are the same on all clients.
+	 */
+	static vector_tpl<stadt_t*> private_car_route_cities;
+
+	/// Give the idle private car threads the next queued cities, and count the cities in progress.
+	void assign_private_car_route_cities();
+
 	friend void *check_road_connexions_threaded(void* args);
 	friend void *unreserve_route_threaded(void* args);
 	friend void *step_passengers_and_mail_threaded(void* args);
@@ -1655,6 +1687,14 @@ public:
 	 */
 	uint32 get_idle_time() const { return idle_time; }
 
+	/**
+	 * Number of convoy threads with times (0 if not multi-threaded),
+	 * and their average busy and idle time per step in microseconds.
+	 */
+	uint32 get_convoy_thread_count() const { return convoy_thread_busy_time.get_count(); }
+	uint32 get_convoy_thread_busy_time(uint32 thread_number) const { return convoy_thread_busy_time[thread_number]; }
+	uint32 get_convoy_thread_idle_time(uint32 thread_number) const { return convoy_thread_idle_time[thread_number]; }
+
 	/**
 	 * Number of frames displayed in the last real time second.
 	 */
@@ -2155,12 +2195,24 @@ public:
 			sync_list_t() : currently_deleting(NULL), sync_step_running(false) {}
 			void add(sync_steppable *obj);
 			void remove(sync_steppable *obj);
+			/// an idle object is stepped again from the next sync step on, the time it was left out is dropped
+			void wake(sync_steppable *obj);
+			/// time for which an idle object has been left out of the sync steps so far, 0 if it is not idle
+			uint32 get_idle_time(const sync_steppable *obj) const;
 		private:
 			void sync_step(uint32 delta_t);
 			/// clears list, does not delete the objects
 			void clear();
 
+			struct idle_t {
+				uint64 since; ///< time of the last sync step of the object
+				uint64 due;   ///< time of the next sync step of the object
+			};
+
 			vector_tpl<sync_steppable *> list;  ///< list of sync-steppable objects
+			timing_wheel_tpl<sync_steppable *> idle_wheel; ///< idle objects by the time they are due again
+			ptrhashtable_tpl<const sync_steppable *, idle_t, N_BAGS_LARGE> idle_objects;
+			vector_tpl<sync_steppable *> due_objects; ///< idle objects due again in this sync step
 			sync_steppable* currently_deleting; ///< deleted durign sync_step, safeguard calls to remove
 			bool sync_step_running;
 	};
@@ -2347,6 +2399,23 @@ public:
 	 */
 	void save(const char *filename, bool autosave, const char *version, const char *ex_version, const char* ex_revision, bool silent);
 
+	/// true, if saves can be written in the background (see env_t::background_save)
+	static bool can_save_in_background();
+
+	/**
+	 * Saves the map to a file from a forked copy of the game, while this one continues.
+	 * Only one background save runs at a time, and none while the map must be
+	 * rotated for saving (see set_nosave_warning()).
+	 * @return false if the save could not be started; then nothing is saved
+	 */
+	bool save_in_background(const char *filename, bool autosave, const char *version, const char *ex_version, const char* ex_revision);
+
+	/**
+	 * Reports the result of a finished background save.
+	 * @param wait if true, waits until a running background save has finished
+	 */
+	void check_background_save(bool wait);
+
 	/**
 	 * Loads a map from a file.
 	 * @param filename name of the file to read.
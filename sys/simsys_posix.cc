@@ -16,6 +16,7 @@
 #endif
 
 #include <signal.h>
+#include <stdlib.h>
 
 #include "../macros.h"
 #include "../simdebug.h"
@@ -26,7 +27,12 @@
 static bool sigterm_received = false;
 
 #if COLOUR_DEPTH != 0
-#error "Posix only compiles with color depth=0"
+// without a window everything is drawn into this buffer, e.g. for benchmarks
+static unsigned short *framebuffer = NULL;
+
+// default size of the offscreen "screen"
+#define OFFSCREEN_WIDTH  (1024)
+#define OFFSCREEN_HEIGHT (768)
 #endif
 
 bool dr_set_screen_scale(sint16)
@@ -52,38 +58,85 @@ bool dr_os_init(const int*)
 
 resolution dr_query_screen_resolution()
 {
+#if COLOUR_DEPTH != 0
+	resolution const res = { OFFSCREEN_WIDTH, OFFSCREEN_HEIGHT };
+#else
 	resolution const res = { 0, 0 };
+#endif
 	return res;
 }
 
 // open the window
-int dr_os_open(int, int, sint16)
+#if COLOUR_DEPTH != 0
+int dr_os_open(const scr_size window_size, sint16)
+{
+	// same alignment as the other backends
+	const int tex_pitch = (window_size.w + 15) & 0x7FF0;
+
+	framebuffer = (unsigned short *)calloc( tex_pitch * window_size.h, sizeof(unsigned short) );
+	if(  framebuffer == NULL  ) {
+		dbg->error( "dr_os_open(posix)", "Could not allocate %ix%i pixels", tex_pitch, window_size.h );
+		return 0;
+	}
+	return tex_pitch;
+}
+#else
+int dr_os_open(const scr_size, sint16)
 {
 	return 1;
 }
+#endif
 
 
 void dr_os_close()
 {
+#if COLOUR_DEPTH != 0
+	free( framebuffer );
+	framebuffer = NULL;
+#endif
 }
 
 // resizes screen
+#if COLOUR_DEPTH != 0
+int dr_textur_resize(unsigned short** const textur, int w, int h)
+{
+	const int tex_pitch = (w + 15) & 0x7FF0;
+
+	free( framebuffer );
+	framebuffer = (unsigned short *)calloc( tex_pitch * h, sizeof(unsigned short) );
+	*textur = framebuffer;
+	return tex_pitch;
+}
+#else
 int dr_textur_resize(unsigned short** const textur, int, int)
 {
 	*textur = NULL;
 	return 1;
 }
+#endif
 
 
 unsigned short *dr_textur_init()
 {
+#if COLOUR_DEPTH != 0
+	return framebuffer;
+#else
 	return NULL;
+#endif
 }
 
+#if COLOUR_DEPTH != 0
+// RGB565 like the SDL2 backend
+unsigned int get_system_color(unsigned int r, unsigned int g, unsigned int b)
+{
+	return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+#else
 unsigned int get_system_color(unsigned int, unsigned int, unsigned int)
 {
 	return 1;
 }
+#endif
 
 void dr_prepare_flush()
 {
@@ -0,0 +1,536 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef TPL_INDEXED_WEIGHTED_VECTOR_TPL_H
+#define TPL_INDEXED_WEIGHTED_VECTOR_TPL_H
+
+
+#include <cstddef>
+#include <iterator>
+#include <unordered_map>
+
+#include "../macros.h"
+#include "../simdebug.h"
+#include "../simtypes.h"
+
+
+template<class T> class indexed_weighted_vector_tpl;
+template<class T> void swap(indexed_weighted_vector_tpl<T>&, indexed_weighted_vector_tpl<T>&);
+
+
+/**
+ * A weighted vector for long lists whose weights change often.
+ *
+ * It selects the same element as weighted_vector_tpl for the same order of
+ * elements and weights in at_weight(), but the elements are kept in a balanced
+ * tree (a treap ordered by position) that holds the sum of the weights of each
+ * subtree, and an element is found by a hash table. So inserting, removing and
+ * updating the weight of an element and at_weight() take O(log n) instead of O(n)
+ * (insert_ordered() O(log^2 n), as it bisects by position like weighted_vector_tpl).
+ *
+ * The shape of the tree does not depend on anything but the sequence of
+ * operations, but only the order of the elements matters for the results anyway.
+ * T must be usable as the key of a std::unordered_map.
+ */
+template<class T> class indexed_weighted_vector_tpl
+{
+	private:
+		struct node_t
+		{
+			T data;
+			uint32 weight;
+			uint32 sum_weight; ///< of this subtree
+			uint32 count;      ///< of this subtree
+			uint32 priority;
+			node_t *left, *right, *parent;
+		};
+
+		typedef std::unordered_multimap<T, node_t*> node_map_t;
+
+	public:
+		class const_iterator;
+
+		class iterator
+		{
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef std::ptrdiff_t            difference_type;
+				typedef T const*                  pointer;
+				typedef T const&                  reference;
+				typedef T                         value_type;
+
+				T& operator *() const { return ptr->data; }
+
+				iterator& operator ++() { ptr = successor(ptr); return *this; }
+
+				bool operator !=(const iterator& o) { return ptr != o.ptr; }
+
+			private:
+				explicit iterator(node_t* ptr_) : ptr(ptr_) {}
+
+				node_t* ptr;
+
+			friend class indexed_weighted_vector_tpl;
+			friend class const_iterator;
+		};
+
+		class const_iterator
+		{
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef std::ptrdiff_t            difference_type;
+				typedef T const*                  pointer;
+				typedef T const&                  reference;
+				typedef T                         value_type;
+
+				const_iterator(const iterator& o) : ptr(o.ptr) {}
+
+				const T& operator *() const { return ptr->data; }
+
+				const_iterator& operator ++() { ptr = successor(ptr); return *this; }
+
+				bool operator !=(const const_iterator& o) { return ptr != o.ptr; }
+
+			private:
+				explicit const_iterator(const node_t* ptr_) : ptr(ptr_) {}
+
+				const node_t* ptr;
+
+			friend class indexed_weighted_vector_tpl;
+		};
+
+		indexed_weighted_vector_tpl() : root(NULL), random_state(0x9E3779B9u) {}
+
+		~indexed_weighted_vector_tpl() { delete_tree(root); }
+
+		/** sets the vector to empty */
+		void clear()
+		{
+			delete_tree(root);
+			root = NULL;
+			nodes.clear();
+		}
+
+		/**
+		 * Checks if element elem is contained in vector.
+		 * Uses the == operator for comparison.
+		 */
+		bool is_contained(T elem) const
+		{
+			return nodes.find(elem) != nodes.end();
+		}
+
+		/** @returns the position of the first copy of elem */
+		uint32 index_of(T elem) const
+		{
+			const node_t *n = find_first(elem);
+			if(  n == NULL  ) {
+				dbg->fatal("indexed_weighted_vector_tpl<T>::index_of()", "not contained" );
+			}
+			return position_of(n);
+		}
+
+		/**
+		 * Appends the element at the end of the vector.
+		 */
+		bool append(T elem, uint32 weight)
+		{
+			return insert_at(get_count(), elem, weight);
+		}
+
+		/**
+		 * Checks if element is contained. Appends only new elements.
+		 */
+		bool append_unique(T elem, uint32 weight)
+		{
+			return is_contained(elem) || append(elem, weight);
+		}
+
+		/** inserts data at a certain pos */
+		bool insert_at(uint32 pos, T elem, uint32 weight)
+		{
+#ifdef IGNORE_ZERO_WEIGHT
+			if (weight == 0) {
+				// ignore unused entries ...
+				return false;
+			}
+#endif
+			node_t *n = new node_t;
+			n->data = elem;
+			n->weight = weight;
+			n->sum_weight = weight;
+			n->count = 1;
+			n->priority = next_priority();
+			n->left = n->right = n->parent = NULL;
+
+			node_t *l, *r;
+			split(root, min(pos, get_count()), l, r);
+			set_root(merge(merge(l, n), r));
+			nodes.insert(typename node_map_t::value_type(elem, n));
+			return true;
+		}
+
+		/**
+		 * Insert `elem' with respect to ordering.
+		 */
+		template<class StrictWeakOrdering>
+		void insert_ordered(const T& elem, uint32 weight, StrictWeakOrdering comp)
+		{
+			// The same bisection as weighted_vector_tpl, so that the position is the same
+			// even if the vector is not ordered (e.g. if elements were appended).
+			sint32 high = get_count(), low = -1;
+			while(  high-low>1  ) {
+				const sint32 mid = ((uint32)(high + low)) >> 1;
+				if(  comp(elem, node_at(mid)->data)  ) {
+					high = mid;
+				}
+				else {
+					low = mid;
+				}
+			}
+			insert_at(high, elem, weight);
+		}
+
+		/**
+		 * Update the weight of the (first copy of the) element, if contained
+		 */
+		bool update(T elem, uint32 weight)
+		{
+			node_t *n = find_first(elem);
+			if(  n == NULL  ) {
+				return false;
+			}
+			set_weight(n, weight);
+			return true;
+		}
+
+		/**
+		 * Update the weight of the element at the specified position
+		 */
+		bool update_at(uint32 pos, uint32 weight)
+		{
+			if(  pos >= get_count()  ) {
+				return false;
+			}
+			set_weight(node_at(pos), weight);
+			return true;
+		}
+
+		/** removes element, if contained */
+		bool remove(T elem)
+		{
+			node_t *n = find_first(elem);
+			if(  n == NULL  ) {
+				return false;
+			}
+			remove_node(n);
+			return true;
+		}
+
+		/** removes all copies of element, if contained */
+		bool remove_all(T elem)
+		{
+			bool any_to_remove = false;
+			while(  node_t *n = find_first(elem)  ) {
+				remove_node(n);
+				any_to_remove = true;
+			}
+			return any_to_remove;
+		}
+
+		/** removes element at position */
+		bool remove_at(uint32 pos)
+		{
+			if(  pos >= get_count()  ) {
+				return false;
+			}
+			remove_node(node_at(pos));
+			return true;
+		}
+
+		T& operator [](uint32 i)
+		{
+			if (i >= get_count()) dbg->fatal("indexed_weighted_vector_tpl<T>::get()", "index out of bounds: %i not in 0..%d", i, get_count() - 1);
+			return node_at(i)->data;
+		}
+
+		const T& operator [](uint32 i) const
+		{
+			if (i >= get_count()) dbg->fatal("indexed_weighted_vector_tpl<T>::get()", "index out of bounds: %i not in 0..%d", i, get_count() - 1);
+			return node_at(i)->data;
+		}
+
+		/** returns the weight at a position, i.e. the sum of the weights before it */
+		uint32 weight_at(uint32 pos) const
+		{
+			if(  pos >= get_count()  ) {
+				return get_sum_weight() + 1;
+			}
+			uint32 weight = 0;
+			for(  const node_t *n = root;  n;  ) {
+				const uint32 left_count = count_of(n->left);
+				if(  pos < left_count  ) {
+					n = n->left;
+				}
+				else {
+					weight += sum_weight_of(n->left);
+					if(  pos == left_count  ) {
+						break;
+					}
+					weight += n->weight;
+					pos -= left_count + 1;
+					n = n->right;
+				}
+			}
+			return weight;
+		}
+
+		/**
+		 * Accesses the element at position i by weight: the element whose weight
+		 * covers target_weight, counting the weights from the first element.
+		 */
+		T& at_weight(uint32 target_weight) const
+		{
+			if (target_weight > get_sum_weight()) {
+				dbg->fatal("indexed_weighted_vector_tpl<T>::at_weight()", "weight out of bounds: %i not in 0..%d", target_weight, get_sum_weight());
+			}
+			node_t *n = root;
+			while(  n  ) {
+				const uint32 left_weight = sum_weight_of(n->left);
+				if(  target_weight < left_weight  ) {
+					n = n->left;
+				}
+				else if(  target_weight - left_weight < n->weight  ||  n->right == NULL  ) {
+					// the last element if target_weight is the sum of all weights
+					break;
+				}
+				else {
+					target_weight -= left_weight + n->weight;
+					n = n->right;
+				}
+			}
+			if(  n == NULL  ) {
+				dbg->fatal("indexed_weighted_vector_tpl<T>::at_weight()", "empty vector");
+			}
+			return n->data;
+		}
+
+		/** Gets the number of elements in the vector */
+		uint32 get_count() const { return count_of(root); }
+
+		/** Gets the total weight */
+		uint32 get_sum_weight() const { return sum_weight_of(root); }
+
+		bool empty() const { return root == NULL; }
+
+		iterator begin() { return iterator(leftmost(root)); }
+		iterator end()   { return iterator(NULL); }
+
+		const_iterator begin() const { return const_iterator(leftmost(root)); }
+		const_iterator end()   const { return const_iterator(NULL); }
+
+	private:
+		node_t *root;
+		node_map_t nodes;
+
+		/// for the priorities of the nodes (xorshift32)
+		uint32 random_state;
+
+		uint32 next_priority()
+		{
+			random_state ^= random_state << 13;
+			random_state ^= random_state >> 17;
+			random_state ^= random_state << 5;
+			return random_state;
+		}
+
+		static uint32 count_of(const node_t *n) { return n ? n->count : 0; }
+
+		static uint32 sum_weight_of(const node_t *n) { return n ? n->sum_weight : 0; }
+
+		/// Recalculate the sums of n from its children and make it their parent.
+		static void pull(node_t *n)
+		{
+			n->count = 1 + count_of(n->left) + count_of(n->right);
+			n->sum_weight = n->weight + sum_weight_of(n->left) + sum_weight_of(n->right);
+			if(  n->left  ) {
+				n->left->parent = n;
+			}
+			if(  n->right  ) {
+				n->right->parent = n;
+			}
+		}
+
+		void set_root(node_t *n)
+		{
+			root = n;
+			if(  root  ) {
+				root->parent = NULL;
+			}
+		}
+
+		static node_t *merge(node_t *l, node_t *r)
+		{
+			if(  l == NULL  ) {
+				return r;
+			}
+			if(  r == NULL  ) {
+				return l;
+			}
+			if(  l->priority >= r->priority  ) {
+				l->right = merge(l->right, r);
+				pull(l);
+				return l;
+			}
+			r->left = merge(l, r->left);
+			pull(r);
+			return r;
+		}
+
+		/// Split t into its first pos elements (l) and the others (r).
+		static void split(node_t *t, uint32 pos, node_t *&l, node_t *&r)
+		{
+			if(  t == NULL  ) {
+				l = r = NULL;
+				return;
+			}
+			t->parent = NULL;
+			const uint32 left_count = count_of(t->left);
+			if(  pos <= left_count  ) {
+				split(t->left, pos, l, t->left);
+				pull(t);
+				r = t;
+			}
+			else {
+				split(t->right, pos - left_count - 1, t->right, r);
+				pull(t);
+				l = t;
+			}
+			if(  l  ) {
+				l->parent = NULL;
+			}
+			if(  r  ) {
+				r->parent = NULL;
+			}
+		}
+
+		node_t *node_at(uint32 pos) const
+		{
+			node_t *n = root;
+			while(  n  ) {
+				const uint32 left_count = count_of(n->left);
+				if(  pos < left_count  ) {
+					n = n->left;
+				}
+				else if(  pos == left_count  ) {
+					break;
+				}
+				else {
+					pos -= left_count + 1;
+					n = n->right;
+				}
+			}
+			return n;
+		}
+
+		static uint32 position_of(const node_t *n)
+		{
+			uint32 pos = count_of(n->left);
+			for(  ;  n->parent;  n = n->parent  ) {
+				if(  n->parent->right == n  ) {
+					pos += count_of(n->parent->left) + 1;
+				}
+			}
+			return pos;
+		}
+
+		node_t *find_first(T elem) const
+		{
+			std::pair<typename node_map_t::const_iterator, typename node_map_t::const_iterator> range = nodes.equal_range(elem);
+			node_t *first = NULL;
+			uint32 first_pos = 0;
+			for(  typename node_map_t::const_iterator iter = range.first;  iter != range.second;  ++iter  ) {
+				const uint32 pos = position_of(iter->second);
+				if(  first == NULL  ||  pos < first_pos  ) {
+					first = iter->second;
+					first_pos = pos;
+				}
+			}
+			return first;
+		}
+
+		void set_weight(node_t *n, uint32 weight)
+		{
+			n->weight = weight;
+			for(  ;  n;  n = n->parent  ) {
+				n->sum_weight = n->weight + sum_weight_of(n->left) + sum_weight_of(n->right);
+			}
+		}
+
+		void remove_node(node_t *n)
+		{
+			std::pair<typename node_map_t::iterator, typename node_map_t::iterator> range = nodes.equal_range(n->data);
+			for(  typename node_map_t::iterator iter = range.first;  iter != range.second;  ++iter  ) {
+				if(  iter->second == n  ) {
+					nodes.erase(iter);
+					break;
+				}
+			}
+
+			node_t *l, *m, *r;
+			split(root, position_of(n), l, m);
+			split(m, 1, m, r);
+			delete m;
+			set_root(merge(l, r));
+		}
+
+		static node_t *leftmost(node_t *n)
+		{
+			if(  n  ) {
+				while(  n->left  ) {
+					n = n->left;
+				}
+			}
+			return n;
+		}
+
+		template<class N> static N *successor(N *n)
+		{
+			if(  n->right  ) {
+				n = n->right;
+				while(  n->left  ) {
+					n = n->left;
+				}
+				return n;
+			}
+			while(  n->parent  &&  n->parent->right == n  ) {
+				n = n->parent;
+			}
+			return n->parent;
+		}
+
+		static void delete_tree(node_t *n)
+		{
+			while(  n  ) {
+				delete_tree(n->left);
+				node_t *right = n->right;
+				delete n;
+				n = right;
+			}
+		}
+
+		indexed_weighted_vector_tpl(const indexed_weighted_vector_tpl& other);
+
+		indexed_weighted_vector_tpl& operator=( indexed_weighted_vector_tpl const& other );
+
+		friend void swap(indexed_weighted_vector_tpl<T>&a, indexed_weighted_vector_tpl<T>&b)
+		{
+			sim::swap(a.root, b.root);
+			a.nodes.swap(b.nodes);
+			sim::swap(a.random_state, b.random_state);
+		}
+};
+
+#endif
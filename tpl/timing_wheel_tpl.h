@@ -0,0 +1,168 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef TPL_TIMING_WHEEL_TPL_H
+#define TPL_TIMING_WHEEL_TPL_H
+
+
+#include "../simtypes.h"
+#include "vector_tpl.h"
+
+
+/**
+ * A hierarchical timing wheel: elements are put in with the time they are due
+ * and handed out again when the wheel has been advanced to that time.
+ *
+ * The lowest level has one slot per tick, every higher level one slot per turn
+ * of the level below. Elements are moved to the lower levels when their slot
+ * comes up, so inserting, removing and advancing do not depend on the number
+ * of waiting elements. Elements due beyond the highest level are put back into
+ * the highest level until they are in reach.
+ *
+ * Elements due at the same time are handed out in the order they were inserted.
+ */
+template<class T> class timing_wheel_tpl
+{
+	enum {
+		SLOT_BITS  = 6,
+		SLOT_COUNT = 1 << SLOT_BITS,
+		SLOT_MASK  = SLOT_COUNT - 1,
+		LEVELS     = 4
+	};
+
+	struct entry_t
+	{
+		T elem;
+		uint64 due;
+	};
+
+	vector_tpl<entry_t> slots[LEVELS][SLOT_COUNT];
+
+	/// all elements due up to this time have been handed out
+	uint64 time;
+
+	uint32 count;
+
+	/// the level which holds an element due at this time
+	uint32 get_level(uint64 due) const
+	{
+		for(  uint32 level = 0;  level < LEVELS - 1;  level++  ) {
+			const uint32 shift = SLOT_BITS * (level + 1);
+			if(  (due >> shift) == (time >> shift)  ) {
+				return level;
+			}
+		}
+		return LEVELS - 1;
+	}
+
+	vector_tpl<entry_t> &get_slot(uint32 level, uint64 due)
+	{
+		return slots[level][(due >> (SLOT_BITS * level)) & SLOT_MASK];
+	}
+
+	void put(const entry_t &entry)
+	{
+		get_slot(get_level(entry.due), entry.due).append(entry);
+	}
+
+	/// moves the elements of a slot of a higher level down, now that its turn has come
+	void cascade(uint32 level, uint32 index)
+	{
+		vector_tpl<entry_t> entries;
+		swap(entries, slots[level][index]);
+		FORT(vector_tpl<entry_t>, const &entry, entries) {
+			put(entry);
+		}
+	}
+
+public:
+	timing_wheel_tpl() : time(0), count(0) {}
+
+	uint32 get_count() const { return count; }
+
+	bool empty() const { return count == 0; }
+
+	/// all elements due up to this time have been handed out
+	uint64 get_time() const { return time; }
+
+	/// removes all elements and starts again at time 0
+	void clear()
+	{
+		for(  uint32 level = 0;  level < LEVELS;  level++  ) {
+			for(  uint32 i = 0;  i < SLOT_COUNT;  i++  ) {
+				slots[level][i].clear();
+			}
+		}
+		time = 0;
+		count = 0;
+	}
+
+	/**
+	 * Adds an element, which is handed out by advance() once the wheel reaches due.
+	 * Elements which are due already are handed out by the next advance().
+	 */
+	void insert(const T &elem, uint64 due)
+	{
+		entry_t entry;
+		entry.elem = elem;
+		entry.due = due > time ? due : time + 1;
+		put(entry);
+		count++;
+	}
+
+	/**
+	 * Removes an element inserted with this due time.
+	 * @return false if the element was not found
+	 */
+	bool remove(const T &elem, uint64 due)
+	{
+		for(  uint32 level = 0;  level < LEVELS;  level++  ) {
+			vector_tpl<entry_t> &slot = get_slot(level, due);
+			for(  uint32 i = 0;  i < slot.get_count();  i++  ) {
+				if(  slot[i].elem == elem  &&  slot[i].due == due  ) {
+					slot.remove_at(i);
+					count--;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Advances the wheel to new_time and appends all elements due until then
+	 * to due_elems, in order of their due time.
+	 */
+	void advance(uint64 new_time, vector_tpl<T> &due_elems)
+	{
+		while(  time < new_time  ) {
+			if(  count == 0  ) {
+				time = new_time;
+				break;
+			}
+			time++;
+
+			if(  (time & SLOT_MASK) == 0  ) {
+				// next turn of the lowest level: bring down the elements of the coming slots
+				for(  uint32 level = 1;  level < LEVELS;  level++  ) {
+					const uint32 index = (uint32)(time >> (SLOT_BITS * level)) & SLOT_MASK;
+					cascade(level, index);
+					if(  index != 0  ) {
+						break;
+					}
+				}
+			}
+
+			vector_tpl<entry_t> &slot = slots[0][time & SLOT_MASK];
+			FORT(vector_tpl<entry_t>, const &entry, slot) {
+				due_elems.append(entry.elem);
+			}
+			count -= slot.get_count();
+			slot.clear();
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef UTILS_CPU_FEATURES_H
+#define UTILS_CPU_FEATURES_H
+
+
+/*
+ * Compile time and run time detection of vector instruction sets.
+ *
+ * SIMD_SSE2 is defined when SSE2 can be used unconditionally (always true for x86-64).
+ * SIMD_AVX2 is defined when AVX2 code paths can be compiled; such functions must be
+ * marked with SIMD_AVX2_TARGET and may only be called if cpu_has_avx2() returns true.
+ * SIMD_NEON is defined when NEON can be used unconditionally (always true for aarch64).
+ *
+ * Vectorised code paths must always give exactly the same results as their scalar
+ * counterparts, as the outcome may not depend on the hardware in network games.
+ */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#	if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define SIMD_SSE2 1
+#	endif
+#	if defined(__GNUC__) || defined(__clang__)
+#		define SIMD_AVX2 1
+#		define SIMD_AVX2_TARGET __attribute__((target("avx2")))
+#	elif defined(_MSC_VER) && _MSC_VER >= 1900
+		// MSVC allows the use of AVX2 intrinsics without any special compiler switches
+#		define SIMD_AVX2 1
+#		define SIMD_AVX2_TARGET
+#		include <intrin.h>
+#	endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#	define SIMD_NEON 1
+#endif
+
+
+/**
+ * @returns true if the processor and the operating system support AVX2.
+ * The result is determined once and then cached.
+ */
+inline bool cpu_has_avx2()
+{
+#if defined(SIMD_AVX2) && defined(_MSC_VER) && !defined(__clang__)
+	static const bool has_avx2 = []() {
+		int info[4];
+		__cpuid(info, 0);
+		if(  info[0] < 7  ) {
+			return false;
+		}
+		__cpuid(info, 1);
+		// OSXSAVE and AVX, and the OS must save the YMM registers
+		if(  (info[2] & (1 << 27)) == 0  ||  (info[2] & (1 << 28)) == 0  ||  (_xgetbv(0) & 6) != 6  ) {
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}();
+	return has_avx2;
+#elif defined(SIMD_AVX2)
+	static const bool has_avx2 = __builtin_cpu_supports("avx2");
+	return has_avx2;
+#else
+	return false;
+#endif
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef UTILS_WORK_STEALING_H
+#define UTILS_WORK_STEALING_H
+
+
+#include <atomic>
+
+#include "../simtypes.h"
+
+
+/**
+ * Hands out the indices 0..count-1 of a list of independent jobs to a fixed
+ * number of threads.
+ *
+ * Every thread gets a contiguous range of indices, which it works through from
+ * the front. A thread that has finished its own range takes the jobs from the
+ * back of the ranges of the others, one at a time, so no thread waits while
+ * others have a long queue behind one expensive job.
+ *
+ * Which thread does which job depends on timing, so the jobs must not depend on
+ * each other, and their results must be used in the order of the jobs.
+ */
+class work_stealing_ranges_t
+{
+public:
+	work_stealing_ranges_t() : ranges(NULL), thread_count(0) {}
+
+	~work_stealing_ranges_t() { delete [] ranges; }
+
+	/**
+	 * Distribute @p count jobs to @p threads threads.
+	 * Must not be called while any thread takes jobs.
+	 */
+	void init(uint32 count, uint32 threads)
+	{
+		if(  threads != thread_count  ) {
+			delete [] ranges;
+			ranges = threads > 0 ? new range_t[threads] : NULL;
+			thread_count = threads;
+		}
+		for(  uint32 i = 0;  i < thread_count;  i++  ) {
+			const uint32 begin = (uint32)(((uint64)count * i) / thread_count);
+			const uint32 end = (uint32)(((uint64)count * (i + 1)) / thread_count);
+			ranges[i].bounds.store(pack(begin, end), std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * Get the next job for the thread @p thread_number.
+	 * @returns false if there are no jobs left.
+	 */
+	bool get_next(uint32 thread_number, uint32 &job)
+	{
+		if(  take(ranges[thread_number], false, job)  ) {
+			return true;
+		}
+		// Jobs are never added, so a range once empty stays empty.
+		for(  uint32 i = 1;  i < thread_count;  i++  ) {
+			if(  take(ranges[(thread_number + i) % thread_count], true, job)  ) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	// on a cache line of its own, as it is written by different threads
+	struct range_t
+	{
+		std::atomic<uint64> bounds;
+		char padding[64 - sizeof(std::atomic<uint64>)];
+	};
+
+	range_t *ranges;
+	uint32 thread_count;
+
+	static uint64 pack(uint32 begin, uint32 end) { return ((uint64)end << 32) | begin; }
+
+	static bool take(range_t &range, bool from_back, uint32 &job)
+	{
+		uint64 bounds = range.bounds.load(std::memory_order_relaxed);
+		while(  true  ) {
+			const uint32 begin = (uint32)bounds;
+			const uint32 end = (uint32)(bounds >> 32);
+			if(  begin >= end  ) {
+				return false;
+			}
+			const uint64 taken = from_back ? pack(begin, end - 1) : pack(begin + 1, end);
+			if(  range.bounds.compare_exchange_weak(bounds, taken, std::memory_order_relaxed)  ) {
+				job = from_back ? end - 1 : begin;
+				return true;
+			}
+		}
+	}
+
+	work_stealing_ranges_t(const work_stealing_ranges_t &);
+	work_stealing_ranges_t &operator=(const work_stealing_ranges_t &);
+};
+
+#endif
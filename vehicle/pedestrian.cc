@@ -4,6 +4,7 @@
  */
 
 #include "pedestrian.h"
+#include "road_user_flow.h"
 
 #include "../simdebug.h"
 #include "../simworld.h"
@@ -265,6 +266,11 @@ void pedestrian_t::generate_pedestrians_at(const koord3d k, uint32 count, uint32
 
 sync_result pedestrian_t::sync_step(uint32 delta_t)
 {
+	if(  road_user_flow_t::absorb(this)  ) {
+		// far from the viewport: walks on as part of the flow of this road
+		return SYNC_DELETE;
+	}
+
 	time_to_life -= delta_t;
 
 	if (time_to_life>0) {
@@ -19,6 +19,8 @@ class pedestrian_desc_t;
  */
 class pedestrian_t : public road_user_t
 {
+	friend class road_user_flow_t;
+
 private:
 	static stringhashtable_tpl<const pedestrian_desc_t *, N_BAGS_SMALL> table;
 
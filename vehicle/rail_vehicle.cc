@@ -293,6 +293,20 @@ bool rail_vehicle_t::check_next_tile(const grund_t *bd) const
 }
 
 
+bool rail_vehicle_t::get_route_profile(route_profile_t &profile) const
+{
+	if(  !get_route_profile_common(profile)  ) {
+		return false;
+	}
+	if(  (target_halt.is_bound()  &&  cnv->is_waiting())  ||  cnv->get_is_choosing()  ) {
+		// check_next_tile() depends on the reservations then
+		return false;
+	}
+	profile.min_speed = cnv->get_min_top_speed();
+	return true;
+}
+
+
 // how expensive to go here (for way search)
 int rail_vehicle_t::get_cost(const grund_t *gr, const sint32 max_speed, koord from_pos)
 {
@@ -39,6 +39,11 @@ public:
 
 	uint32 get_cost_upslope() const OVERRIDE { return 75; } // Standard is 15
 
+	// full speed on a diagonal way
+	uint32 get_min_cost() const OVERRIDE { return desc->get_override_way_speed() ? 0 : 7; }
+
+	bool get_route_profile(route_profile_t &profile) const OVERRIDE;
+
 	// returns true for the way search to an unknown target.
 	bool is_target(const grund_t *,const grund_t *) OVERRIDE;
 
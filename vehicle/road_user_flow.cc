@@ -0,0 +1,332 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include "road_user_flow.h"
+
+#include "simroadtraffic.h"
+#include "pedestrian.h"
+
+#include "../simworld.h"
+#include "../simcity.h"
+#include "../boden/grund.h"
+#include "../boden/wege/weg.h"
+#include "../dataobj/environment.h"
+#include "../obj/gebaeude.h"
+#include "../descriptor/citycar_desc.h"
+#include "../descriptor/pedestrian_desc.h"
+#include "../display/viewport.h"
+#include "../player/simplay.h"
+
+
+vector_tpl<road_user_flow_t::tile_flow_t> road_user_flow_t::flows;
+inthashtable_tpl<uint64, uint32, N_BAGS_LARGE> road_user_flow_t::flow_index;
+inthashtable_tpl<uint64, uint32, N_BAGS_LARGE> road_user_flow_t::tile_load;
+
+// length of a city car in carunits, as assumed by private_car_t::can_overtake
+static const uint32 CITYCAR_LENGTH = 10;
+
+
+uint64 road_user_flow_t::get_key(const koord3d &pos)
+{
+	return (uint64)(uint16)pos.x | ((uint64)(uint16)pos.y << 16) | ((uint64)(uint8)pos.z << 32);
+}
+
+
+road_user_flow_t::tile_flow_t &road_user_flow_t::get_flow(const koord3d &pos)
+{
+	const uint64 key = get_key(pos);
+	if(  flow_index.is_contained(key)  ) {
+		return flows[flow_index.get(key)];
+	}
+	tile_flow_t flow;
+	flow.pos = pos;
+	flow_index.set(key, flows.get_count());
+	flows.append(flow);
+	return flows.back();
+}
+
+
+void road_user_flow_t::remove_flow(uint32 index)
+{
+	flow_index.remove(get_key(flows[index].pos));
+	if(  index + 1 < flows.get_count()  ) {
+		swap(flows[index].cars, flows.back().cars);
+		swap(flows[index].pedestrians, flows.back().pedestrians);
+		flows[index].pos = flows.back().pos;
+		flow_index.set(get_key(flows[index].pos), index);
+	}
+	flows.pop_back();
+}
+
+
+bool road_user_flow_t::is_off_screen(const koord3d &pos)
+{
+	const viewport_t *vp = world()->get_viewport();
+	return !vp  ||  vp->is_far_from_view(pos);
+}
+
+
+bool road_user_flow_t::is_active()
+{
+	// the viewport differs between the clients of a network game
+	return env_t::aggregate_off_screen_road_users  &&  !env_t::networkmode;
+}
+
+
+bool road_user_flow_t::absorb(const private_car_t *car)
+{
+	if(  !is_active()  ||  !car->desc  ||  car->time_to_life <= 0  ||  !is_off_screen(car->get_pos())  ) {
+		return false;
+	}
+	const grund_t *gr = world()->lookup(car->get_pos());
+	if(  !gr  ||  !gr->get_weg(road_wt)  ) {
+		return false;
+	}
+	car_t flow_car;
+	flow_car.desc = car->desc;
+	flow_car.origin = car->origin;
+	flow_car.target = car->target;
+	flow_car.time_to_life = car->time_to_life;
+	flow_car.yards = 0;
+	flow_car.tiles_since_toll = car->tiles_since_last_increment;
+	get_flow(car->get_pos()).cars.append(flow_car);
+	return true;
+}
+
+
+bool road_user_flow_t::absorb(const pedestrian_t *ped)
+{
+	if(  !is_active()  ||  !ped->desc  ||  ped->time_to_life <= 0  ||  !is_off_screen(ped->get_pos())  ) {
+		return false;
+	}
+	const grund_t *gr = world()->lookup(ped->get_pos());
+	if(  !gr  ||  !gr->get_weg(road_wt)  ) {
+		return false;
+	}
+	walker_t walker;
+	walker.desc = ped->desc;
+	walker.time_to_life = ped->time_to_life;
+	get_flow(ped->get_pos()).pedestrians.append(walker);
+	return true;
+}
+
+
+void road_user_flow_t::release(tile_flow_t &flow)
+{
+	karte_t *welt = world();
+	grund_t *gr = welt->lookup(flow.pos);
+	if(  !gr  ) {
+		return;
+	}
+
+	FOR(vector_tpl<car_t>, const &flow_car, flow.cars) {
+		if(  gr->get_top() >= 240  ) {
+			// tile too full
+			return;
+		}
+		private_car_t *car = new private_car_t(gr, flow_car.target);
+		car->desc = flow_car.desc;
+		car->origin = flow_car.origin;
+		car->time_to_life = flow_car.time_to_life;
+		car->tiles_since_last_increment = flow_car.tiles_since_toll;
+		car->calc_image();
+		if(  !gr->obj_add(car)  ) {
+			car->set_flag(obj_t::not_on_map);
+			car->time_to_life = 0;
+			delete car;
+			return;
+		}
+		welt->sync.add(car);
+	}
+
+	FOR(vector_tpl<walker_t>, const &walker, flow.pedestrians) {
+		if(  gr->get_top() >= 240  ) {
+			return;
+		}
+		pedestrian_t *ped = new pedestrian_t(gr, walker.time_to_life);
+		ped->desc = walker.desc;
+		ped->ped_offset = walker.desc->get_offset();
+		ped->calc_image();
+		ped->calc_height(gr);
+		if(  !gr->obj_add(ped)  ) {
+			ped->set_flag(obj_t::not_on_map);
+			ped->time_to_life = 0;
+			delete ped;
+			return;
+		}
+		welt->sync.add(ped);
+	}
+}
+
+
+bool road_user_flow_t::drive(car_t &flow_car, koord3d &pos, uint32 delta_t)
+{
+	karte_t *welt = world();
+	const settings_t &settings = welt->get_settings();
+	const uint32 tiles_per_km = max(1, 1000 / settings.get_meters_per_tile());
+
+	const grund_t *gr = welt->lookup(pos);
+	const weg_t *way = gr ? gr->get_weg(road_wt) : NULL;
+	if(  !way  ||  flow_car.target == koord::invalid  ) {
+		return true;
+	}
+
+	// the route to the destination, or to its city as long as the car is outside of it
+	koord check_target = flow_car.target;
+	if(  !way->has_private_car_route(check_target)  ) {
+		const grund_t *gr_target = welt->lookup_kartenboden(flow_car.target);
+		const gebaeude_t *gb = gr_target ? gr_target->get_building() : NULL;
+		const stadt_t *destination_city = gb ? gb->get_stadt() : NULL;
+		if(  !destination_city  ||  welt->get_city(pos.get_2d()) == destination_city  ||  !way->has_private_car_route(destination_city->get_townhall_road())  ) {
+			// no route: the car stays, so it passes no roads
+			flow_car.yards = 0;
+			return true;
+		}
+		check_target = destination_city->get_townhall_road();
+	}
+
+	uint64 yards = (uint64)min((sint32)flow_car.desc->get_topspeed(), kmh_to_speed(way->get_max_speed())) * delta_t + flow_car.yards;
+	while(  yards >= (1u << YARDS_PER_TILE_SHIFT)  ) {
+		const koord3d next = way->get_next_on_private_car_route_to(check_target);
+		if(  next == koord3d::invalid  ) {
+			// the end of the route
+			return false;
+		}
+		const grund_t *next_gr = welt->lookup(next);
+		weg_t *next_way = next_gr ? next_gr->get_weg(road_wt) : NULL;
+		if(  !next_way  ) {
+			// no route from here (anymore)
+			yards = 0;
+			break;
+		}
+
+		// When more cars pass a tile in this step than its two lanes can take,
+		// they need that much longer for it, so they jam and the road gets congested.
+		const sint32 speed = max(1, min((sint32)flow_car.desc->get_topspeed(), kmh_to_speed(next_way->get_max_speed())));
+		const uint64 key = get_key(next);
+		const uint32 load = tile_load.get(key) + 1;
+		uint64 capacity = ((2 * (uint64)speed * delta_t * CARUNITS_PER_TILE) >> YARDS_PER_TILE_SHIFT) / CITYCAR_LENGTH;
+		if(  capacity == 0  ) {
+			capacity = 1;
+		}
+		uint64 tile_yards = 1u << YARDS_PER_TILE_SHIFT;
+		if(  load > capacity  ) {
+			tile_yards = tile_yards * load / capacity;
+		}
+		if(  yards < tile_yards  ) {
+			// queued in front of the tile
+			break;
+		}
+		yards -= tile_yards;
+		tile_load.set(key, load);
+		pos = next;
+		way = next_way;
+
+		next_way->book(1, WAY_STAT_CONVOIS);
+		next_way->wear_way(settings.get_citycar_way_wear_factor());
+		if(  flow_car.tiles_since_toll++ > tiles_per_km  ) {
+			flow_car.tiles_since_toll -= tiles_per_km;
+			player_t *player = next_way->get_owner();
+			if(  player  &&  player->get_player_nr() != 1  ) {
+				player->book_toll_received(settings.get_private_car_toll_per_km(), road_wt);
+			}
+		}
+		weg_t::add_travel_time_update(next_way, (uint32)(tile_yards / speed), (1u << YARDS_PER_TILE_SHIFT) / speed);
+
+		if(  koord_distance(pos.get_2d(), flow_car.target) < 10  ) {
+			// arrived, like private_car_t::enter_tile
+			return false;
+		}
+	}
+	flow_car.yards = (uint32)yards;
+	return true;
+}
+
+
+void road_user_flow_t::step(uint32 delta_t)
+{
+	if(  flows.empty()  ) {
+		return;
+	}
+	if(  !is_active()  ) {
+		release_all();
+		return;
+	}
+
+	karte_t *welt = world();
+	vector_tpl<moved_car_t> moved_cars;
+	tile_load.clear();
+
+	for(  uint32 i = flows.get_count();  i-- > 0;  ) {
+		tile_flow_t &flow = flows[i];
+
+		grund_t *gr = welt->lookup(flow.pos);
+		weg_t *way = gr ? gr->get_weg(road_wt) : NULL;
+		if(  !way  ) {
+			// no road anymore: the road users vanish like on the map
+			remove_flow(i);
+			continue;
+		}
+		if(  !is_off_screen(flow.pos)  ) {
+			release(flow);
+			remove_flow(i);
+			continue;
+		}
+
+		for(  uint32 j = 0;  j < flow.cars.get_count();  ) {
+			car_t &flow_car = flow.cars[j];
+			flow_car.time_to_life -= delta_t;
+			koord3d pos = flow.pos;
+			if(  flow_car.time_to_life <= 0  ||  !drive(flow_car, pos, delta_t)  ) {
+				flow.cars.remove_at(j, false);
+				continue;
+			}
+			if(  pos != flow.pos  ) {
+				// added to the flow of its new tile below, so it does not drive twice
+				moved_car_t moved;
+				moved.pos = pos;
+				moved.car = flow_car;
+				moved_cars.append(moved);
+				flow.cars.remove_at(j, false);
+				continue;
+			}
+			j++;
+		}
+		for(  uint32 j = 0;  j < flow.pedestrians.get_count();  ) {
+			walker_t &walker = flow.pedestrians[j];
+			walker.time_to_life -= delta_t;
+			if(  walker.time_to_life <= 0  ) {
+				flow.pedestrians.remove_at(j, false);
+				continue;
+			}
+			j++;
+		}
+
+		if(  flow.cars.empty()  &&  flow.pedestrians.empty()  ) {
+			remove_flow(i);
+		}
+	}
+
+	FOR(vector_tpl<moved_car_t>, const &moved, moved_cars) {
+		get_flow(moved.pos).cars.append(moved.car);
+	}
+}
+
+
+void road_user_flow_t::release_all()
+{
+	FOR(vector_tpl<tile_flow_t>, &flow, flows) {
+		release(flow);
+	}
+	clear();
+}
+
+
+void road_user_flow_t::clear()
+{
+	flows.clear();
+	flow_index.clear();
+	tile_load.clear();
+}
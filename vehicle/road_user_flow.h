@@ -0,0 +1,120 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef VEHICLE_ROAD_USER_FLOW_H
+#define VEHICLE_ROAD_USER_FLOW_H
+
+
+#include "../simtypes.h"
+#include "../dataobj/koord.h"
+#include "../dataobj/koord3d.h"
+#include "../tpl/vector_tpl.h"
+#include "../tpl/inthashtable_tpl.h"
+
+class citycar_desc_t;
+class pedestrian_desc_t;
+class private_car_t;
+class pedestrian_t;
+
+
+/**
+ * Level of detail for private cars and pedestrians in single player games.
+ *
+ * Road users far from the viewport are taken off the map and only kept as a
+ * flow on the road tile where they are. The flow ages them and moves the cars
+ * along their private car routes tile by tile, booking the traffic, the wear
+ * and the tolls of each road they pass. The more cars of the flows pass a tile,
+ * the slower they get and the more congested the road becomes, and the other
+ * way round. Cars without a route stay where they are. When a tile comes into
+ * view again, its road users are put back on the map.
+ */
+class road_user_flow_t
+{
+	struct car_t
+	{
+		const citycar_desc_t *desc;
+		koord origin;
+		koord target;
+		sint32 time_to_life;
+		/// distance driven on the current tile (yards)
+		uint32 yards;
+		/// tiles passed since the last toll
+		uint8 tiles_since_toll;
+	};
+
+	/// a car which drove on to another tile in this step
+	struct moved_car_t
+	{
+		koord3d pos;
+		car_t car;
+	};
+
+	struct walker_t
+	{
+		const pedestrian_desc_t *desc;
+		sint32 time_to_life;
+	};
+
+	struct tile_flow_t
+	{
+		koord3d pos;
+		vector_tpl<car_t> cars;
+		vector_tpl<walker_t> pedestrians;
+	};
+
+	static vector_tpl<tile_flow_t> flows;
+
+	/// index into flows by the packed position
+	static inthashtable_tpl<uint64, uint32, N_BAGS_LARGE> flow_index;
+
+	/// number of cars of the flows which entered a tile in the current step, by the packed position
+	static inthashtable_tpl<uint64, uint32, N_BAGS_LARGE> tile_load;
+
+	static uint64 get_key(const koord3d &pos);
+
+	/// the flow at this position, created if needed
+	static tile_flow_t &get_flow(const koord3d &pos);
+
+	static void remove_flow(uint32 index);
+
+	/// puts the road users of this flow back on the map
+	static void release(tile_flow_t &flow);
+
+	/// true, if this position is far enough from the viewport to drop the details
+	static bool is_off_screen(const koord3d &pos);
+
+	/**
+	 * Drives a car of a flow along its route and books each road it enters, like
+	 * private_car_t::hop does on the map.
+	 * @param pos the tile of the car, changed to the tile where it stops
+	 * @return false if the car reached its destination and vanishes
+	 */
+	static bool drive(car_t &flow_car, koord3d &pos, uint32 delta_t);
+
+public:
+	/// true, if road users far from the viewport are kept as flows now
+	static bool is_active();
+
+	/**
+	 * Takes a road user far from the viewport into the flow of its tile.
+	 * @return true if it was taken; it has to be deleted then
+	 */
+	static bool absorb(const private_car_t *car);
+	static bool absorb(const pedestrian_t *ped);
+
+	/**
+	 * Ages the flows and books their use of the roads. The road users of tiles
+	 * which came into view are put back on the map.
+	 */
+	static void step(uint32 delta_t);
+
+	/// puts all road users back on the map, e.g. before saving the game
+	static void release_all();
+
+	/// forgets all flows, when the map is destroyed
+	static void clear();
+};
+
+#endif
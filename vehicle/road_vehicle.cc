@@ -193,6 +193,24 @@ bool road_vehicle_t::check_next_tile(const grund_t *bd) const
 
 
 
+bool road_vehicle_t::get_route_profile(route_profile_t &profile) const
+{
+	if(  is_checker  ||  !get_route_profile_common(profile)  ) {
+		return false;
+	}
+	if(  target_halt.is_bound()  &&  cnv->is_waiting()  ) {
+		// check_next_tile() depends on the signs ending the choose area then
+		return false;
+	}
+	profile.min_speed = kmh_to_speed(get_desc()->get_topspeed());
+
+	// unlike rail vehicles, only the constraints of this vehicle count (see check_next_tile())
+	profile.way_permissive = desc->get_way_constraints().get_permissive();
+	profile.way_prohibitive = desc->get_way_constraints().get_prohibitive();
+	return true;
+}
+
+
 // how expensive to go here (for way search)
 int road_vehicle_t::get_cost(const grund_t *gr, const sint32 max_speed, koord from_pos)
 {
@@ -50,6 +50,11 @@ public:
 	// how expensive to go here (for way search)
 	int get_cost(const grund_t *, const sint32, koord) OVERRIDE;
 
+	// full speed on a diagonal way
+	uint32 get_min_cost() const OVERRIDE { return desc->get_override_way_speed() ? 0 : 7; }
+
+	bool get_route_profile(route_profile_t &profile) const OVERRIDE;
+
 	virtual route_t::route_result_t calc_route(koord3d start, koord3d ziel, sint32 max_speed, bool is_tall, route_t* route) OVERRIDE;
 
 	bool can_enter_tile(const grund_t *gr_next, sint32 &restart_speed, uint8 second_check_count) OVERRIDE;
@@ -18,6 +18,7 @@
 
 #include "simroadtraffic.h"
 #include "pedestrian.h"
+#include "road_user_flow.h"
 
 #include "../dataobj/translator.h"
 #include "../dataobj/loadsave.h"
@@ -469,6 +470,11 @@ private_car_t::private_car_t(grund_t* gr, koord const target) :
 
 sync_result private_car_t::sync_step(uint32 delta_t)
 {
+	if(  road_user_flow_t::absorb(this)  ) {
+		// far from the viewport: drives on as part of the flow of this road
+		return SYNC_DELETE;
+	}
+
 	bool slow_destruction = false;
 	if (time_to_life > 0 && time_to_life - delta_t < 10000 && target != koord::invalid)
 	{
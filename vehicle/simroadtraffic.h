@@ -91,6 +91,8 @@ public:
 
 class private_car_t : public road_user_t, public overtaker_t, public traffic_vehicle_t
 {
+	friend class road_user_flow_t;
+
 private:
 
 	koord origin;
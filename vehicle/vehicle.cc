@@ -2970,6 +2970,45 @@ bool vehicle_t::check_way_constraints(const weg_t &way) const
 	return missing_way_constraints_t(desc->get_way_constraints(), way.get_way_constraints()).check_next_tile();
 }
 
+bool vehicle_t::get_route_profile_common(route_profile_t &profile) const
+{
+	if(  cnv == NULL  ||  (desc->get_engine_type() == vehicle_desc_t::MAX_TRACTION_TYPE  &&  desc->get_topspeed() == 8888)  ) {
+		// not a convoy or a wayobj checker
+		return false;
+	}
+
+	const bool enforce_weight_limits = welt->get_settings().get_enforce_weight_limits() != 0;
+	profile.min_speed = 0;
+	profile.axle_load = enforce_weight_limits ? cnv->get_highest_axle_load() : 0;
+	profile.weight = enforce_weight_limits ? cnv->get_weight_summary().weight / 1000 : 0;
+	profile.owner_nr = get_owner_nr();
+	profile.waytype = desc->get_waytype();
+	profile.needs_electrification = cnv->needs_electrification();
+	profile.override_way_speed = desc->get_override_way_speed();
+	profile.speed_limited = speed_limit < INT_MAX;
+
+	// see check_access()
+	profile.access_owner_nr = route_profile_t::any_owner;
+	if(  get_owner()  &&  !get_owner()->is_public_service()  ) {
+		const grund_t* const gr = welt->lookup(get_pos());
+		const weg_t* const current_way = gr ? gr->get_weg(get_waytype()) : nullptr;
+		if(  current_way  ) {
+			profile.access_owner_nr = current_way->get_owner() ? (uint8)current_way->get_owner_nr() : (uint8)route_profile_t::no_owner;
+		}
+	}
+
+	// a way must satisfy the constraints of every vehicle
+	profile.way_permissive = 0;
+	profile.way_prohibitive = 0xFF;
+	for(  uint8 i = 0;  i < cnv->get_vehicle_count();  i++  ) {
+		const way_constraints_of_vehicle_t &constraints = cnv->get_vehicle(i)->get_desc()->get_way_constraints();
+		profile.way_permissive |= constraints.get_permissive();
+		profile.way_prohibitive &= constraints.get_prohibitive();
+	}
+	return true;
+}
+
+
 bool vehicle_t::check_access(const weg_t* way) const
 {
 	if(get_owner() && get_owner()->is_public_service())
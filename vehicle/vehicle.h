@@ -388,6 +388,14 @@ public:
 
 	bool check_way_constraints(const weg_t &way) const;
 
+protected:
+	/**
+	 * Fill in the parts of the route profile common to road and rail vehicles.
+	 * @returns false if the routes of this vehicle must not be shared.
+	 */
+	bool get_route_profile_common(route_profile_t &profile) const;
+
+public:
 	uint8 hop_count;
 
 //public: